@@ -32,6 +32,7 @@
 #include "BookManipulation/CleanSource.h"
 #include "BookManipulation/FolderKeeper.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "Misc/TempFolder.h"
 #include "Misc/Utility.h"
 #include "Misc/HTMLSpellCheck.h"
@@ -359,6 +360,7 @@ SVGResource &Book::CreateEmptySVGFile()
 
 HTMLResource &Book::CreateSectionBreakOriginalResource(const QString &content, HTMLResource &originating_resource)
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     const QString originating_filename = originating_resource.Filename();
     int reading_order = GetOPF().GetReadingOrder(originating_resource);
     Q_ASSERT(reading_order >= 0);
@@ -395,6 +397,7 @@ HTMLResource &Book::CreateSectionBreakOriginalResource(const QString &content, H
 
 void Book::CreateNewSections(const QStringList &new_sections, HTMLResource &original_resource)
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     int original_position = GetOPF().GetReadingOrder(original_resource);
     Q_ASSERT(original_position >= 0);
     QString new_file_prefix = QFileInfo(original_resource.Filename()).baseName();
@@ -512,6 +515,7 @@ Resource *Book::PreviousResource(Resource *resource)
 
 QHash < QString, QList< XhtmlDoc::XMLElement > > Book::GetLinkElements()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash< QString, QList< XhtmlDoc::XMLElement > > links_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< boost::tuple<QString, QList< XhtmlDoc::XMLElement > > > future = QtConcurrent::mapped(html_resources, GetLinkElementsInHTMLFileMapped);
@@ -536,6 +540,7 @@ tuple<QString, QList< XhtmlDoc::XMLElement > > Book::GetLinkElementsInHTMLFileMa
 
 QStringList Book::GetStyleUrlsInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QStringList images_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< boost::tuple<QString, QStringList> > future = QtConcurrent::mapped(html_resources, GetStyleUrlsInHTMLFileMapped);
@@ -559,6 +564,7 @@ tuple<QString, QStringList> Book::GetStyleUrlsInHTMLFileMapped(HTMLResource *htm
 
 QHash<QString, QStringList> Book::GetIdsInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> ids_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< boost::tuple<QString, QStringList> > future = QtConcurrent::mapped(html_resources, GetIdsInHTMLFileMapped);
@@ -612,6 +618,7 @@ QStringList Book::GetIdsInHrefs()
 
 QHash<QString, QStringList> Book::GetHrefsInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> hrefs_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< boost::tuple<QString, QStringList> > future = QtConcurrent::mapped(html_resources, GetHrefsInHTMLFileMapped);
@@ -635,6 +642,7 @@ tuple<QString, QStringList> Book::GetHrefsInHTMLFileMapped(HTMLResource *html_re
 
 QHash<QString, QStringList> Book::GetClassesInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> classes_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
 
@@ -671,6 +679,7 @@ QStringList Book::GetClassesInHTMLFile(QString filename)
 
 QHash<QString, QStringList> Book::GetImagesInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> media_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< tuple<QString, QStringList> > future = QtConcurrent::mapped(html_resources, GetImagesInHTMLFileMapped);
@@ -687,6 +696,7 @@ QHash<QString, QStringList> Book::GetImagesInHTMLFiles()
 
 QHash<QString, QStringList> Book::GetVideoInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> media_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< tuple<QString, QStringList> > future = QtConcurrent::mapped(html_resources, GetVideoInHTMLFileMapped);
@@ -703,6 +713,7 @@ QHash<QString, QStringList> Book::GetVideoInHTMLFiles()
 
 QHash<QString, QStringList> Book::GetAudioInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> media_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< tuple<QString, QStringList> > future = QtConcurrent::mapped(html_resources, GetAudioInHTMLFileMapped);
@@ -719,6 +730,7 @@ QHash<QString, QStringList> Book::GetAudioInHTMLFiles()
 
 QHash<QString, QStringList> Book::GetHTMLFilesUsingMedia()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> html_files;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
 
@@ -738,6 +750,7 @@ QHash<QString, QStringList> Book::GetHTMLFilesUsingMedia()
 
 QHash<QString, QStringList> Book::GetHTMLFilesUsingImages()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> html_files;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
 
@@ -795,6 +808,7 @@ QList<HTMLResource *> Book::GetNonWellFormedHTMLFiles()
 
 QSet<QString> Book::GetWordsInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QStringList all_words;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture<QStringList> future = QtConcurrent::mapped(html_resources, GetWordsInHTMLFileMapped);
@@ -814,6 +828,7 @@ QStringList Book::GetWordsInHTMLFileMapped(HTMLResource *html_resource)
 
 QHash<QString, int> Book::GetUniqueWordsInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, int> all_words;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture<QStringList> future = QtConcurrent::mapped(html_resources, GetWordsInHTMLFileMapped);
@@ -835,6 +850,7 @@ QHash<QString, int> Book::GetUniqueWordsInHTMLFiles()
 
 QHash<QString, QStringList> Book::GetStylesheetsInHTMLFiles()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QHash<QString, QStringList> links_in_html;
     const QList<HTMLResource *> html_resources = m_Mainfolder.GetResourceTypeList< HTMLResource >(false);
     QFuture< boost::tuple<QString, QStringList> > future = QtConcurrent::mapped(html_resources, GetStylesheetsInHTMLFileMapped);
@@ -862,6 +878,7 @@ QStringList Book::GetStylesheetsInHTMLFile(HTMLResource *html_resource)
 
 Resource *Book::MergeResources(QList<Resource *> resources)
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QProgressDialog progress(QObject::tr("Merging Files.."), 0, 0, resources.count(), QApplication::activeWindow());
     progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
     int progress_value = 0;
@@ -878,7 +895,7 @@ Resource *Book::MergeResources(QList<Resource *> resources)
         QWriteLocker sink_locker(&sink_html_resource.GetLock());
         shared_ptr<xc::DOMDocument> sink_d = XhtmlDoc::LoadTextIntoDocument(sink_html_resource.GetText());
         xc::DOMDocument &sink_dom        = *sink_d.get();
-        xc::DOMNodeList &sink_body_nodes = *sink_dom.getElementsByTagName(QtoX("body"));
+        xc::DOMNodeList &sink_body_nodes = *sink_dom.getElementsByTagName(xn::BODY);
         xc::DOMNode &sink_body_node      = *sink_body_nodes.item(0);
 
         if (sink_body_nodes.getLength() != 1) {
@@ -903,7 +920,7 @@ Resource *Book::MergeResources(QList<Resource *> resources)
             QWriteLocker source_locker(&source_html_resource.GetLock());
             shared_ptr<xc::DOMDocument> sd = XhtmlDoc::LoadTextIntoDocument(source_html_resource.GetText());
             const xc::DOMDocument &source_dom  = *sd.get();
-            xc::DOMNodeList &source_body_nodes = *source_dom.getElementsByTagName(QtoX("body"));
+            xc::DOMNodeList &source_body_nodes = *source_dom.getElementsByTagName(xn::BODY);
 
             if (source_body_nodes.getLength() != 1) {
                 failed_resource = source_resource;
@@ -946,6 +963,7 @@ QList <Resource * > Book::GetAllResources()
 
 void Book::SaveAllResourcesToDisk()
 {
+    m_Mainfolder.SyncTextsFromDocuments();
     QList< Resource * > resources = m_Mainfolder.GetResourceList();
     m_Mainfolder.SuspendWatchingResources();
     QtConcurrent::blockingMap(resources, SaveOneResourceToDisk);
@@ -975,6 +993,13 @@ bool Book::HasObfuscatedFonts() const
     return false;
 }
 
+
+ArchiveSnapshot &Book::GetLastSavedArchive()
+{
+    return m_LastSavedArchive;
+}
+
+
 void Book::ResourceUpdatedFromDisk(Resource &resource)
 {
     SetModified(true);
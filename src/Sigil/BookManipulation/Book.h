@@ -31,6 +31,7 @@
 #include <QtCore/QVariant>
 #include "BookManipulation/Metadata.h"
 #include "BookManipulation/XhtmlDoc.h"
+#include "Exporters/ArchiveSnapshot.h"
 #include "ResourceObjects/Resource.h"
 
 class CSSResource;
@@ -295,6 +296,14 @@ public:
 
     QList<HTMLResource *> GetHTMLResources();
 
+    /**
+     * Returns what we know about the last EPUB archive
+     * written for this book. Used to speed up saving.
+     *
+     * @return The snapshot of the last saved archive.
+     */
+    ArchiveSnapshot &GetLastSavedArchive();
+
 public slots:
 
     /**
@@ -404,6 +413,12 @@ private:
      */
     bool m_IsModified;
 
+    /**
+     * Describes the last EPUB archive written for this book.
+     * Empty until the book is saved for the first time.
+     */
+    ArchiveSnapshot m_LastSavedArchive;
+
 };
 
 #endif // BOOK_H
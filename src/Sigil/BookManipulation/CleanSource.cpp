@@ -612,7 +612,14 @@ void CleanSource::ReformatAll(QList <HTMLResource *> resources, QString(clean_fu
         progress.setValue(progress_value++);
         qApp->processEvents();
         QWriteLocker locker(&resource->GetLock());
-        resource->SetText(clean_func(resource->GetText()));
+        const QString text = resource->GetText();
+        const QString cleaned = clean_func(text);
+
+        // Files that aren't loaded stay on disk, and
+        // the ones the clean didn't touch are left alone.
+        if (cleaned != text) {
+            resource->StoreText(cleaned);
+        }
     }
 }
 
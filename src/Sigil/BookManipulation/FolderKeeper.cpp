@@ -25,6 +25,7 @@
 #include <QtCore/QString>
 #include <QtCore/QThread>
 #include <QtCore/QTime>
+#include <QtCore/QVector>
 #include <QtWidgets/QApplication>
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
@@ -35,6 +36,7 @@
 #include "ResourceObjects/AudioResource.h"
 #include "ResourceObjects/NCXResource.h"
 #include "ResourceObjects/Resource.h"
+#include "ResourceObjects/TextResource.h"
 #include "ResourceObjects/VideoResource.h"
 #include "Misc/Utility.h"
 #include "Misc/OpenExternally.h"
@@ -91,6 +93,7 @@ FolderKeeper::FolderKeeper(QObject *parent)
     QObject(parent),
     m_OPF(NULL),
     m_NCX(NULL),
+    m_ReadingOrderValid(false),
     m_FSWatcher(new QFileSystemWatcher()),
     m_FullPathToMainFolder(m_TempFolder.GetPath())
 {
@@ -118,13 +121,44 @@ FolderKeeper::~FolderKeeper()
     }
 }
 
-Resource &FolderKeeper::AddContentFileToFolder(const QString &fullfilepath, bool update_opf, const QString &mimetype)
+Resource &FolderKeeper::AddContentFileToFolder(const QString &fullfilepath, bool update_opf, const QString &mimetype, bool move_file)
 {
     if (!QFileInfo(fullfilepath).exists()) {
         boost_throw(FileDoesNotExist() << errinfo_file_name(fullfilepath.toStdString()));
     }
 
     QString new_file_path;
+    Resource *resource = CreateResourceForFile(fullfilepath, mimetype, new_file_path);
+
+    // Moving within the scratchpad is just a rename, but the file
+    // may live on another volume so fall back to copying it.
+    if (!move_file || !QFile::rename(fullfilepath, new_file_path)) {
+        QFile::copy(fullfilepath, new_file_path);
+    }
+
+    ConnectNewResource(resource, update_opf);
+    return *resource;
+}
+
+
+Resource &FolderKeeper::AddContentDataToFolder(const QString &fullfilepath, const QByteArray &data, bool update_opf, const QString &mimetype)
+{
+    QString new_file_path;
+    Resource *resource = CreateResourceForFile(fullfilepath, mimetype, new_file_path);
+    QFile file(new_file_path);
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(data);
+        file.close();
+    }
+
+    ConnectNewResource(resource, update_opf);
+    return *resource;
+}
+
+
+Resource *FolderKeeper::CreateResourceForFile(const QString &fullfilepath, const QString &mimetype, QString &new_file_path)
+{
     QString normalised_file_path = fullfilepath;
     Resource *resource = NULL;
     // Rename files that start with a '.'
@@ -139,56 +173,59 @@ Resource &FolderKeeper::AddContentFileToFolder(const QString &fullfilepath, bool
     // We need to lock here because otherwise
     // several threads can get the same "unique" name.
     // After we deal with the resource hash, other threads can continue.
-    {
-        QMutexLocker locker(&m_AccessMutex);
-        QString filename  = GetUniqueFilenameVersion(QFileInfo(normalised_file_path).fileName());
-        QString extension = QFileInfo(normalised_file_path).suffix().toLower();
-
-        if (fullfilepath.contains(FILE_EXCEPTIONS)) {
-            if (filename == "page-map.xml") {
-                new_file_path = m_FullPathToMiscFolder + "/" + filename;
-                resource = new MiscTextResource(m_FullPathToMainFolder, new_file_path);
-            } else {
-                // This is a big hack that assumes the new and old filepaths use root paths
-                // of the same length. I can't see how to fix this without refactoring
-                // a lot of the code to provide a more generalised interface.
-                new_file_path = m_FullPathToMainFolder % fullfilepath.right(fullfilepath.size() - m_FullPathToMainFolder.size());
-                resource = new Resource(m_FullPathToMainFolder, new_file_path);
-            }
-        } else if (MISC_TEXT_EXTENSIONS.contains(extension)) {
+    QMutexLocker locker(&m_AccessMutex);
+    QString filename  = GetUniqueFilenameVersion(QFileInfo(normalised_file_path).fileName());
+    QString extension = QFileInfo(normalised_file_path).suffix().toLower();
+
+    if (fullfilepath.contains(FILE_EXCEPTIONS)) {
+        if (filename == "page-map.xml") {
             new_file_path = m_FullPathToMiscFolder + "/" + filename;
             resource = new MiscTextResource(m_FullPathToMainFolder, new_file_path);
-        } else if (AUDIO_EXTENSIONS.contains(extension) || AUDIO_MIMETYPES.contains(mimetype)) {
-            new_file_path = m_FullPathToAudioFolder + "/" + filename;
-            resource = new AudioResource(m_FullPathToMainFolder, new_file_path);
-        } else if (VIDEO_EXTENSIONS.contains(extension) || VIDEO_MIMETYPES.contains(mimetype)) {
-            new_file_path = m_FullPathToVideoFolder + "/" + filename;
-            resource = new VideoResource(m_FullPathToMainFolder, new_file_path);
-        } else if (IMAGE_EXTENSIONS.contains(extension) || IMAGE_MIMEYPES.contains(mimetype)) {
-            new_file_path = m_FullPathToImagesFolder + "/" + filename;
-            resource = new ImageResource(m_FullPathToMainFolder, new_file_path);
-        } else if (SVG_EXTENSIONS.contains(extension) || SVG_MIMETYPES.contains(mimetype)) {
-            new_file_path = m_FullPathToImagesFolder + "/" + filename;
-            resource = new SVGResource(m_FullPathToMainFolder, new_file_path);
-        } else if (FONT_EXTENSIONS.contains(extension)) {
-            new_file_path = m_FullPathToFontsFolder + "/" + filename;
-            resource = new FontResource(m_FullPathToMainFolder, new_file_path);
-        } else if (TEXT_EXTENSIONS.contains(extension) || TEXT_MIMETYPES.contains(mimetype)) {
-            new_file_path = m_FullPathToTextFolder + "/" + filename;
-            resource = new HTMLResource(m_FullPathToMainFolder, new_file_path, m_Resources);
-        } else if (STYLE_EXTENSIONS.contains(extension) || STYLE_MIMETYPES.contains(mimetype)) {
-            new_file_path = m_FullPathToStylesFolder + "/" + filename;
-            resource = new CSSResource(m_FullPathToMainFolder, new_file_path);
         } else {
-            // Fallback mechanism
-            new_file_path = m_FullPathToMiscFolder + "/" + filename;
+            // This is a big hack that assumes the new and old filepaths use root paths
+            // of the same length. I can't see how to fix this without refactoring
+            // a lot of the code to provide a more generalised interface.
+            new_file_path = m_FullPathToMainFolder % fullfilepath.right(fullfilepath.size() - m_FullPathToMainFolder.size());
             resource = new Resource(m_FullPathToMainFolder, new_file_path);
         }
-
-        m_Resources[ resource->GetIdentifier() ] = resource;
+    } else if (MISC_TEXT_EXTENSIONS.contains(extension)) {
+        new_file_path = m_FullPathToMiscFolder + "/" + filename;
+        resource = new MiscTextResource(m_FullPathToMainFolder, new_file_path);
+    } else if (AUDIO_EXTENSIONS.contains(extension) || AUDIO_MIMETYPES.contains(mimetype)) {
+        new_file_path = m_FullPathToAudioFolder + "/" + filename;
+        resource = new AudioResource(m_FullPathToMainFolder, new_file_path);
+    } else if (VIDEO_EXTENSIONS.contains(extension) || VIDEO_MIMETYPES.contains(mimetype)) {
+        new_file_path = m_FullPathToVideoFolder + "/" + filename;
+        resource = new VideoResource(m_FullPathToMainFolder, new_file_path);
+    } else if (IMAGE_EXTENSIONS.contains(extension) || IMAGE_MIMEYPES.contains(mimetype)) {
+        new_file_path = m_FullPathToImagesFolder + "/" + filename;
+        resource = new ImageResource(m_FullPathToMainFolder, new_file_path);
+    } else if (SVG_EXTENSIONS.contains(extension) || SVG_MIMETYPES.contains(mimetype)) {
+        new_file_path = m_FullPathToImagesFolder + "/" + filename;
+        resource = new SVGResource(m_FullPathToMainFolder, new_file_path);
+    } else if (FONT_EXTENSIONS.contains(extension)) {
+        new_file_path = m_FullPathToFontsFolder + "/" + filename;
+        resource = new FontResource(m_FullPathToMainFolder, new_file_path);
+    } else if (TEXT_EXTENSIONS.contains(extension) || TEXT_MIMETYPES.contains(mimetype)) {
+        new_file_path = m_FullPathToTextFolder + "/" + filename;
+        resource = new HTMLResource(m_FullPathToMainFolder, new_file_path, m_Resources);
+    } else if (STYLE_EXTENSIONS.contains(extension) || STYLE_MIMETYPES.contains(mimetype)) {
+        new_file_path = m_FullPathToStylesFolder + "/" + filename;
+        resource = new CSSResource(m_FullPathToMainFolder, new_file_path);
+    } else {
+        // Fallback mechanism
+        new_file_path = m_FullPathToMiscFolder + "/" + filename;
+        resource = new Resource(m_FullPathToMainFolder, new_file_path);
     }
-    QFile::copy(fullfilepath, new_file_path);
 
+    m_Resources[ resource->GetIdentifier() ] = resource;
+    AddToIndexes(resource);
+    return resource;
+}
+
+
+void FolderKeeper::ConnectNewResource(Resource *resource, bool update_opf)
+{
     if (QThread::currentThread() != QApplication::instance()->thread()) {
         resource->moveToThread(QApplication::instance()->thread());
     }
@@ -201,31 +238,54 @@ Resource &FolderKeeper::AddContentFileToFolder(const QString &fullfilepath, bool
     if (update_opf) {
         emit ResourceAdded(*resource);
     }
+}
+
+
+void FolderKeeper::AddToIndexes(Resource *resource)
+{
+    m_ResourcesByFilename[ resource->Filename() ] = resource;
+    m_ResourcesByFullPath[ resource->GetFullPath() ] = resource;
+    m_ResourcesByType[ resource->Type() ].append(resource);
+
+    if (resource->Type() == Resource::HTMLResourceType) {
+        QMutexLocker locker(&m_ReadingOrderMutex);
+        m_ReadingOrderValid = false;
+    }
+}
 
-    return *resource;
+
+void FolderKeeper::RemoveFromIndexes(const Resource &resource)
+{
+    Resource *indexed_resource = const_cast< Resource * >(&resource);
+    m_ResourcesByFilename.remove(resource.Filename());
+    m_ResourcesByFullPath.remove(resource.GetFullPath());
+    m_ResourcesByType[ resource.Type() ].removeOne(indexed_resource);
+
+    if (m_ResourcesByType[ resource.Type() ].isEmpty()) {
+        m_ResourcesByType.remove(resource.Type());
+    }
+
+    if (resource.Type() == Resource::HTMLResourceType) {
+        QMutexLocker locker(&m_ReadingOrderMutex);
+        m_ReadingOrderValid = false;
+    }
 }
 
 
 int FolderKeeper::GetHighestReadingOrder() const
 {
-    int count_of_html_resources = 0;
-    foreach(Resource * resource, m_Resources.values()) {
-        if (resource->Type() == Resource::HTMLResourceType) {
-            ++count_of_html_resources;
-        }
-    }
-    return count_of_html_resources - 1;
+    return m_ResourcesByType.value(Resource::HTMLResourceType).count() - 1;
 }
 
 
 QString FolderKeeper::GetUniqueFilenameVersion(const QString &filename) const
 {
-    const QStringList &filenames = GetAllFilenames();
-
-    if (!filenames.contains(filename)) {
+    if (!m_ResourcesByFilename.contains(filename)) {
         return filename;
     }
 
+    const QStringList &filenames = GetAllFilenames();
+
     // name_prefix is part of the name without the number suffix.
     // So for "Section0001.xhtml", it is "Section"
     QString name_prefix = QFileInfo(filename).baseName().remove(QRegularExpression("\\d+$"));
@@ -285,13 +345,7 @@ QList< Resource * > FolderKeeper::GetResourceList() const
 
 QList< Resource * > FolderKeeper::GetResourceListByType(Resource::ResourceType type) const
 {
-    QList <Resource *> resources;
-    foreach (Resource *resource, m_Resources.values()) {
-        if (resource->Type() == type) {
-            resources.append(resource);
-        }
-    }
-    return resources;
+    return m_ResourcesByType.value(type);
 }
 
 Resource &FolderKeeper::GetResourceByIdentifier(const QString &identifier) const
@@ -302,12 +356,97 @@ Resource &FolderKeeper::GetResourceByIdentifier(const QString &identifier) const
 
 Resource &FolderKeeper::GetResourceByFilename(const QString &filename) const
 {
-    foreach(Resource * resource, m_Resources.values()) {
-        if (resource->Filename() == filename) {
-            return *resource;
+    Resource *resource = m_ResourcesByFilename.value(filename);
+
+    if (!resource) {
+        boost_throw(ResourceDoesNotExist() << errinfo_resource_name(filename.toStdString()));
+    }
+
+    return *resource;
+}
+
+
+QList< HTMLResource * > FolderKeeper::GetHTMLResourcesInReadingOrder() const
+{
+    const QStringList &spine_order_filenames = GetOPF().GetSpineOrderFilenames();
+    QMutexLocker locker(&m_ReadingOrderMutex);
+
+    // The OPF hands out the same shared list until its text
+    // changes, so comparing the spines is usually instant.
+    if (!m_ReadingOrderValid || m_ReadingOrderSpine != spine_order_filenames) {
+        QList< HTMLResource * > html_resources;
+        foreach(Resource * resource, m_ResourcesByType.value(Resource::HTMLResourceType)) {
+            html_resources.append(qobject_cast< HTMLResource * >(resource));
+        }
+        m_ReadingOrder = SortInReadingOrder(html_resources, spine_order_filenames);
+        m_ReadingOrderSpine = spine_order_filenames;
+        m_ReadingOrderValid = true;
+    }
+
+    return m_ReadingOrder;
+}
+
+
+QList< HTMLResource * > FolderKeeper::SortInReadingOrder(const QList< HTMLResource * > &resource_list,
+                                                         const QStringList &spine_order_filenames)
+{
+    QHash< QString, int > spine_positions;
+
+    for (int i = 0; i < spine_order_filenames.count(); ++i) {
+        if (!spine_positions.contains(spine_order_filenames.at(i))) {
+            spine_positions[ spine_order_filenames.at(i) ] = i;
         }
     }
-    boost_throw(ResourceDoesNotExist() << errinfo_resource_name(filename.toStdString()));
+
+    QVector< HTMLResource * > spine_htmls(spine_order_filenames.count(), NULL);
+    QList< HTMLResource * > other_htmls;
+    foreach(HTMLResource * html_resource, resource_list) {
+        QHash< QString, int >::const_iterator position = spine_positions.constFind(html_resource->Filename());
+
+        if (position != spine_positions.constEnd() && !spine_htmls.at(position.value())) {
+            spine_htmls[ position.value() ] = html_resource;
+        } else {
+            other_htmls.append(html_resource);
+        }
+    }
+    QList< HTMLResource * > sorted_htmls;
+    foreach(HTMLResource * html_resource, spine_htmls) {
+        if (html_resource) {
+            sorted_htmls.append(html_resource);
+        }
+    }
+    // It's possible that there are certain HTML files in the
+    // given resource list that are not in the spine filenames,
+    // for several reasons. So we make sure we add them to the end
+    // of the sorted list.
+    sorted_htmls.append(other_htmls);
+    return sorted_htmls;
+}
+
+
+QList< Resource * > FolderKeeper::GetResourcesReferencing(const QStringList &full_paths)
+{
+    return m_ReferenceIndex.GetReferencingResources(GetResourceList(), full_paths);
+}
+
+
+QList< Resource * > FolderKeeper::GetResourcesPossiblyMatching(const QString &search_regex,
+                                                               const QList< Resource * > &resources)
+{
+    return m_SearchIndex.GetCandidateResources(resources, search_regex);
+}
+
+
+void FolderKeeper::SyncTextsFromDocuments()
+{
+    // The documents may only be read from the GUI thread.
+    if (QThread::currentThread() != QApplication::instance()->thread()) {
+        return;
+    }
+
+    foreach(TextResource * text_resource, GetResourceTypeList< TextResource >()) {
+        text_resource->SyncTextFromDocument();
+    }
 }
 
 
@@ -359,17 +498,16 @@ QString FolderKeeper::GetFullPathToVideoFolder() const
 
 QStringList FolderKeeper::GetAllFilenames() const
 {
-    QStringList filelist;
-    foreach(Resource * resource, m_Resources.values()) {
-        filelist.append(resource->Filename());
-    }
-    return filelist;
+    return m_ResourcesByFilename.keys();
 }
 
 
 void FolderKeeper::RemoveResource(const Resource &resource)
 {
     m_Resources.remove(resource.GetIdentifier());
+    RemoveFromIndexes(resource);
+    m_ReferenceIndex.RemoveResource(resource);
+    m_SearchIndex.RemoveResource(resource);
 
     if (m_FSWatcher->files().contains(resource.GetFullPath())) {
         m_FSWatcher->removePath(resource.GetFullPath());
@@ -381,6 +519,25 @@ void FolderKeeper::RemoveResource(const Resource &resource)
 
 void FolderKeeper::ResourceRenamed(const Resource &resource, const QString &old_full_path)
 {
+    Resource *renamed_resource = const_cast< Resource * >(&resource);
+    const QString &old_filename = QFileInfo(old_full_path).fileName();
+
+    if (m_ResourcesByFilename.value(old_filename) == renamed_resource) {
+        m_ResourcesByFilename.remove(old_filename);
+    }
+
+    if (m_ResourcesByFullPath.value(old_full_path) == renamed_resource) {
+        m_ResourcesByFullPath.remove(old_full_path);
+    }
+
+    m_ResourcesByFilename[ resource.Filename() ] = renamed_resource;
+    m_ResourcesByFullPath[ resource.GetFullPath() ] = renamed_resource;
+
+    if (resource.Type() == Resource::HTMLResourceType) {
+        QMutexLocker locker(&m_ReadingOrderMutex);
+        m_ReadingOrderValid = false;
+    }
+
     m_OPF->ResourceRenamed(resource, old_full_path);
 }
 
@@ -403,11 +560,10 @@ void FolderKeeper::ResourceFileChanged(const QString &path) const
             m_FSWatcher->addPath(path);
         }
 
-        foreach(Resource * resource, m_Resources.values()) {
-            if (resource->GetFullPath() == path) {
-                resource->FileChangedOnDisk();
-                return;
-            }
+        Resource *resource = m_ResourcesByFullPath.value(path);
+
+        if (resource) {
+            resource->FileChangedOnDisk();
         }
     }
 }
@@ -485,6 +641,8 @@ void FolderKeeper::CreateInfrastructureFiles()
     m_NCX->SetMainID(m_OPF->GetMainIdentifierValue());
     m_Resources[ m_OPF->GetIdentifier() ] = m_OPF;
     m_Resources[ m_NCX->GetIdentifier() ] = m_NCX;
+    AddToIndexes(m_OPF);
+    AddToIndexes(m_NCX);
     // TODO: change from Resource* to const Resource&
     connect(m_OPF, SIGNAL(Deleted(const Resource &)), this, SLOT(RemoveResource(const Resource &)));
     connect(m_NCX, SIGNAL(Deleted(const Resource &)), this, SLOT(RemoveResource(const Resource &)));
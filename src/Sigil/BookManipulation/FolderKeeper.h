@@ -23,6 +23,7 @@
 #ifndef FOLDERKEEPER_H
 #define FOLDERKEEPER_H
 
+#include <QtCore/QByteArray>
 #include <QtCore/QObject>
 #include <QtCore/QString>
 #include <QtCore/QHash>
@@ -40,6 +41,8 @@
 #include "ResourceObjects/SVGResource.h"
 #include "ResourceObjects/OPFResource.h"
 
+#include "BookManipulation/ReferenceIndex.h"
+#include "BookManipulation/SearchIndex.h"
 #include "Misc/TempFolder.h"
 
 class NCXResource;
@@ -81,9 +84,32 @@ public:
      *                   that a file was added. This will add entries in the
      *                   OPF manifest and potentially the spine as well.
      * @param mimetype The mimetype for the associated file.
+     * @param move_file If set to \c true, the file is moved into the book folder
+     *                  instead of being copied. Use this for files that sit in
+     *                  a temporary location and are not needed there afterwards.
      * @return The newly created resource.
      */
     Resource &AddContentFileToFolder(const QString &fullfilepath,
+                                     bool update_opf = true,
+                                     const QString &mimetype = QString(),
+                                     bool move_file = false);
+
+    /**
+     * Adds a content file to the book folder whose contents are already
+     * held in memory and returns the corresponding Resource object.
+     * The path does not have to exist on disk, it is only used to
+     * name the resource and recognize its type. The data is written
+     * once, directly to the resource's location in the book folder.
+     *
+     * @param fullfilepath The full path the file would have.
+     * @param data The contents of the file.
+     * @param update_opf If set to \c true, then the OPF will be notified
+     *                   that a file was added.
+     * @param mimetype The mimetype for the associated file.
+     * @return The newly created resource.
+     */
+    Resource &AddContentDataToFolder(const QString &fullfilepath,
+                                     const QByteArray &data,
                                      bool update_opf = true,
                                      const QString &mimetype = QString());
 
@@ -156,9 +182,7 @@ public:
     /**
      * Returns the resource with the given filename.
      * @note NOTE THAT RESOURCE FILENAMES CAN CHANGE,
-     *       while identifiers don't. Also, retrieving
-     *       resources by identifier is O(1), this is O(n)
-     *       (and a \b very slow O(n) since we query the filesystem).
+     *       while identifiers don't.
      * @throws ResourceDoesNotExist if the filename is not found.
      *
      * @param filename The filename to search for.
@@ -166,6 +190,35 @@ public:
      */
     Resource &GetResourceByFilename(const QString &filename) const;
 
+    /**
+     * Returns the HTML and CSS resources that may reference any of the files.
+     * Path updates for the files only need to go through these resources.
+     *
+     * @param full_paths The full paths of the referenced files.
+     * @return The referencing resources.
+     */
+    QList< Resource * > GetResourcesReferencing(const QStringList &full_paths);
+
+    /**
+     * Returns the resources that may contain a match of the regex.
+     * A search only needs to go through these resources.
+     *
+     * @param search_regex The regex that will be searched for.
+     * @param resources The resources to search.
+     * @return The resources to search, in the given order.
+     */
+    QList< Resource * > GetResourcesPossiblyMatching(const QString &search_regex,
+                                                     const QList< Resource * > &resources);
+
+    /**
+     * Copies the text of every open Code View document into its
+     * resource. Worker threads only see the text of a resource as of
+     * its last sync, so this has to be called on the GUI thread before
+     * work on the resources is handed out to them. Does nothing when
+     * called from any other thread.
+     */
+    void SyncTextsFromDocuments();
+
     /**
      * Returns the book's OPF file.
      *
@@ -279,6 +332,70 @@ private:
      */
     void CreateInfrastructureFiles();
 
+    /**
+     * Creates the resource object for a file that is being added
+     * and registers it in m_Resources.
+     *
+     * @param fullfilepath The full path to the file being added.
+     * @param mimetype The mimetype for the associated file.
+     * @param new_file_path Set to the path the file needs to be stored at.
+     * @return The newly created resource.
+     */
+    Resource *CreateResourceForFile(const QString &fullfilepath,
+                                    const QString &mimetype,
+                                    QString &new_file_path);
+
+    /**
+     * Finishes adding a resource once its file is in place.
+     *
+     * @param resource The newly created resource.
+     * @param update_opf If set to \c true, ResourceAdded is emitted.
+     */
+    void ConnectNewResource(Resource *resource, bool update_opf);
+
+    /**
+     * Adds the resource to the secondary indexes of m_Resources.
+     *
+     * @param resource The resource to add.
+     */
+    void AddToIndexes(Resource *resource);
+
+    /**
+     * Removes the resource from the secondary indexes of m_Resources.
+     *
+     * @param resource The resource to remove.
+     */
+    void RemoveFromIndexes(const Resource &resource);
+
+    /**
+     * Returns all the resources of class T, including
+     * those of classes inheriting from T.
+     *
+     * @return The resource list.
+     */
+    template< class T >
+    QList< Resource * > GetResourcesOfClass() const;
+
+    /**
+     * Returns the HTML resources sorted in reading order.
+     * The sorted list is cached until HTML resources are added,
+     * removed or renamed, or the spine of the OPF changes.
+     *
+     * @return The sorted HTML resources.
+     */
+    QList< HTMLResource * > GetHTMLResourcesInReadingOrder() const;
+
+    /**
+     * Sorts HTML resources in the order of the spine. Files that
+     * are not in the spine are put at the end, in the same order.
+     *
+     * @param resource_list The HTML resources to sort.
+     * @param spine_order_filenames The filenames of the spine items.
+     * @return The sorted HTML resources.
+     */
+    static QList< HTMLResource * > SortInReadingOrder(const QList< HTMLResource * > &resource_list,
+                                                      const QStringList &spine_order_filenames);
+
     /**
      * Dereferences two pointers and compares the values with "<".
      *
@@ -316,11 +433,52 @@ private:
      */
     QHash< QString, Resource * > m_Resources;
 
+    /**
+     * The resources in m_Resources keyed by their filename,
+     * which is unique within a book.
+     */
+    QHash< QString, Resource * > m_ResourcesByFilename;
+
+    /**
+     * The resources in m_Resources keyed by their full path.
+     */
+    QHash< QString, Resource * > m_ResourcesByFullPath;
+
+    /**
+     * The resources in m_Resources grouped by their ResourceType,
+     * in the order they were added.
+     */
+    QHash< int, QList< Resource * > > m_ResourcesByType;
+
+    /**
+     * The cached result of GetHTMLResourcesInReadingOrder(),
+     * valid if m_ReadingOrderValid is set and the spine still
+     * lists m_ReadingOrderSpine.
+     */
+    mutable QList< HTMLResource * > m_ReadingOrder;
+    mutable QStringList m_ReadingOrderSpine;
+    mutable bool m_ReadingOrderValid;
+
+    /**
+     * Guards the cached reading order.
+     */
+    mutable QMutex m_ReadingOrderMutex;
+
     /**
      * Ensures thread-safe access to the m_Resources hash.
      */
     QMutex m_AccessMutex;
 
+    /**
+     * Knows which resources reference which files.
+     */
+    ReferenceIndex m_ReferenceIndex;
+
+    /**
+     * Knows which resources may match a search.
+     */
+    SearchIndex m_SearchIndex;
+
     /**
      * The main temp folder where files are stored.
      */
@@ -351,12 +509,8 @@ template< class T >
 QList< T * > FolderKeeper::GetResourceTypeList(bool should_be_sorted) const
 {
     QList< T * > onetype_resources;
-    foreach(Resource * resource, m_Resources.values()) {
-        T *type_resource = qobject_cast< T * >(resource);
-
-        if (type_resource) {
-            onetype_resources.append(type_resource);
-        }
+    foreach(Resource * resource, GetResourcesOfClass< T >()) {
+        onetype_resources.append(static_cast< T * >(resource));
     }
 
     if (should_be_sorted) {
@@ -366,17 +520,26 @@ QList< T * > FolderKeeper::GetResourceTypeList(bool should_be_sorted) const
     return onetype_resources;
 }
 
-template< class T >
-QList< Resource * > FolderKeeper::GetResourceTypeAsGenericList(bool should_be_sorted) const
+
+// The reading order is cached, so it's not sorted here.
+template<> inline
+QList< HTMLResource * > FolderKeeper::GetResourceTypeList< HTMLResource >(bool should_be_sorted) const
 {
-    QList< Resource * > resources;
-    foreach(Resource * resource, m_Resources.values()) {
-        T *type_resource = qobject_cast< T * >(resource);
+    if (should_be_sorted) {
+        return GetHTMLResourcesInReadingOrder();
+    }
 
-        if (type_resource) {
-            resources.append(resource);
-        }
+    QList< HTMLResource * > html_resources;
+    foreach(Resource * resource, GetResourcesOfClass< HTMLResource >()) {
+        html_resources.append(static_cast< HTMLResource * >(resource));
     }
+    return html_resources;
+}
+
+template< class T >
+QList< Resource * > FolderKeeper::GetResourceTypeAsGenericList(bool should_be_sorted) const
+{
+    QList< Resource * > resources = GetResourcesOfClass< T >();
 
     if (should_be_sorted) {
         resources = ListResourceSort(resources);
@@ -386,6 +549,21 @@ QList< Resource * > FolderKeeper::GetResourceTypeAsGenericList(bool should_be_so
 }
 
 
+template< class T >
+QList< Resource * > FolderKeeper::GetResourcesOfClass() const
+{
+    // All the resources of one type are of the same class,
+    // so checking the first one of each type is enough.
+    QList< Resource * > resources;
+    foreach(const QList< Resource * > &type_resources, m_ResourcesByType) {
+        if (!type_resources.isEmpty() && qobject_cast< T * >(type_resources.first())) {
+            resources.append(type_resources);
+        }
+    }
+    return resources;
+}
+
+
 template< typename T > inline
 QList< T * > FolderKeeper::ListResourceSort(const QList< T * > &resource_list)  const
 {
@@ -400,23 +578,7 @@ QList< T * > FolderKeeper::ListResourceSort(const QList< T * > &resource_list)
 template<> inline
 QList< HTMLResource * > FolderKeeper::ListResourceSort< HTMLResource >(const QList< HTMLResource * > &resource_list) const
 {
-    QStringList spine_order_filenames = GetOPF().GetSpineOrderFilenames();
-    QList< HTMLResource * > htmls = resource_list;
-    QList< HTMLResource * > sorted_htmls;
-    foreach(const QString & spine_filename, spine_order_filenames) {
-        for (int i = 0; i < htmls.count(); ++i) {
-            if (spine_filename == htmls[ i ]->Filename()) {
-                sorted_htmls.append(htmls.takeAt(i));
-                break;
-            }
-        }
-    }
-    // It's possible that there are certain HTML files in the
-    // given resource list that are not in the spine filenames,
-    // for several reasons. So we make sure we add them to the end
-    // of the sorted list.
-    sorted_htmls.append(htmls);
-    return sorted_htmls;
+    return SortInReadingOrder(resource_list, GetOPF().GetSpineOrderFilenames());
 }
 
 
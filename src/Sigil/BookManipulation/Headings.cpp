@@ -29,6 +29,7 @@
 
 #include "BookManipulation/Headings.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/Utility.h"
 #include "ResourceObjects/HTMLResource.h"
@@ -96,8 +97,8 @@ QList< Headings::Heading > Headings::GetHeadingListForOneFile(HTMLResource *html
         heading.resource_file  = html_resource;
         heading.document       = d;
         heading.element        = &element;
-        heading.title          = element.hasAttribute(QtoX("title"))
-                                 ? XtoQ(element.getAttribute(QtoX("title"))).simplified()
+        heading.title          = element.hasAttribute(xn::TITLE)
+                                 ? XtoQ(element.getAttribute(xn::TITLE)).simplified()
                                  : QString();
         heading.orig_title     = heading.title;
         heading.text           = !heading.title.isNull() ?
@@ -105,7 +106,7 @@ QList< Headings::Heading > Headings::GetHeadingListForOneFile(HTMLResource *html
                                  XtoQ(element.getTextContent()).simplified();
         heading.level          = QString(XtoQ(element.getTagName()).at(1)).toInt();
         heading.orig_level     = heading.level;
-        QString classes        = XtoQ(element.getAttribute(QtoX("class")));
+        QString classes        = XtoQ(element.getAttribute(xn::CLASS));
         heading.include_in_toc = !(classes.contains(SIGIL_NOT_IN_TOC_CLASS) ||
                                    classes.contains(OLD_SIGIL_NOT_IN_TOC_CLASS));
         heading.at_file_start  =
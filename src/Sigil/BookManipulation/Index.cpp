@@ -30,6 +30,7 @@
 
 #include "ResourceObjects/HTMLResource.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "MiscEditors/IndexEditorModel.h"
 #include "BookManipulation/Index.h"
@@ -82,11 +83,11 @@ void Index::AddIndexIDsOneFile(HTMLResource *html_resource)
         text_node_text.replace(QChar(160), " ");
 
         // Remove existing index ids
-        if (element.hasAttribute(QtoX("id"))) {
-            index_id_value = XtoQ(element.getAttribute(QtoX("id")));
+        if (element.hasAttribute(xn::ID)) {
+            index_id_value = XtoQ(element.getAttribute(xn::ID));
 
             if (index_id_value.startsWith(SIGIL_INDEX_ID_PREFIX)) {
-                element.removeAttribute(QtoX("id"));
+                element.removeAttribute(xn::ID);
                 resource_updated = true;
             }
         }
@@ -95,14 +96,14 @@ void Index::AddIndexIDsOneFile(HTMLResource *html_resource)
         bool is_custom_index_entry = false;
         QString custom_index_value = text_node_text;
 
-        if (element.hasAttribute(QtoX("class"))) {
-            QString class_names = XtoQ(element.getAttribute(QtoX("class")));
+        if (element.hasAttribute(xn::CLASS)) {
+            QString class_names = XtoQ(element.getAttribute(xn::CLASS));
 
             if (class_names.split(" ").contains(SIGIL_INDEX_CLASS)) {
                 is_custom_index_entry = true;
 
-                if (element.hasAttribute(QtoX("title"))) {
-                    QString title = XtoQ(element.getAttribute(QtoX("title")));
+                if (element.hasAttribute(xn::TITLE)) {
+                    QString title = XtoQ(element.getAttribute(xn::TITLE));
 
                     if (!title.isEmpty()) {
                         custom_index_value = title;
@@ -112,13 +113,13 @@ void Index::AddIndexIDsOneFile(HTMLResource *html_resource)
         }
 
         // Use the existing id if there is one, else add one if node contains index item
-        if (element.hasAttribute(QtoX("id"))) {
+        if (element.hasAttribute(xn::ID)) {
             CreateIndexEntry(text_node_text, html_resource, index_id_value, is_custom_index_entry, custom_index_value);
         } else {
             index_id_value = SIGIL_INDEX_ID_PREFIX + QString::number(index_id_number);
 
             if (CreateIndexEntry(text_node_text, html_resource, index_id_value, is_custom_index_entry, custom_index_value)) {
-                element.setAttribute(QtoX("id"), QtoX(index_id_value));
+                element.setAttribute(xn::ID, QtoX(index_id_value));
                 resource_updated = true;
                 index_id_number++;
             }
@@ -26,6 +26,7 @@
 
 #include "BookManipulation/Metadata.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/Utility.h"
 #include "Misc/Language.h"
@@ -115,10 +116,10 @@ Metadata::MetaElement Metadata::MapToBookMetadata(const xc::DOMElement &element)
     QString element_name = XhtmlDoc::GetNodeName(element);
 
     if (element_name == "meta") {
-        meta.name  = XtoQ(element.getAttribute(QtoX("name")));
-        meta.value = XtoQ(element.getAttribute(QtoX("content")));
-        meta.attributes[ "scheme" ] = XtoQ(element.getAttribute(QtoX("scheme")));
-        meta.attributes[ "id" ] = XtoQ(element.getAttribute(QtoX("id")));
+        meta.name  = XtoQ(element.getAttribute(xn::NAME));
+        meta.value = XtoQ(element.getAttribute(xn::CONTENT));
+        meta.attributes[ "scheme" ] = XtoQ(element.getAttribute(xn::SCHEME));
+        meta.attributes[ "id" ] = XtoQ(element.getAttribute(xn::ID));
 
         if ((!meta.name.isEmpty()) && (!meta.value.toString().isEmpty())) {
             return MapToBookMetadata(meta , false);
@@ -0,0 +1,254 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QtConcurrent/QtConcurrent>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QReadLocker>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+
+#include "BookManipulation/ReferenceIndex.h"
+#include "Misc/Utility.h"
+#include "ResourceObjects/TextResource.h"
+
+// Characters that can't be part of a file name in markup or CSS.
+// '#', ';' and '&' are missing since they also make up references,
+// which have to be resolved before the words are split further.
+static inline bool IsWordDelimiter(QChar c)
+{
+    switch (c.unicode()) {
+        case ' ': case '\t': case '\n': case '\r':
+        case '"': case '\'': case '(': case ')':
+        case '<': case '>':  case '=': case ',':
+        case '{': case '}':  case '[': case ']':
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+// Characters that separate file names from the rest of a path or URL.
+static inline bool IsNameDelimiter(QChar c)
+{
+    switch (c.unicode()) {
+        case '/': case '\\': case '#': case '?': case ';':
+            return true;
+        default:
+            return IsWordDelimiter(c);
+    }
+}
+
+
+// Resolves the character references and the percent-encoding in a word,
+// so that names are compared the way path updates compare them.
+static QString DecodeWord(const QString &word)
+{
+    QString decoded = word;
+
+    if (decoded.contains(QChar('&'))) {
+        decoded.replace("&amp;", "&").replace("&lt;", "<").replace("&gt;", ">")
+               .replace("&quot;", "\"").replace("&apos;", "'");
+        QRegularExpression character_reference("&#(x[0-9a-fA-F]+|[0-9]+);");
+        QRegularExpressionMatch match = character_reference.match(decoded);
+
+        while (match.hasMatch()) {
+            const QString &number = match.captured(1);
+            uint code_point = number.startsWith('x') ? number.mid(1).toUInt(0, 16) : number.toUInt();
+            const QString &character = QString::fromUcs4(&code_point, 1);
+            decoded.replace(match.capturedStart(), match.capturedLength(), character);
+            match = character_reference.match(decoded, match.capturedStart() + character.length());
+        }
+    }
+
+    if (decoded.contains(QChar('%'))) {
+        decoded = Utility::URLDecodePath(decoded);
+    }
+
+    return decoded;
+}
+
+
+// The key a file name is indexed under: its last part
+// that can't be split by any of the name delimiters.
+static QString NameKey(const QString &file_name)
+{
+    int end = file_name.length();
+
+    while (end > 0 && IsNameDelimiter(file_name.at(end - 1))) {
+        --end;
+    }
+
+    int start = end;
+
+    while (start > 0 && !IsNameDelimiter(file_name.at(start - 1))) {
+        --start;
+    }
+
+    return file_name.mid(start, end - start);
+}
+
+
+QList< Resource * > ReferenceIndex::GetReferencingResources(const QList< Resource * > &resources,
+                                                            const QStringList &full_paths)
+{
+    QMutexLocker locker(&m_AccessMutex);
+    Refresh(resources);
+    QSet< Resource * > referrers;
+    foreach(QString full_path, full_paths) {
+        const QString &key = NameKey(QFileInfo(full_path).fileName());
+
+        // Only words that look like file names are indexed.
+        // Anything could reference files without an extension.
+        if (!key.contains(QChar('.'))) {
+            return m_Entries.keys();
+        }
+
+        referrers.unite(m_Referrers.value(key));
+    }
+    return referrers.toList();
+}
+
+
+void ReferenceIndex::RemoveResource(const Resource &resource)
+{
+    QMutexLocker locker(&m_AccessMutex);
+    Resource *key = const_cast< Resource * >(&resource);
+
+    if (m_Entries.contains(key)) {
+        RemoveReferences(key, m_Entries.value(key).names);
+        m_Entries.remove(key);
+    }
+}
+
+
+void ReferenceIndex::Refresh(const QList< Resource * > &resources)
+{
+    QList< Resource * > stale_resources;
+    foreach(Resource * resource, resources) {
+        if (resource->Type() != Resource::HTMLResourceType &&
+            resource->Type() != Resource::CSSResourceType) {
+            continue;
+        }
+
+        QHash< Resource *, Entry >::const_iterator entry = m_Entries.constFind(resource);
+
+        if (entry == m_Entries.constEnd() || entry->version != resource->GetVersion()) {
+            // The worker threads mustn't read the documents of the tabs,
+            // and the entry mustn't record the new version with old text.
+            qobject_cast< TextResource * >(resource)->SyncTextFromDocument();
+            stale_resources.append(resource);
+        }
+    }
+
+    if (stale_resources.isEmpty()) {
+        return;
+    }
+
+    const QList< Entry > &entries = QtConcurrent::blockingMapped< QList< Entry > >(stale_resources, CreateEntry);
+
+    for (int i = 0; i < stale_resources.count(); ++i) {
+        Resource *resource = stale_resources.at(i);
+
+        if (m_Entries.contains(resource)) {
+            RemoveReferences(resource, m_Entries.value(resource).names);
+        }
+
+        const Entry &entry = entries.at(i);
+        foreach(QString name, entry.names) {
+            m_Referrers[ name ].insert(resource);
+        }
+        m_Entries[ resource ] = entry;
+    }
+}
+
+
+ReferenceIndex::Entry ReferenceIndex::CreateEntry(Resource *resource)
+{
+    Entry entry;
+    // The version is read before the text. If the text changes
+    // in between, the newer version makes us scan it again.
+    entry.version = resource->GetVersion();
+    TextResource *text_resource = qobject_cast< TextResource * >(resource);
+    QReadLocker locker(&resource->GetLock());
+    entry.names = GetFileNames(text_resource->GetText());
+    return entry;
+}
+
+
+QSet< QString > ReferenceIndex::GetFileNames(const QString &text)
+{
+    QSet< QString > names;
+    int length = text.length();
+    int word_start = 0;
+
+    for (int i = 0; i <= length; ++i) {
+        if (i < length && !IsWordDelimiter(text.at(i))) {
+            continue;
+        }
+
+        if (i - word_start > 1) {
+            const QString &word = text.mid(word_start, i - word_start);
+
+            if (word.contains(QChar('.'))) {
+                const QString &decoded = DecodeWord(word);
+                int name_start = 0;
+
+                for (int j = 0; j <= decoded.length(); ++j) {
+                    if (j < decoded.length() && !IsNameDelimiter(decoded.at(j))) {
+                        continue;
+                    }
+
+                    const QString &name = decoded.mid(name_start, j - name_start);
+
+                    if (name.contains(QChar('.'))) {
+                        names.insert(name);
+                    }
+
+                    name_start = j + 1;
+                }
+            }
+        }
+
+        word_start = i + 1;
+    }
+
+    return names;
+}
+
+
+void ReferenceIndex::RemoveReferences(Resource *resource, const QSet< QString > &names)
+{
+    foreach(QString name, names) {
+        QHash< QString, QSet< Resource * > >::iterator referrers = m_Referrers.find(name);
+
+        if (referrers == m_Referrers.end()) {
+            continue;
+        }
+
+        referrers->remove(resource);
+
+        if (referrers->isEmpty()) {
+            m_Referrers.erase(referrers);
+        }
+    }
+}
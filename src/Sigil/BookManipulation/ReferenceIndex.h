@@ -0,0 +1,118 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef REFERENCEINDEX_H
+#define REFERENCEINDEX_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+class Resource;
+
+/**
+ * A reverse index of the references between the resources of a book.
+ * For every file name, it knows the HTML and CSS resources that
+ * mention it in their text, be it in an href, a src, a url()
+ * or an @import.
+ *
+ * The index errs on the side of caution: a resource that mentions
+ * a file name anywhere is counted as referencing every file with
+ * that name. That's all path updates need to know which resources
+ * they have to go through.
+ *
+ * Entries are kept up to date lazily. The version of every resource
+ * is recorded with its entry, and only the resources modified since
+ * then are scanned again when the index is queried.
+ */
+class ReferenceIndex
+{
+
+public:
+
+    /**
+     * Returns the resources that may reference any of the files.
+     *
+     * @param resources All the resources of the book.
+     * @param full_paths The full paths of the referenced files.
+     * @return The HTML and CSS resources referencing the files.
+     */
+    QList< Resource * > GetReferencingResources(const QList< Resource * > &resources,
+                                                const QStringList &full_paths);
+
+    /**
+     * Forgets everything about a resource that is being removed.
+     */
+    void RemoveResource(const Resource &resource);
+
+private:
+
+    struct Entry {
+        int version;
+        QSet< QString > names;
+    };
+
+    /**
+     * Scans the resources that changed since they were indexed.
+     *
+     * @warning m_AccessMutex must be locked when calling this.
+     */
+    void Refresh(const QList< Resource * > &resources);
+
+    /**
+     * Reads the text of a resource and collects the file names in it.
+     */
+    static Entry CreateEntry(Resource *resource);
+
+    /**
+     * Returns all the words in the text that look like a file name.
+     */
+    static QSet< QString > GetFileNames(const QString &text);
+
+    /**
+     * Removes the references of the resource from m_Referrers.
+     */
+    void RemoveReferences(Resource *resource, const QSet< QString > &names);
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    /**
+     * The indexed resources and what they reference.
+     */
+    QHash< Resource *, Entry > m_Entries;
+
+    /**
+     * The keys are file names, the values are
+     * the resources that reference them.
+     */
+    QHash< QString, QSet< Resource * > > m_Referrers;
+
+    QMutex m_AccessMutex;
+};
+
+#endif // REFERENCEINDEX_H
@@ -0,0 +1,513 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QtConcurrent/QtConcurrent>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QReadLocker>
+
+#include "BookManipulation/SearchIndex.h"
+#include "ResourceObjects/TextResource.h"
+
+// The bitmaps get about four bits for every character of text,
+// so that few of the trigrams missing from a file hit a set bit.
+static const int BITS_PER_CHARACTER = 4;
+static const int MIN_BITMAP_SIZE    = 1 << 10;
+static const int MAX_BITMAP_SIZE    = 1 << 21;
+
+// Literals shorter than a trigram can't be looked up.
+static const int TRIGRAM_LENGTH = 3;
+
+
+static inline ushort Fold(QChar c)
+{
+    return c.toCaseFolded().unicode();
+}
+
+
+static inline uint TrigramHash(ushort first, ushort second, ushort third)
+{
+    uint hash = (first * 0x9E3779B1u) ^ (second * 0x85EBCA77u) ^ (third * 0xC2B2AE3Du);
+    return hash ^ (hash >> 15);
+}
+
+
+static int BitmapSize(int text_length)
+{
+    int size = MIN_BITMAP_SIZE;
+
+    while (size < MAX_BITMAP_SIZE && size / BITS_PER_CHARACTER < text_length) {
+        size <<= 1;
+    }
+
+    return size;
+}
+
+
+// Returns true if the regex sets the extended option anywhere.
+// Whitespace and comments in the pattern are then no longer literal.
+static bool SetsExtendedOption(const QString &regex)
+{
+    int start = regex.indexOf("(?");
+
+    while (start != -1) {
+        for (int i = start + 2; i < regex.length(); ++i) {
+            QChar c = regex.at(i);
+
+            if (c == QChar('x')) {
+                return true;
+            }
+
+            if (!c.isLetter() && c != QChar('-') && c != QChar('^')) {
+                break;
+            }
+        }
+
+        start = regex.indexOf("(?", start + 2);
+    }
+
+    return false;
+}
+
+
+static inline bool IsHexDigit(QChar c)
+{
+    ushort u = c.unicode();
+    return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'f') || (u >= 'A' && u <= 'F');
+}
+
+
+// Returns the position after the closing character,
+// or the end of the regex if there is none.
+static int SkipPast(const QString &regex, int start, QChar closing)
+{
+    int end = regex.indexOf(closing, start);
+    return end == -1 ? regex.length() : end + 1;
+}
+
+
+// Returns the position after an escape that starts with a backslash
+// followed by an ASCII letter or digit. Whatever it matches, the
+// characters making it up must not be taken as literals.
+static int SkipEscape(const QString &regex, int start)
+{
+    int length = regex.length();
+    ushort kind = regex.at(start + 1).unicode();
+    int i = start + 2;
+    ushort next = i < length ? regex.at(i).unicode() : 0;
+
+    switch (kind) {
+        case 'c':
+            return qMin(i + 1, length);
+        case 'x':
+            if (next == '{') {
+                return SkipPast(regex, i, QChar('}'));
+            }
+
+            for (int end = qMin(i + 2, length); i < end && IsHexDigit(regex.at(i)); ++i) {
+            }
+
+            return i;
+        case 'o':
+        case 'N':
+            return next == '{' ? SkipPast(regex, i, QChar('}')) : i;
+        case 'p':
+        case 'P':
+            return next == '{' ? SkipPast(regex, i, QChar('}')) : qMin(i + 1, length);
+        case 'k':
+        case 'g':
+            if (next == '{') {
+                return SkipPast(regex, i, QChar('}'));
+            }
+
+            if (next == '<') {
+                return SkipPast(regex, i, QChar('>'));
+            }
+
+            if (next == '\'') {
+                return SkipPast(regex, i + 1, QChar('\''));
+            }
+
+            if (next == '+' || next == '-') {
+                ++i;
+            }
+
+            break;
+        default:
+            if (kind < '0' || kind > '9') {
+                return i;
+            }
+    }
+
+    // Back references and octal escapes.
+    while (i < length && regex.at(i).isDigit()) {
+        ++i;
+    }
+
+    return i;
+}
+
+
+// Returns the position after the closing bracket of the character class,
+// or -1 if the class can't be told apart from the rest of the regex.
+static int SkipClass(const QString &regex, int start)
+{
+    int length = regex.length();
+    int i = start + 1;
+
+    if (i < length && regex.at(i) == QChar('^')) {
+        ++i;
+    }
+
+    // A closing bracket right away is a member of the class.
+    if (i < length && regex.at(i) == QChar(']')) {
+        ++i;
+    }
+
+    while (i < length) {
+        QChar c = regex.at(i);
+
+        if (c == QChar('\\')) {
+            if (i + 1 < length && regex.at(i + 1) == QChar('Q')) {
+                return -1;
+            }
+
+            i += 2;
+        } else if (c == QChar('[') && i + 1 < length && regex.at(i + 1) == QChar(':')) {
+            int end = regex.indexOf(":]", i + 2);
+
+            if (end == -1) {
+                return -1;
+            }
+
+            i = end + 2;
+        } else if (c == QChar(']')) {
+            return i + 1;
+        } else {
+            ++i;
+        }
+    }
+
+    return -1;
+}
+
+
+// Returns the position after the closing parenthesis of the group,
+// or -1 if the group can't be told apart from the rest of the regex.
+static int SkipGroup(const QString &regex, int start)
+{
+    int length = regex.length();
+    int depth = 0;
+    int i = start;
+
+    while (i < length) {
+        QChar c = regex.at(i);
+
+        if (c == QChar('\\')) {
+            if (i + 1 < length && regex.at(i + 1) == QChar('Q')) {
+                return -1;
+            }
+
+            i += 2;
+        } else if (c == QChar('[')) {
+            i = SkipClass(regex, i);
+
+            if (i == -1) {
+                return -1;
+            }
+        } else if (c == QChar('(') && regex.midRef(i, 3) == QLatin1String("(?#")) {
+            // Comments can hold any character but the closing parenthesis.
+            int end = regex.indexOf(QChar(')'), i);
+
+            if (end == -1) {
+                return -1;
+            }
+
+            i = end + 1;
+
+            if (depth == 0) {
+                return i;
+            }
+        } else if (c == QChar('(')) {
+            ++depth;
+            ++i;
+        } else if (c == QChar(')')) {
+            ++i;
+
+            if (--depth == 0) {
+                return i;
+            }
+        } else {
+            ++i;
+        }
+    }
+
+    return -1;
+}
+
+
+// Returns the position after a {n}, {n,} or {n,m} quantifier.
+// Any other brace is a literal character, and is skipped on its own.
+static int SkipQuantifier(const QString &regex, int start)
+{
+    int length = regex.length();
+    int i = start + 1;
+    int digits_start = i;
+
+    while (i < length && regex.at(i).isDigit()) {
+        ++i;
+    }
+
+    if (i == digits_start) {
+        return start + 1;
+    }
+
+    if (i < length && regex.at(i) == QChar(',')) {
+        ++i;
+
+        while (i < length && regex.at(i).isDigit()) {
+            ++i;
+        }
+    }
+
+    return i < length && regex.at(i) == QChar('}') ? i + 1 : start + 1;
+}
+
+
+// Ends the run of literal characters being collected.
+static void AddLiteral(QStringList &literals, QString &run)
+{
+    if (run.length() >= TRIGRAM_LENGTH) {
+        literals.append(run);
+    }
+
+    run.clear();
+}
+
+
+QList< Resource * > SearchIndex::GetCandidateResources(const QList< Resource * > &resources,
+                                                       const QString &search_regex)
+{
+    const QStringList &literals = GetRequiredLiterals(search_regex);
+
+    if (literals.isEmpty()) {
+        return resources;
+    }
+
+    QMutexLocker locker(&m_AccessMutex);
+    Refresh(resources);
+    QList< Resource * > candidates;
+    foreach(Resource * resource, resources) {
+        QHash< Resource *, Entry >::const_iterator entry = m_Entries.constFind(resource);
+
+        if (entry == m_Entries.constEnd() || ContainsLiterals(entry->trigrams, literals)) {
+            candidates.append(resource);
+        }
+    }
+    return candidates;
+}
+
+
+void SearchIndex::RemoveResource(const Resource &resource)
+{
+    QMutexLocker locker(&m_AccessMutex);
+    m_Entries.remove(const_cast< Resource * >(&resource));
+}
+
+
+QStringList SearchIndex::GetRequiredLiterals(const QString &search_regex)
+{
+    if (SetsExtendedOption(search_regex)) {
+        return QStringList();
+    }
+
+    QStringList literals;
+    QString run;
+    int length = search_regex.length();
+    int i = 0;
+
+    // Only the parts of the regex outside of groups and classes are used.
+    // Every one of them has to match, unless it is followed by a quantifier
+    // that allows it to be left out.
+    while (i < length) {
+        QChar c = search_regex.at(i);
+
+        switch (c.unicode()) {
+            case '\\': {
+                if (i + 1 >= length) {
+                    return QStringList();
+                }
+
+                QChar next = search_regex.at(i + 1);
+
+                if (next == QChar('Q')) {
+                    int end = search_regex.indexOf("\\E", i + 2);
+
+                    if (end == -1) {
+                        end = length;
+                    }
+
+                    for (int j = i + 2; j < end; ++j) {
+                        run.append(QChar(Fold(search_regex.at(j))));
+                    }
+
+                    i = qMin(end + 2, length);
+                } else if (next.unicode() < 128 && next.isLetterOrNumber()) {
+                    AddLiteral(literals, run);
+                    i = SkipEscape(search_regex, i);
+                } else {
+                    run.append(QChar(Fold(next)));
+                    i += 2;
+                }
+
+                break;
+            }
+            case '[':
+                AddLiteral(literals, run);
+                i = SkipClass(search_regex, i);
+
+                if (i == -1) {
+                    return QStringList();
+                }
+
+                break;
+            case '(':
+                AddLiteral(literals, run);
+                i = SkipGroup(search_regex, i);
+
+                if (i == -1) {
+                    return QStringList();
+                }
+
+                break;
+            case ')':
+            case '|':
+                // Either side of an alternation can match on its own.
+                return QStringList();
+            case '.':
+            case '^':
+            case '$':
+            case '+':
+                AddLiteral(literals, run);
+                ++i;
+                break;
+            case '?':
+            case '*':
+                run.chop(1);
+                AddLiteral(literals, run);
+                ++i;
+                break;
+            case '{':
+                run.chop(1);
+                AddLiteral(literals, run);
+                i = SkipQuantifier(search_regex, i);
+                break;
+            default:
+                run.append(QChar(Fold(c)));
+                ++i;
+        }
+    }
+
+    AddLiteral(literals, run);
+    return literals;
+}
+
+
+void SearchIndex::Refresh(const QList< Resource * > &resources)
+{
+    QList< Resource * > stale_resources;
+    foreach(Resource * resource, resources) {
+        TextResource *text_resource = qobject_cast< TextResource * >(resource);
+
+        if (!text_resource) {
+            continue;
+        }
+
+        QHash< Resource *, Entry >::const_iterator entry = m_Entries.constFind(resource);
+
+        if (entry == m_Entries.constEnd() || entry->version != resource->GetVersion()) {
+            // The worker threads mustn't read the documents of the tabs.
+            text_resource->SyncTextFromDocument();
+            stale_resources.append(resource);
+        }
+    }
+
+    if (stale_resources.isEmpty()) {
+        return;
+    }
+
+    const QList< Entry > &entries = QtConcurrent::blockingMapped< QList< Entry > >(stale_resources, CreateEntry);
+
+    for (int i = 0; i < stale_resources.count(); ++i) {
+        m_Entries[ stale_resources.at(i) ] = entries.at(i);
+    }
+}
+
+
+SearchIndex::Entry SearchIndex::CreateEntry(Resource *resource)
+{
+    Entry entry;
+    // The version is read before the text. If the text changes
+    // in between, the newer version makes us index it again.
+    entry.version = resource->GetVersion();
+    TextResource *text_resource = qobject_cast< TextResource * >(resource);
+    QReadLocker locker(&resource->GetLock());
+    const QString &text = text_resource->GetText();
+    locker.unlock();
+    int length = text.length();
+    int size = BitmapSize(length);
+    entry.trigrams = QBitArray(size);
+
+    if (length < TRIGRAM_LENGTH) {
+        return entry;
+    }
+
+    const QChar *data = text.constData();
+    uint mask = size - 1;
+    ushort first = Fold(data[ 0 ]);
+    ushort second = Fold(data[ 1 ]);
+
+    for (int i = 2; i < length; ++i) {
+        ushort third = Fold(data[ i ]);
+        entry.trigrams.setBit(TrigramHash(first, second, third) & mask);
+        first = second;
+        second = third;
+    }
+
+    return entry;
+}
+
+
+bool SearchIndex::ContainsLiterals(const QBitArray &trigrams, const QStringList &literals)
+{
+    uint mask = trigrams.size() - 1;
+    foreach(QString literal, literals) {
+        const QChar *data = literal.constData();
+
+        for (int i = 2; i < literal.length(); ++i) {
+            uint hash = TrigramHash(data[ i - 2 ].unicode(), data[ i - 1 ].unicode(), data[ i ].unicode());
+
+            if (!trigrams.testBit(hash & mask)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
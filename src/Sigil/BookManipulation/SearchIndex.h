@@ -0,0 +1,121 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QtCore/QBitArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+class Resource;
+
+/**
+ * An index of the trigrams in the text resources of a book,
+ * used to rule out the files a search can't match in.
+ *
+ * The literals every match of a regex must contain are taken
+ * from the regex itself, and only the files holding all of their
+ * trigrams need to be searched. The trigrams are case folded,
+ * so that case insensitive searches can use the index too.
+ *
+ * Every file's trigrams are hashed into a bitmap, so the index
+ * can only tell which files may match, never which files do.
+ * A regex without any literal that is long enough, or one the
+ * index can't make sense of, matches all the files.
+ *
+ * Entries are kept up to date lazily. The version of every resource
+ * is recorded with its entry, and only the resources modified since
+ * then are indexed again when the index is queried.
+ */
+class SearchIndex
+{
+
+public:
+
+    /**
+     * Returns the resources that may contain a match of the regex.
+     * Resources that aren't text resources are always returned.
+     *
+     * @warning Must be called from the GUI thread, since the texts
+     *          being edited in tabs are read from their documents.
+     *
+     * @param resources The resources to search.
+     * @param search_regex The regex that will be searched for.
+     * @return The resources that have to be searched, in the given order.
+     */
+    QList< Resource * > GetCandidateResources(const QList< Resource * > &resources,
+                                              const QString &search_regex);
+
+    /**
+     * Forgets everything about a resource that is being removed.
+     */
+    void RemoveResource(const Resource &resource);
+
+    /**
+     * Returns case folded strings that any match of the regex
+     * has to contain. Returns an empty list for regexes that
+     * are too complex to be sure about.
+     */
+    static QStringList GetRequiredLiterals(const QString &search_regex);
+
+private:
+
+    struct Entry {
+        int version;
+        QBitArray trigrams;
+    };
+
+    /**
+     * Indexes the resources that changed since they were indexed.
+     *
+     * @warning m_AccessMutex must be locked when calling this.
+     */
+    void Refresh(const QList< Resource * > &resources);
+
+    /**
+     * Reads the text of a resource and collects its trigrams.
+     */
+    static Entry CreateEntry(Resource *resource);
+
+    /**
+     * Returns \c true if the bitmap may hold all the trigrams of the literals.
+     */
+    static bool ContainsLiterals(const QBitArray &trigrams, const QStringList &literals);
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    /**
+     * The indexed resources and their trigrams.
+     */
+    QHash< Resource *, Entry > m_Entries;
+
+    QMutex m_AccessMutex;
+};
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,1158 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <cstring>
+
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSet>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+
+#include "BookManipulation/WellFormedChecker.h"
+#include "sigil_constants.h"
+
+namespace FlightCrew
+{
+extern const char *NCX_2005_1_DTD_ID;
+};
+
+namespace fc = FlightCrew;
+
+// The entities declared by the XHTML entities DTD.
+struct XhtmlEntityTable {
+    // Entities that stand for a single character
+    QSet< QString > character_entities;
+
+    // Entities with any other replacement text
+    QSet< QString > other_entities;
+};
+
+
+namespace
+{
+
+// Each 64 bit word holds four UTF-16 code units, one per 16 bit lane.
+const quint64 LANE_ONES     = 0x0001000100010001ULL;
+const quint64 LANE_HIGHS    = 0x8000800080008000ULL;
+const quint64 LANE_NO_ASCII = 0xFF80FF80FF80FF80ULL;
+
+QMutex s_EntityTableMutex;
+
+
+// Returns a word with the high bit set in every
+// lane equal to value. The lanes must all be ASCII.
+inline quint64 LanesEqualTo(quint64 word, ushort value)
+{
+    quint64 difference = word ^ (LANE_ONES * value);
+    return (difference - LANE_ONES) & ~difference & LANE_HIGHS;
+}
+
+
+// True when the four code units are printable ASCII
+// that can't start markup or the "]]>" sequence.
+inline bool IsPlainText(quint64 word)
+{
+    if (word & LANE_NO_ASCII) {
+        return false;
+    }
+
+    quint64 below_space = (word - LANE_ONES * 0x20) & ~word & LANE_HIGHS;
+    return !(below_space |
+             LanesEqualTo(word, '<') |
+             LanesEqualTo(word, '&') |
+             LanesEqualTo(word, ']'));
+}
+
+
+inline bool IsWhitespace(ushort c)
+{
+    return c == 0x20 || c == 0x9 || c == 0xA || c == 0xD;
+}
+
+
+inline bool IsAsciiNameStart(ushort c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':';
+}
+
+
+inline bool IsAsciiNameChar(ushort c)
+{
+    return IsAsciiNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+}
+
+
+inline bool IsXmlChar(quint32 c)
+{
+    return c == 0x9 || c == 0xA || c == 0xD ||
+           (c >= 0x20    && c <= 0xD7FF) ||
+           (c >= 0xE000  && c <= 0xFFFD) ||
+           (c >= 0x10000 && c <= 0x10FFFF);
+}
+
+
+bool IsPubidChar(ushort c)
+{
+    return c == 0x20 || c == 0xD || c == 0xA ||
+           (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           (c != 0 && c < 0x80 && std::strchr("-'()+,./:=?;!*#@$_%", static_cast< char >(c)) != 0);
+}
+
+
+bool IsEncodingName(const QString &name)
+{
+    QRegularExpression encoding_name("^[A-Za-z][A-Za-z0-9._-]*$");
+    return encoding_name.match(name).hasMatch();
+}
+
+
+bool IsPredefinedEntity(const QString &name)
+{
+    return name == "lt" || name == "gt" || name == "amp" || name == "quot" || name == "apos";
+}
+
+
+XhtmlEntityTable *CreateXhtmlEntityTable()
+{
+    XhtmlEntityTable *table = new XhtmlEntityTable();
+    QString dtd = QString::fromUtf8(reinterpret_cast< const char * >(XHTML_ENTITIES_DTD), XHTML_ENTITIES_DTD_LEN);
+    QRegularExpression entity_declaration("<!ENTITY\\s+([^%\\s]\\S*)\\s+(?:\"([^\"]*)\"|'([^']*)')?");
+    QRegularExpression character_reference("^&#(?:[0-9]+|x[0-9A-Fa-f]+);$");
+    QRegularExpressionMatchIterator declarations = entity_declaration.globalMatch(dtd);
+
+    while (declarations.hasNext()) {
+        QRegularExpressionMatch declaration = declarations.next();
+        QString name = declaration.captured(1);
+        QString value = declaration.capturedStart(2) != -1 ? declaration.captured(2) : declaration.captured(3);
+
+        // The first declaration of an entity is the one that counts.
+        if (table->character_entities.contains(name) || table->other_entities.contains(name)) {
+            continue;
+        }
+
+        if (character_reference.match(value).hasMatch()) {
+            table->character_entities.insert(name);
+        } else {
+            table->other_entities.insert(name);
+        }
+    }
+
+    return table;
+}
+
+
+// The table is parsed from the DTD the first time it's needed
+// and then kept for the lifetime of the application.
+const XhtmlEntityTable &GetXhtmlEntityTable()
+{
+    QMutexLocker locker(&s_EntityTableMutex);
+    static XhtmlEntityTable *table = NULL;
+
+    if (!table) {
+        table = CreateXhtmlEntityTable();
+    }
+
+    return *table;
+}
+
+}
+
+
+WellFormedChecker::Result WellFormedChecker::Check(const QString &source, XhtmlDoc::WellFormedError &error)
+{
+    WellFormedChecker checker(source);
+    Result result = checker.Run();
+
+    if (result != NotWellFormed) {
+        return result;
+    }
+
+    // Line and column are only needed for the error,
+    // so they are counted here instead of while scanning.
+    int line = 1;
+    const ushort *line_start = checker.m_Begin;
+
+    for (const ushort *position = checker.m_Begin; position < checker.m_ErrorPosition; ++position) {
+        if (*position == '\n' ||
+            (*position == '\r' && (position + 1 >= checker.m_End || position[ 1 ] != '\n'))) {
+            ++line;
+            line_start = position + 1;
+        }
+    }
+
+    error.line    = line;
+    error.column  = checker.m_ErrorPosition - line_start + 1;
+    error.message = checker.m_ErrorMessage;
+    return result;
+}
+
+
+bool WellFormedChecker::NameRef::operator==(const NameRef &other) const
+{
+    return length == other.length &&
+           std::memcmp(start, other.start, length * sizeof(ushort)) == 0;
+}
+
+
+WellFormedChecker::WellFormedChecker(const QString &source)
+    :
+    m_Begin(source.utf16()),
+    m_Position(m_Begin),
+    m_End(m_Begin + source.length()),
+    m_Result(WellFormed),
+    m_ErrorPosition(m_Begin),
+    m_EntityTable(NULL),
+    m_HasExternalId(false),
+    m_Standalone(false)
+{
+}
+
+
+WellFormedChecker::Result WellFormedChecker::Run()
+{
+    if (IsAtEnd()) {
+        Fail("Premature end of file");
+        return m_Result;
+    }
+
+    // A byte order mark is only expected in raw bytes, not in decoded text.
+    if (*m_Position == 0xFEFF) {
+        GiveUp();
+        return m_Result;
+    }
+
+    if (StartsWith("<?xml") && m_End - m_Position > 5 && IsWhitespace(m_Position[ 5 ])) {
+        ScanXmlDeclaration();
+    }
+
+    bool seen_doctype = false;
+    bool seen_root = false;
+
+    while (!Done()) {
+        ScanCharacterData(false);
+
+        if (Done() || IsAtEnd()) {
+            break;
+        }
+
+        if (StartsWith("<?")) {
+            ScanProcessingInstruction();
+        } else if (StartsWith("<!--")) {
+            ScanComment();
+        } else if (StartsWith("<!DOCTYPE")) {
+            if (seen_doctype || seen_root) {
+                Fail("The DOCTYPE declaration must come before the root element and appear only once");
+            } else {
+                seen_doctype = true;
+                ScanDoctype();
+            }
+        } else if (!seen_root && m_Position + 1 < m_End && m_Position[ 1 ] != '!' && m_Position[ 1 ] != '/') {
+            seen_root = true;
+            ScanElementContent();
+        } else if (seen_root) {
+            Fail("Only comments and processing instructions can follow the root element");
+        } else {
+            Fail("Expected the root element");
+        }
+    }
+
+    if (!Done() && !seen_root) {
+        FailAt(m_End, "The document has no root element");
+    }
+
+    return m_Result;
+}
+
+
+void WellFormedChecker::ScanXmlDeclaration()
+{
+    m_Position += 5;
+    SkipWhitespace();
+    NameRef value;
+
+    if (!ScanPseudoAttribute("version", value) || ToString(value) != "1.0") {
+        GiveUp();
+        return;
+    }
+
+    bool had_space = SkipWhitespace();
+
+    if (had_space && StartsWith("encoding")) {
+        if (!ScanPseudoAttribute("encoding", value) || !IsEncodingName(ToString(value))) {
+            GiveUp();
+            return;
+        }
+
+        had_space = SkipWhitespace();
+    }
+
+    if (had_space && StartsWith("standalone")) {
+        if (!ScanPseudoAttribute("standalone", value) ||
+            (ToString(value) != "yes" && ToString(value) != "no")) {
+            GiveUp();
+            return;
+        }
+
+        m_Standalone = ToString(value) == "yes";
+
+        SkipWhitespace();
+    }
+
+    if (!StartsWith("?>")) {
+        GiveUp();
+        return;
+    }
+
+    m_Position += 2;
+}
+
+
+void WellFormedChecker::ScanDoctype()
+{
+    m_Position += 9;
+
+    if (!SkipWhitespace()) {
+        GiveUp();
+        return;
+    }
+
+    NameRef root_name;
+
+    if (!ScanName(root_name)) {
+        return;
+    }
+
+    bool had_space = SkipWhitespace();
+    bool has_external_id = false;
+    NameRef system_id;
+
+    if (had_space && StartsWith("SYSTEM")) {
+        m_Position += 6;
+
+        if (!SkipWhitespace() || !ScanQuoted(system_id)) {
+            GiveUp();
+            return;
+        }
+
+        has_external_id = true;
+    } else if (had_space && StartsWith("PUBLIC")) {
+        m_Position += 6;
+        NameRef public_id;
+
+        if (!SkipWhitespace() || !ScanQuoted(public_id)) {
+            GiveUp();
+            return;
+        }
+
+        for (int i = 0; i < public_id.length; ++i) {
+            if (!IsPubidChar(public_id.start[ i ])) {
+                GiveUp();
+                return;
+            }
+        }
+
+        // The system literal is optional in SGML but not in XML.
+        if (!SkipWhitespace() || !ScanQuoted(system_id)) {
+            GiveUp();
+            return;
+        }
+
+        has_external_id = true;
+    }
+
+    SkipWhitespace();
+
+    // Internal subsets can declare anything, so Xerces has to deal with them.
+    if (IsAtEnd() || *m_Position != '>') {
+        GiveUp();
+        return;
+    }
+
+    ++m_Position;
+
+    if (!has_external_id) {
+        return;
+    }
+
+    m_HasExternalId = true;
+
+    // A standalone document can't use the entities of an external DTD,
+    // which Xerces reports as errors we don't check for.
+    if (m_Standalone) {
+        GiveUp();
+        return;
+    }
+
+    QString id = ToString(system_id);
+
+    if (id == XHTML_ENTITIES_DTD_ID) {
+        m_EntityTable = &GetXhtmlEntityTable();
+    } else if (id != fc::NCX_2005_1_DTD_ID) {
+        // The NCX DTD declares no general entities.
+        GiveUp();
+    }
+}
+
+
+void WellFormedChecker::ScanProcessingInstruction()
+{
+    const ushort *start = m_Position;
+    m_Position += 2;
+    NameRef target;
+
+    if (!ScanName(target)) {
+        return;
+    }
+
+    if (target.length == 3 && ToString(target).compare("xml", Qt::CaseInsensitive) == 0) {
+        FailAt(start, "The processing instruction target matching \"[xX][mM][lL]\" is not allowed");
+        return;
+    }
+
+    // Targets can't have colons when namespaces are on.
+    if (ColonIndex(target) != -1) {
+        GiveUp();
+        return;
+    }
+
+    if (StartsWith("?>")) {
+        m_Position += 2;
+        return;
+    }
+
+    if (IsAtEnd() || !IsWhitespace(*m_Position)) {
+        Fail("Expected whitespace after the processing instruction target");
+        return;
+    }
+
+    while (true) {
+        if (IsAtEnd()) {
+            FailAt(start, "Unterminated processing instruction");
+            return;
+        }
+
+        if (StartsWith("?>")) {
+            m_Position += 2;
+            return;
+        }
+
+        if (!CheckCharacter()) {
+            return;
+        }
+    }
+}
+
+
+void WellFormedChecker::ScanComment()
+{
+    const ushort *start = m_Position;
+    m_Position += 4;
+
+    while (true) {
+        if (IsAtEnd()) {
+            FailAt(start, "Unterminated comment");
+            return;
+        }
+
+        if (StartsWith("--")) {
+            if (StartsWith("-->")) {
+                m_Position += 3;
+            } else {
+                // Xerces words this error its own way, let it report it.
+                GiveUp();
+            }
+
+            return;
+        }
+
+        if (!CheckCharacter()) {
+            return;
+        }
+    }
+}
+
+
+void WellFormedChecker::ScanCData()
+{
+    const ushort *start = m_Position;
+    m_Position += 9;
+
+    while (true) {
+        if (IsAtEnd()) {
+            FailAt(start, "Unterminated CDATA section");
+            return;
+        }
+
+        if (StartsWith("]]>")) {
+            m_Position += 3;
+            return;
+        }
+
+        if (!CheckCharacter()) {
+            return;
+        }
+    }
+}
+
+
+void WellFormedChecker::ScanElementContent()
+{
+    ScanStartTag();
+
+    while (!Done() && !m_OpenElements.isEmpty()) {
+        ScanCharacterData(true);
+
+        if (Done()) {
+            return;
+        }
+
+        if (IsAtEnd()) {
+            FailAt(m_End, QString("The end of the document was reached before the end tag of element '%1'")
+                   .arg(ToString(m_OpenElements.last().name)));
+            return;
+        }
+
+        if (StartsWith("</")) {
+            ScanEndTag();
+        } else if (StartsWith("<!--")) {
+            ScanComment();
+        } else if (StartsWith("<![CDATA[")) {
+            ScanCData();
+        } else if (StartsWith("<?")) {
+            ScanProcessingInstruction();
+        } else if (StartsWith("<!")) {
+            Fail("Invalid markup in element content");
+        } else {
+            ScanStartTag();
+        }
+    }
+}
+
+
+void WellFormedChecker::ScanStartTag()
+{
+    ++m_Position;
+    NameRef name;
+
+    if (!ScanName(name)) {
+        return;
+    }
+
+    m_Attributes.resize(0);
+    bool is_empty = false;
+
+    while (true) {
+        bool had_space = SkipWhitespace();
+
+        if (IsAtEnd()) {
+            Fail(QString("The end of the document was reached inside the start tag of element '%1'")
+                 .arg(ToString(name)));
+            return;
+        }
+
+        if (*m_Position == '>') {
+            ++m_Position;
+            break;
+        }
+
+        if (StartsWith("/>")) {
+            m_Position += 2;
+            is_empty = true;
+            break;
+        }
+
+        if (!had_space) {
+            Fail("Expected whitespace between attributes");
+            return;
+        }
+
+        Attribute attribute;
+
+        if (!ScanName(attribute.name)) {
+            return;
+        }
+
+        SkipWhitespace();
+
+        if (IsAtEnd() || *m_Position != '=') {
+            Fail(QString("Expected '=' after attribute name '%1'").arg(ToString(attribute.name)));
+            return;
+        }
+
+        ++m_Position;
+        SkipWhitespace();
+
+        if (!ScanAttributeValue(attribute)) {
+            return;
+        }
+
+        attribute.colon = ColonIndex(attribute.name);
+
+        for (int i = 0; i < m_Attributes.count(); ++i) {
+            if (m_Attributes.at(i).name == attribute.name) {
+                Fail(QString("Attribute '%1' is already specified for element '%2'")
+                     .arg(ToString(attribute.name))
+                     .arg(ToString(name)));
+                return;
+            }
+        }
+
+        m_Attributes.append(attribute);
+    }
+
+    int binding_count = m_Bindings.count();
+    CheckNamespaces(name, ColonIndex(name));
+
+    if (Done()) {
+        return;
+    }
+
+    if (is_empty) {
+        m_Bindings.resize(binding_count);
+        return;
+    }
+
+    OpenElement element;
+    element.name = name;
+    element.binding_count = m_Bindings.count() - binding_count;
+    m_OpenElements.append(element);
+}
+
+
+void WellFormedChecker::ScanEndTag()
+{
+    const ushort *start = m_Position;
+    m_Position += 2;
+    NameRef name;
+
+    if (!ScanName(name)) {
+        return;
+    }
+
+    SkipWhitespace();
+
+    if (IsAtEnd() || *m_Position != '>') {
+        Fail(QString("Expected '>' to close the end tag of element '%1'").arg(ToString(name)));
+        return;
+    }
+
+    const OpenElement &element = m_OpenElements.last();
+
+    if (!(name == element.name)) {
+        FailAt(start, QString("Expected end of tag '%1'").arg(ToString(element.name)));
+        return;
+    }
+
+    ++m_Position;
+    m_Bindings.resize(m_Bindings.count() - element.binding_count);
+    m_OpenElements.pop_back();
+}
+
+
+bool WellFormedChecker::ScanAttributeValue(Attribute &attribute)
+{
+    if (IsAtEnd() || (*m_Position != '"' && *m_Position != '\'')) {
+        Fail(QString("Expected a quoted value for attribute '%1'").arg(ToString(attribute.name)));
+        return false;
+    }
+
+    ushort quote = *m_Position;
+    const ushort *start = ++m_Position;
+    attribute.value_has_reference = false;
+
+    while (true) {
+        if (IsAtEnd()) {
+            Fail(QString("The end of the document was reached inside the value of attribute '%1'")
+                 .arg(ToString(attribute.name)));
+            return false;
+        }
+
+        ushort c = *m_Position;
+
+        if (c == quote) {
+            break;
+        }
+
+        if (c == '<') {
+            Fail(QString("The value of attribute '%1' must not contain the '<' character")
+                 .arg(ToString(attribute.name)));
+            return false;
+        }
+
+        if (c == '&') {
+            attribute.value_has_reference = true;
+            ScanReference();
+
+            if (Done()) {
+                return false;
+            }
+        } else if (!CheckCharacter()) {
+            return false;
+        }
+    }
+
+    attribute.value = NameRef(start, m_Position - start);
+    ++m_Position;
+    return true;
+}
+
+
+bool WellFormedChecker::ScanPseudoAttribute(const char *name, NameRef &value)
+{
+    if (!StartsWith(name)) {
+        return false;
+    }
+
+    m_Position += std::strlen(name);
+    SkipWhitespace();
+
+    if (IsAtEnd() || *m_Position != '=') {
+        return false;
+    }
+
+    ++m_Position;
+    SkipWhitespace();
+    return ScanQuoted(value);
+}
+
+
+void WellFormedChecker::ScanCharacterData(bool in_content)
+{
+    while (!IsAtEnd()) {
+        // Most text is plain ASCII, so it's skipped a word at a time.
+        // Only text inside the root element can have any.
+        if (in_content) {
+            while (m_End - m_Position >= 4) {
+                quint64 word;
+                std::memcpy(&word, m_Position, sizeof(word));
+
+                if (!IsPlainText(word)) {
+                    break;
+                }
+
+                m_Position += 4;
+            }
+
+            if (IsAtEnd()) {
+                return;
+            }
+        }
+
+        ushort c = *m_Position;
+
+        if (c == '<') {
+            return;
+        }
+
+        if (!in_content && !IsWhitespace(c)) {
+            Fail("Content is not allowed outside the root element");
+            return;
+        }
+
+        if (c == '&') {
+            ScanReference();
+
+            if (Done()) {
+                return;
+            }
+        } else if (c == ']' && StartsWith("]]>")) {
+            Fail("The character sequence ']]>' must not appear in content unless used to mark the end of a CDATA section");
+            return;
+        } else if (!CheckCharacter()) {
+            return;
+        }
+    }
+}
+
+
+void WellFormedChecker::ScanReference()
+{
+    const ushort *start = m_Position;
+    ++m_Position;
+
+    if (IsAtEnd()) {
+        FailAt(start, "The end of the document was reached inside a reference");
+        return;
+    }
+
+    if (*m_Position == '#') {
+        ++m_Position;
+        bool is_hex = !IsAtEnd() && *m_Position == 'x';
+        quint32 base = is_hex ? 16 : 10;
+        quint32 value = 0;
+        int digits = 0;
+
+        if (is_hex) {
+            ++m_Position;
+        }
+
+        while (!IsAtEnd() && *m_Position != ';') {
+            ushort c = *m_Position;
+            quint32 digit;
+
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if (is_hex && c >= 'a' && c <= 'f') {
+                digit = c - 'a' + 10;
+            } else if (is_hex && c >= 'A' && c <= 'F') {
+                digit = c - 'A' + 10;
+            } else {
+                FailAt(start, "Invalid character reference");
+                return;
+            }
+
+            // Anything past the last code point is invalid, stop growing there.
+            value = qMin< quint32 >(value * base + digit, 0x110000);
+            ++digits;
+            ++m_Position;
+        }
+
+        if (IsAtEnd()) {
+            FailAt(start, "The character reference must end with the ';' delimiter");
+            return;
+        }
+
+        if (digits == 0 || !IsXmlChar(value)) {
+            FailAt(start, QString("Character reference '%1' is not a legal XML character")
+                   .arg(ToString(NameRef(start, m_Position + 1 - start))));
+            return;
+        }
+
+        ++m_Position;
+        return;
+    }
+
+    NameRef name;
+
+    if (!ScanName(name)) {
+        return;
+    }
+
+    if (IsAtEnd() || *m_Position != ';') {
+        FailAt(start, QString("The reference to entity '%1' must end with the ';' delimiter")
+               .arg(ToString(name)));
+        return;
+    }
+
+    ++m_Position;
+    QString entity = QString::fromRawData(reinterpret_cast< const QChar * >(name.start), name.length);
+
+    if (IsPredefinedEntity(entity)) {
+        return;
+    }
+
+    if (m_EntityTable) {
+        if (m_EntityTable->character_entities.contains(entity)) {
+            return;
+        }
+
+        // The replacement text is markup Xerces has to expand and check.
+        if (m_EntityTable->other_entities.contains(entity)) {
+            GiveUp();
+            return;
+        }
+    }
+
+    // Without validation, Xerces only reports undeclared entities
+    // in documents that have no external DTD (or are standalone).
+    if (m_HasExternalId) {
+        GiveUp();
+        return;
+    }
+
+    FailAt(start, QString("The entity '%1' was referenced, but not declared").arg(ToString(name)));
+}
+
+
+bool WellFormedChecker::ScanName(NameRef &name)
+{
+    const ushort *start = m_Position;
+
+    if (IsAtEnd()) {
+        Fail("The end of the document was reached where a name was expected");
+        return false;
+    }
+
+    if (!IsAsciiNameStart(*m_Position)) {
+        if (*m_Position >= 0x80) {
+            GiveUp();
+        } else {
+            Fail("Expected a name");
+        }
+
+        return false;
+    }
+
+    while (!IsAtEnd() && IsAsciiNameChar(*m_Position)) {
+        ++m_Position;
+    }
+
+    // Names with characters outside ASCII are left to Xerces.
+    if (!IsAtEnd() && *m_Position >= 0x80) {
+        GiveUp();
+        return false;
+    }
+
+    name = NameRef(start, m_Position - start);
+    return true;
+}
+
+
+bool WellFormedChecker::ScanQuoted(NameRef &value)
+{
+    if (IsAtEnd() || (*m_Position != '"' && *m_Position != '\'')) {
+        return false;
+    }
+
+    ushort quote = *m_Position;
+    const ushort *start = ++m_Position;
+
+    while (!IsAtEnd() && *m_Position != quote) {
+        if (!CheckCharacter()) {
+            return false;
+        }
+    }
+
+    if (IsAtEnd()) {
+        return false;
+    }
+
+    value = NameRef(start, m_Position - start);
+    ++m_Position;
+    return true;
+}
+
+
+bool WellFormedChecker::SkipWhitespace()
+{
+    const ushort *start = m_Position;
+
+    while (!IsAtEnd() && IsWhitespace(*m_Position)) {
+        ++m_Position;
+    }
+
+    return m_Position != start;
+}
+
+
+bool WellFormedChecker::CheckCharacter()
+{
+    ushort c = *m_Position;
+
+    if ((c >= 0x20 && c < 0xD800) ||
+        (c >= 0xE000 && c <= 0xFFFD) ||
+        c == 0x9 || c == 0xA || c == 0xD) {
+        ++m_Position;
+        return true;
+    }
+
+    if (c >= 0xD800 && c <= 0xDBFF &&
+        m_Position + 1 < m_End &&
+        m_Position[ 1 ] >= 0xDC00 && m_Position[ 1 ] <= 0xDFFF) {
+        m_Position += 2;
+        return true;
+    }
+
+    Fail(QString("Invalid character (Unicode: 0x%1)").arg(c, 0, 16));
+    return false;
+}
+
+
+void WellFormedChecker::CheckNamespaces(const NameRef &element_name, int element_colon)
+{
+    int binding_start = m_Bindings.count();
+
+    for (int i = 0; i < m_Attributes.count(); ++i) {
+        const Attribute &attribute = m_Attributes.at(i);
+        bool is_default = attribute.name.length == 5 && StartsWith(attribute.name.start, "xmlns");
+        bool is_prefixed = attribute.colon == 5 && StartsWith(attribute.name.start, "xmlns");
+
+        if ((is_default || is_prefixed) && attribute.value_has_reference) {
+            GiveUp();
+            return;
+        }
+
+        if (!is_prefixed) {
+            continue;
+        }
+
+        Binding binding;
+        binding.prefix = NameRef(attribute.name.start + 6, attribute.name.length - 6);
+        binding.uri = attribute.value;
+        QString prefix = ToString(binding.prefix);
+
+        if (binding.uri.length == 0 || prefix == "xml" || prefix == "xmlns") {
+            GiveUp();
+            return;
+        }
+
+        m_Bindings.append(binding);
+    }
+
+    // An unbound prefix is an error unless a DTD default binds it,
+    // which is too much to track here.
+    if (element_colon == -2 ||
+        (element_colon > 0 && !IsPrefixBound(NameRef(element_name.start, element_colon)))) {
+        m_Bindings.resize(binding_start);
+        GiveUp();
+        return;
+    }
+
+    for (int i = 0; i < m_Attributes.count(); ++i) {
+        const Attribute &attribute = m_Attributes.at(i);
+
+        if (attribute.colon == -1 || (attribute.colon == 5 && StartsWith(attribute.name.start, "xmlns"))) {
+            continue;
+        }
+
+        if (attribute.colon == -2 || !IsPrefixBound(NameRef(attribute.name.start, attribute.colon))) {
+            m_Bindings.resize(binding_start);
+            GiveUp();
+            return;
+        }
+
+        // Two attributes with different prefixes for the same namespace
+        // and the same local name are duplicates too.
+        for (int j = 0; j < i; ++j) {
+            const Attribute &other = m_Attributes.at(j);
+
+            if (other.colon <= 0 ||
+                !(NameRef(attribute.name.start + attribute.colon, attribute.name.length - attribute.colon) ==
+                  NameRef(other.name.start + other.colon, other.name.length - other.colon))) {
+                continue;
+            }
+
+            const NameRef *uri = FindNamespace(NameRef(attribute.name.start, attribute.colon));
+            const NameRef *other_uri = FindNamespace(NameRef(other.name.start, other.colon));
+
+            if (uri == other_uri || (uri && other_uri && *uri == *other_uri)) {
+                m_Bindings.resize(binding_start);
+                GiveUp();
+                return;
+            }
+        }
+    }
+}
+
+
+bool WellFormedChecker::IsPrefixBound(const NameRef &prefix) const
+{
+    return FindNamespace(prefix) != 0 || (prefix.length == 3 && StartsWith(prefix.start, "xml"));
+}
+
+
+const WellFormedChecker::NameRef *WellFormedChecker::FindNamespace(const NameRef &prefix) const
+{
+    // The innermost binding wins.
+    for (int i = m_Bindings.count() - 1; i >= 0; --i) {
+        if (m_Bindings.at(i).prefix == prefix) {
+            return &m_Bindings.at(i).uri;
+        }
+    }
+
+    return 0;
+}
+
+
+bool WellFormedChecker::StartsWith(const char *text) const
+{
+    int length = std::strlen(text);
+    return m_End - m_Position >= length && StartsWith(m_Position, text);
+}
+
+
+bool WellFormedChecker::StartsWith(const ushort *position, const char *text)
+{
+    for (; *text; ++text, ++position) {
+        if (*position != static_cast< uchar >(*text)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool WellFormedChecker::IsAtEnd() const
+{
+    return m_Position >= m_End;
+}
+
+
+void WellFormedChecker::Fail(const QString &message)
+{
+    FailAt(m_Position, message);
+}
+
+
+void WellFormedChecker::FailAt(const ushort *position, const QString &message)
+{
+    if (m_Result != WellFormed) {
+        return;
+    }
+
+    m_Result = NotWellFormed;
+    m_ErrorPosition = position;
+    m_ErrorMessage = message;
+}
+
+
+void WellFormedChecker::GiveUp()
+{
+    if (m_Result == WellFormed) {
+        m_Result = Unsupported;
+    }
+}
+
+
+bool WellFormedChecker::Done() const
+{
+    return m_Result != WellFormed;
+}
+
+
+int WellFormedChecker::ColonIndex(const NameRef &name)
+{
+    int colon = -1;
+
+    for (int i = 0; i < name.length; ++i) {
+        if (name.start[ i ] == ':') {
+            if (colon != -1) {
+                return -2;
+            }
+
+            colon = i;
+        }
+    }
+
+    if (colon == 0 || colon == name.length - 1) {
+        return -2;
+    }
+
+    return colon;
+}
+
+
+QString WellFormedChecker::ToString(const NameRef &name)
+{
+    return QString(reinterpret_cast< const QChar * >(name.start), name.length);
+}
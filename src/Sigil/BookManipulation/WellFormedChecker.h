@@ -0,0 +1,190 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef WELLFORMEDCHECKER_H
+#define WELLFORMEDCHECKER_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "BookManipulation/XhtmlDoc.h"
+
+struct XhtmlEntityTable;
+
+/**
+ * A non-validating XML well-formedness checker.
+ *
+ * It makes a single pass over the UTF-16 text of a document, with
+ * runs of plain ASCII text skipped four characters at a time, and
+ * knows the entities of the XHTML and NCX DTDs we parse against.
+ *
+ * It only handles what our books actually contain. Documents with
+ * an internal DTD subset, DTDs we don't have, non-ASCII names and
+ * other rarities are reported as Unsupported, and must be checked
+ * with Xerces instead.
+ */
+class WellFormedChecker
+{
+
+public:
+
+    enum Result {
+        /**
+         * The document is well-formed.
+         */
+        WellFormed,
+
+        /**
+         * The document is not well-formed.
+         * The error describes the first problem found.
+         */
+        NotWellFormed,
+
+        /**
+         * The document uses something the checker doesn't handle.
+         */
+        Unsupported
+    };
+
+    /**
+     * Checks whether a document is well-formed.
+     *
+     * @param source The text of the document.
+     * @param error Set to the first error when the document
+     *              is not well-formed.
+     * @return The outcome of the check.
+     */
+    static Result Check(const QString &source, XhtmlDoc::WellFormedError &error);
+
+private:
+
+    /**
+     * A name inside the source.
+     */
+    struct NameRef {
+        const ushort *start;
+        int length;
+
+        NameRef() : start(0), length(0) {}
+        NameRef(const ushort *name_start, int name_length) : start(name_start), length(name_length) {}
+
+        bool operator==(const NameRef &other) const;
+    };
+
+    /**
+     * A namespace prefix declared on an element.
+     */
+    struct Binding {
+        NameRef prefix;
+        NameRef uri;
+    };
+
+    /**
+     * An attribute of the start tag being checked.
+     */
+    struct Attribute {
+        NameRef name;
+        int colon;
+        NameRef value;
+        bool value_has_reference;
+    };
+
+    /**
+     * An element whose end tag hasn't been found yet.
+     */
+    struct OpenElement {
+        NameRef name;
+        int binding_count;
+    };
+
+    WellFormedChecker(const QString &source);
+
+    Result Run();
+
+    void ScanXmlDeclaration();
+    void ScanDoctype();
+    void ScanProcessingInstruction();
+    void ScanComment();
+    void ScanCData();
+    void ScanElementContent();
+    void ScanStartTag();
+    void ScanEndTag();
+    bool ScanAttributeValue(Attribute &attribute);
+    bool ScanPseudoAttribute(const char *name, NameRef &value);
+    void ScanCharacterData(bool in_content);
+    void ScanReference();
+    bool ScanName(NameRef &name);
+    bool ScanQuoted(NameRef &value);
+    bool SkipWhitespace();
+    bool CheckCharacter();
+    void CheckNamespaces(const NameRef &element_name, int element_colon);
+    bool IsPrefixBound(const NameRef &prefix) const;
+    const NameRef *FindNamespace(const NameRef &prefix) const;
+
+    bool StartsWith(const char *text) const;
+    static bool StartsWith(const ushort *position, const char *text);
+    bool IsAtEnd() const;
+
+    void Fail(const QString &message);
+    void FailAt(const ushort *position, const QString &message);
+    void GiveUp();
+    bool Done() const;
+
+    static int ColonIndex(const NameRef &name);
+    static QString ToString(const NameRef &name);
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    const ushort *m_Begin;
+    const ushort *m_Position;
+    const ushort *m_End;
+
+    Result m_Result;
+    const ushort *m_ErrorPosition;
+    QString m_ErrorMessage;
+
+    /**
+     * The entities of the XHTML DTD, if the document uses it. Fetched
+     * once per document, so the references don't have to lock the
+     * shared table. NULL if only the predefined entities can be used.
+     */
+    const XhtmlEntityTable *m_EntityTable;
+
+    /**
+     * Set when the DOCTYPE names an external DTD.
+     */
+    bool m_HasExternalId;
+
+    /**
+     * Set when the XML declaration says standalone="yes".
+     */
+    bool m_Standalone;
+
+    QVector< OpenElement > m_OpenElements;
+    QVector< Binding > m_Bindings;
+    QVector< Attribute > m_Attributes;
+};
+
+#endif // WELLFORMEDCHECKER_H
@@ -28,9 +28,42 @@
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/util/XMLString.hpp>
 
+#include <QtCore/QString>
+
 namespace xc = XERCES_CPP_NAMESPACE;
 
-#define QtoX( str ) QString( (str) ).utf16()
+// QString and Xerces strings are both UTF-16,
+// so neither needs transcoding to be used as the other.
+
+// A non-owning view of the storage of a QString as a Xerces string.
+// Nothing is copied, so the view is only valid as long as the
+// QString it was created from is alive and unmodified.
+class XStringView
+{
+
+public:
+
+    XStringView(const QString &str)
+        : m_String(reinterpret_cast< const XMLCh * >(str.utf16())) {}
+
+    operator const XMLCh *() const {
+        return m_String;
+    }
+
+private:
+
+    const XMLCh *m_String;
+};
+
+#define QtoX( str ) XStringView( (str) )
 #define XtoQ( str ) QString( (const QChar *) (str) )
 
+// Wraps a Xerces string in a QString without copying it.
+// The QString must not outlive the Xerces string, so this
+// is only meant for comparisons and other transient uses.
+inline QString XtoQView(const XMLCh *str)
+{
+    return QString::fromRawData(reinterpret_cast< const QChar * >(str), (int) xc::XMLString::stringLen(str));
+}
+
 #endif // XERCESCPPUSE_H
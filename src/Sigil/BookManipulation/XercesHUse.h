@@ -33,6 +33,7 @@ class DOMDocument;
 class DOMDocumentFragment;
 class DOMElement;
 class DOMNodeList;
+class XMLGrammarPool;
 };
 namespace xc = XERCES_CPP_NAMESPACE;
 
@@ -0,0 +1,49 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <xercesc/util/XMLUniDefs.hpp>
+
+#include "BookManipulation/XercesNames.h"
+
+namespace xc = XERCES_CPP_NAMESPACE;
+
+namespace XercesNames
+{
+const XMLCh A[] = { xc::chLatin_a, xc::chNull };
+const XMLCh BODY[] = { xc::chLatin_b, xc::chLatin_o, xc::chLatin_d, xc::chLatin_y, xc::chNull };
+const XMLCh CLASS[] = { xc::chLatin_c, xc::chLatin_l, xc::chLatin_a, xc::chLatin_s, xc::chLatin_s, xc::chNull };
+const XMLCh CONTENT[] = { xc::chLatin_c, xc::chLatin_o, xc::chLatin_n, xc::chLatin_t, xc::chLatin_e, xc::chLatin_n, xc::chLatin_t, xc::chNull };
+const XMLCh HEAD[] = { xc::chLatin_h, xc::chLatin_e, xc::chLatin_a, xc::chLatin_d, xc::chNull };
+const XMLCh HREF[] = { xc::chLatin_h, xc::chLatin_r, xc::chLatin_e, xc::chLatin_f, xc::chNull };
+const XMLCh HTML[] = { xc::chLatin_h, xc::chLatin_t, xc::chLatin_m, xc::chLatin_l, xc::chNull };
+const XMLCh ID[] = { xc::chLatin_i, xc::chLatin_d, xc::chNull };
+const XMLCh IDREF[] = { xc::chLatin_i, xc::chLatin_d, xc::chLatin_r, xc::chLatin_e, xc::chLatin_f, xc::chNull };
+const XMLCh LINK[] = { xc::chLatin_l, xc::chLatin_i, xc::chLatin_n, xc::chLatin_k, xc::chNull };
+const XMLCh META[] = { xc::chLatin_m, xc::chLatin_e, xc::chLatin_t, xc::chLatin_a, xc::chNull };
+const XMLCh NAME[] = { xc::chLatin_n, xc::chLatin_a, xc::chLatin_m, xc::chLatin_e, xc::chNull };
+const XMLCh REL[] = { xc::chLatin_r, xc::chLatin_e, xc::chLatin_l, xc::chNull };
+const XMLCh SCHEME[] = { xc::chLatin_s, xc::chLatin_c, xc::chLatin_h, xc::chLatin_e, xc::chLatin_m, xc::chLatin_e, xc::chNull };
+const XMLCh SRC[] = { xc::chLatin_s, xc::chLatin_r, xc::chLatin_c, xc::chNull };
+const XMLCh STYLE[] = { xc::chLatin_s, xc::chLatin_t, xc::chLatin_y, xc::chLatin_l, xc::chLatin_e, xc::chNull };
+const XMLCh TITLE[] = { xc::chLatin_t, xc::chLatin_i, xc::chLatin_t, xc::chLatin_l, xc::chLatin_e, xc::chNull };
+const XMLCh TOC[] = { xc::chLatin_t, xc::chLatin_o, xc::chLatin_c, xc::chNull };
+const XMLCh TYPE[] = { xc::chLatin_t, xc::chLatin_y, xc::chLatin_p, xc::chLatin_e, xc::chNull };
+}
@@ -0,0 +1,56 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef XERCESNAMES_H
+#define XERCESNAMES_H
+
+#include <xercesc/util/XercesDefs.hpp>
+
+// The tag and attribute names we look up over and over while walking
+// DOMs. They are built once, so a lookup doesn't need to convert the
+// name to a Xerces string first.
+namespace XercesNames
+{
+extern const XMLCh A[];
+extern const XMLCh BODY[];
+extern const XMLCh CLASS[];
+extern const XMLCh CONTENT[];
+extern const XMLCh HEAD[];
+extern const XMLCh HREF[];
+extern const XMLCh HTML[];
+extern const XMLCh ID[];
+extern const XMLCh IDREF[];
+extern const XMLCh LINK[];
+extern const XMLCh META[];
+extern const XMLCh NAME[];
+extern const XMLCh REL[];
+extern const XMLCh SCHEME[];
+extern const XMLCh SRC[];
+extern const XMLCh STYLE[];
+extern const XMLCh TITLE[];
+extern const XMLCh TOC[];
+extern const XMLCh TYPE[];
+}
+
+namespace xn = XercesNames;
+
+#endif // XERCESNAMES_H
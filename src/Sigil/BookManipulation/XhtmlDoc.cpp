@@ -25,6 +25,8 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <xercesc/framework/MemBufInputSource.hpp>
+#include <xercesc/framework/XMLFormatter.hpp>
+#include <xercesc/framework/XMLGrammarPoolImpl.hpp>
 #include <xercesc/sax2/SAX2XMLReader.hpp>
 #include <xercesc/sax2/XMLReaderFactory.hpp>
 //FlightCrew
@@ -36,7 +38,10 @@
 
 #include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QString>
+#include <QtCore/QThreadPool>
 #include <QtCore/QXmlStreamReader>
 #include <QtWebKitWidgets/QWebFrame>
 #include <QtWebKitWidgets/QWebPage>
@@ -46,7 +51,9 @@
 #include <QRegularExpressionMatch>
 
 #include "BookManipulation/CleanSource.h"
+#include "BookManipulation/WellFormedChecker.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/Utility.h"
 #include "sigil_constants.h"
@@ -82,6 +89,12 @@ static const int XML_CUSTOM_ENTITY_SEARCH_PREFIX_SIZE = 500;
 static const QString ENTITY_SEARCH = "<!ENTITY\\s+(\\w+)\\s+\"([^\"]+)\">";
 static const QString URL_ATTRIBUTE_SEARCH = ":.*(url\\s*\\([^\\)]+\\))";
 
+static QMutex s_GrammarPoolMutex;
+
+// The idle DOM parsers, guarded by s_ParserPoolMutex.
+static QMutex s_ParserPoolMutex;
+static QList< XercesExt::LocationAwareDOMParser * > s_IdleParsers;
+
 const QString BREAK_TAG_SEARCH  = "(<div>\\s*)?<hr\\s*class\\s*=\\s*\"[^\"]*(sigil_split_marker|sigilChapterBreak)[^\"]*\"\\s*/>(\\s*</div>)?";
 
 namespace FlightCrew
@@ -94,6 +107,30 @@ extern const unsigned char NCX_2005_1_DTD[];
 namespace fc = FlightCrew;
 
 
+namespace
+{
+
+// Appends the UTF-16 output of a serializer to a QString.
+class QStringFormatTarget : public xc::XMLFormatTarget
+{
+
+public:
+
+    QStringFormatTarget(QString &text) : m_Text(text) {}
+
+    void writeChars(const XMLByte *const bytes, const XMLSize_t count, xc::XMLFormatter *const)
+    {
+        m_Text.append(reinterpret_cast< const QChar * >(bytes), (int)(count / sizeof(QChar)));
+    }
+
+private:
+
+    QString &m_Text;
+};
+
+}
+
+
 // Resolves custom ENTITY declarations
 QString XhtmlDoc::ResolveCustomEntities(const QString &source)
 {
@@ -241,7 +278,11 @@ QList< xc::DOMElement * > XhtmlDoc::GetTagMatchingDescendants(const xc::DOMNode
 {
     QList< xc::DOMElement * > matching_nodes;
 
-    if (tag_names.contains(GetNodeName(node), Qt::CaseInsensitive)) {
+    // The name is only compared, so it doesn't need to be copied.
+    const XMLCh *local_name = node.getLocalName();
+    const QString node_name = XtoQView(local_name && *local_name ? local_name : node.getNodeName());
+
+    if (tag_names.contains(node_name, Qt::CaseInsensitive)) {
         matching_nodes.append((xc::DOMElement *) &node);
     }
 
@@ -304,8 +345,8 @@ QList<QString> XhtmlDoc::GetAllDescendantClasses(const xc::DOMNode &node)
     QList< QString > classes;
     QString element_name = GetNodeName(*element);
 
-    if (element->hasAttribute(QtoX("class"))) {
-        QString class_values = XtoQ(element->getAttribute(QtoX("class")));
+    if (element->hasAttribute(xn::CLASS)) {
+        QString class_values = XtoQ(element->getAttribute(xn::CLASS));
         foreach(QString class_name, class_values.split(" ")) {
             classes.append(element_name + "." + class_name);
         }
@@ -331,8 +372,8 @@ QList< QString > XhtmlDoc::GetAllDescendantStyleUrls(const xc::DOMNode &node)
     const xc::DOMElement *element = static_cast< const xc::DOMElement * >(&node);
     QList< QString > styles;
 
-    if (element->hasAttribute(QtoX("style"))) {
-        QString attribute = XtoQ(element->getAttribute(QtoX("style")));
+    if (element->hasAttribute(xn::STYLE)) {
+        QString attribute = XtoQ(element->getAttribute(xn::STYLE));
         QRegularExpression url_search(URL_ATTRIBUTE_SEARCH);
         QRegularExpressionMatch match = url_search.match(attribute);
         if (match.hasMatch()) {
@@ -360,13 +401,13 @@ QList< QString > XhtmlDoc::GetAllDescendantIDs(const xc::DOMNode &node)
     const xc::DOMElement *element = static_cast< const xc::DOMElement * >(&node);
     QList< QString > IDs;
 
-    if (element->hasAttribute(QtoX("id"))) {
-        IDs.append(XtoQ(element->getAttribute(QtoX("id"))));
-    } else if (element->hasAttribute(QtoX("name"))) {
+    if (element->hasAttribute(xn::ID)) {
+        IDs.append(XtoQ(element->getAttribute(xn::ID)));
+    } else if (element->hasAttribute(xn::NAME)) {
         // This is supporting legacy html of <a name="xxx"> (deprecated).
         // Make sure we don't return names of other elements like <meta> tags.
-        if (XtoQ(element->getTagName()).toLower() == "a") {
-            IDs.append(XtoQ(element->getAttribute(QtoX("name"))));
+        if (XtoQView(element->getTagName()).compare("a", Qt::CaseInsensitive) == 0) {
+            IDs.append(XtoQ(element->getAttribute(xn::NAME)));
         }
     }
 
@@ -390,8 +431,8 @@ QList< QString > XhtmlDoc::GetAllDescendantHrefs(const xc::DOMNode &node)
     const xc::DOMElement *element = static_cast< const xc::DOMElement * >(&node);
     QList< QString > hrefs;
 
-    if (element->hasAttribute(QtoX("href"))) {
-        hrefs.append(XtoQ(element->getAttribute(QtoX("href"))));
+    if (element->hasAttribute(xn::HREF)) {
+        hrefs.append(XtoQ(element->getAttribute(xn::HREF)));
     }
 
     if (node.hasChildNodes()) {
@@ -421,14 +462,35 @@ QString XhtmlDoc::GetDomNodeAsString(const xc::DOMNode &node)
 }
 
 
-// This func makes sure that the UTF-8 encoding is set for the XML declaration
+// The markup is the same as GetDomNodeAsString's, but the
+// declaration is written by us so it can say UTF-8 up front.
 QString XhtmlDoc::GetDomDocumentAsString(const xc::DOMDocument &document)
 {
-    QString raw_source = GetDomNodeAsString(document);
-    QRegularExpression encoding(ENCODING_ATTRIBUTE);
-    QRegularExpressionMatch match = encoding.match(raw_source);
-    int encoding_start = match.capturedStart();
-    return raw_source.replace(encoding_start, match.capturedLength(), "encoding=\"UTF-8\"");
+    const XMLCh *version = document.getXmlVersion();
+    QString text = QString("<?xml version=\"%1\" encoding=\"UTF-8\" standalone=\"%2\" ?>")
+                   .arg(version && *version ? XtoQ(version) : QString("1.0"))
+                   .arg(document.getXmlStandalone() ? "yes" : "no");
+    QStringFormatTarget target(text);
+    XMLCh LS[] = { xc::chLatin_L, xc::chLatin_S, xc::chNull };
+    XMLCh UTF16[] = { xc::chLatin_U, xc::chLatin_T, xc::chLatin_F, xc::chDash, xc::chDigit_1, xc::chDigit_6, xc::chNull };
+    xc::DOMImplementationLS *impl =
+        static_cast< xc::DOMImplementationLS * >(xc::DOMImplementationRegistry::getDOMImplementation(LS));
+    shared_ptr< xc::DOMLSSerializer > serializer(
+        impl->createLSSerializer(),
+        XercesExt::XercesDeallocator< xc::DOMLSSerializer >);
+    shared_ptr< xc::DOMLSOutput > output(
+        impl->createLSOutput(),
+        XercesExt::XercesDeallocator< xc::DOMLSOutput >);
+    serializer->getDomConfig()->setParameter(xc::XMLUni::fgDOMWRTDiscardDefaultContent, false);
+    serializer->getDomConfig()->setParameter(xc::XMLUni::fgDOMXMLDeclaration, false);
+    output->setByteStream(&target);
+    output->setEncoding(UTF16);
+
+    if (!serializer->write(&document, output.get())) {
+        return QString();
+    }
+
+    return text;
 }
 
 
@@ -438,19 +500,69 @@ shared_ptr< xc::DOMDocument > XhtmlDoc::CopyDomDocument(const xc::DOMDocument &d
 }
 
 
-shared_ptr< xc::DOMDocument > XhtmlDoc::LoadTextIntoDocument(const QString &source)
+XhtmlDoc::ParserHandle::ParserHandle()
+    :
+    m_Parser(NULL)
+{
+    {
+        QMutexLocker locker(&s_ParserPoolMutex);
+
+        if (!s_IdleParsers.isEmpty()) {
+            m_Parser = s_IdleParsers.takeLast();
+        }
+    }
+
+    if (!m_Parser) {
+        m_Parser = CreateParser();
+    }
+}
+
+
+XhtmlDoc::ParserHandle::~ParserHandle()
 {
-    XercesExt::LocationAwareDOMParser parser;
+    // Documents that were not adopted (the parse failed)
+    // would otherwise pile up inside the parser.
+    m_Parser->resetDocumentPool();
+    {
+        QMutexLocker locker(&s_ParserPoolMutex);
+
+        // One parser for every pool thread and one for the GUI thread
+        // is as many as can be busy at the same time.
+        if (s_IdleParsers.count() <= QThreadPool::globalInstance()->maxThreadCount()) {
+            s_IdleParsers.append(m_Parser);
+            return;
+        }
+    }
+    delete m_Parser;
+}
+
+
+XercesExt::LocationAwareDOMParser &XhtmlDoc::ParserHandle::GetParser()
+{
+    return *m_Parser;
+}
+
+
+XercesExt::LocationAwareDOMParser *XhtmlDoc::ParserHandle::CreateParser()
+{
+    XercesExt::LocationAwareDOMParser *parser =
+        new XercesExt::LocationAwareDOMParser(0, xc::XMLPlatformUtils::fgMemoryManager, GetGrammarPool());
     // This scanner ignores schemas
-    parser.useScanner(xc::XMLUni::fgDGXMLScanner);
-    parser.setValidationScheme(xc::AbstractDOMParser::Val_Never);
-    parser.useCachedGrammarInParse(true);
-    parser.setLoadExternalDTD(true);
-    parser.setDoNamespaces(true);
-    xc::MemBufInputSource xhtml_dtd(XHTML_ENTITIES_DTD, XHTML_ENTITIES_DTD_LEN, XHTML_ENTITIES_DTD_ID);
-    parser.loadGrammar(xhtml_dtd, xc::Grammar::DTDGrammarType, true);
-    xc::MemBufInputSource ncx_dtd(fc::NCX_2005_1_DTD, fc::NCX_2005_1_DTD_LEN, fc::NCX_2005_1_DTD_ID);
-    parser.loadGrammar(ncx_dtd, xc::Grammar::DTDGrammarType, true);
+    parser->useScanner(xc::XMLUni::fgDGXMLScanner);
+    parser->setValidationScheme(xc::AbstractDOMParser::Val_Never);
+    // The DTDs come from the shared pool, already compiled.
+    parser->useCachedGrammarInParse(true);
+    parser->cacheGrammarFromParse(false);
+    parser->setLoadExternalDTD(true);
+    parser->setDoNamespaces(true);
+    return parser;
+}
+
+
+shared_ptr< xc::DOMDocument > XhtmlDoc::LoadTextIntoDocument(const QString &source)
+{
+    ParserHandle handle;
+    XercesExt::LocationAwareDOMParser &parser = handle.GetParser();
     QString prepared_source = PrepareSourceForXerces(source);
     // We use source.count() * 2 because count returns
     // the number of QChars, which are 2 bytes long
@@ -485,19 +597,31 @@ int XhtmlDoc::NodeColumnNumber(const xc::DOMNode &node)
 
 XhtmlDoc::WellFormedError XhtmlDoc::WellFormedErrorForSource(const QString &source)
 {
-    boost::scoped_ptr< xc::SAX2XMLReader > parser(xc::XMLReaderFactory::createXMLReader());
+    XhtmlDoc::WellFormedError error;
+
+    // The dedicated checker handles almost every book on its own,
+    // Xerces only sees the documents it doesn't support.
+    if (WellFormedChecker::Check(source, error) != WellFormedChecker::Unsupported) {
+        return error;
+    }
+
+    return XercesWellFormedErrorForSource(source);
+}
+
+
+XhtmlDoc::WellFormedError XhtmlDoc::XercesWellFormedErrorForSource(const QString &source)
+{
+    boost::scoped_ptr< xc::SAX2XMLReader > parser(
+        xc::XMLReaderFactory::createXMLReader(xc::XMLPlatformUtils::fgMemoryManager, GetGrammarPool()));
     parser->setFeature(xc::XMLUni::fgSAX2CoreValidation,            false);
     parser->setFeature(xc::XMLUni::fgXercesSchema,                  false);
     parser->setFeature(xc::XMLUni::fgXercesLoadSchema,              false);
     parser->setFeature(xc::XMLUni::fgXercesUseCachedGrammarInParse, true);
+    parser->setFeature(xc::XMLUni::fgXercesCacheGrammarFromParse,   false);
     parser->setFeature(xc::XMLUni::fgXercesSkipDTDValidation,       true);
     // We need the DGXMLScanner because of the entities
     parser->setProperty(xc::XMLUni::fgXercesScannerName,
                         (void *) xc::XMLUni::fgDGXMLScanner);
-    xc::MemBufInputSource xhtml_dtd(XHTML_ENTITIES_DTD, XHTML_ENTITIES_DTD_LEN, XHTML_ENTITIES_DTD_ID);
-    parser->loadGrammar(xhtml_dtd, xc::Grammar::DTDGrammarType, true);
-    xc::MemBufInputSource ncx_dtd(fc::NCX_2005_1_DTD, fc::NCX_2005_1_DTD_LEN, fc::NCX_2005_1_DTD_ID);
-    parser->loadGrammar(ncx_dtd, xc::Grammar::DTDGrammarType, true);
     fc::ErrorResultCollector collector;
     parser->setErrorHandler(&collector);
     QString prepared_source = PrepareSourceForXerces(source);
@@ -972,7 +1096,7 @@ xc::DOMNode &XhtmlDoc::GetAncestorBlockElement(const xc::DOMNode &node)
     if (parent_node) {
         return const_cast< xc::DOMNode & >(*parent_node);
     } else {
-        return *(node.getOwnerDocument()->getElementsByTagName(QtoX("body"))->item(0));
+        return *(node.getOwnerDocument()->getElementsByTagName(xn::BODY)->item(0));
     }
 }
 
@@ -991,7 +1115,7 @@ xc::DOMNode &XhtmlDoc::GetAncestorIDElement(const xc::DOMNode &node)
     if (parent_node) {
         return const_cast<xc::DOMNode &>(*parent_node);
     } else {
-        return *(node.getOwnerDocument()->getElementsByTagName(QtoX("body"))->item(0));
+        return *(node.getOwnerDocument()->getElementsByTagName(xn::BODY)->item(0));
     }
 }
 
@@ -1012,8 +1136,8 @@ QStringList XhtmlDoc::GetAllMediaPathsFromMediaChildren(const xc::DOMNode &node,
     foreach(xc::DOMElement * node, nodes) {
         QString url_reference;
 
-        if (node->hasAttribute(QtoX("src"))) {
-            url_reference = Utility::URLDecodePath(XtoQ(node->getAttribute(QtoX("src"))));
+        if (node->hasAttribute(xn::SRC)) {
+            url_reference = Utility::URLDecodePath(XtoQ(node->getAttribute(xn::SRC)));
         } else { // This covers the SVG "image" tags
             url_reference = Utility::URLDecodePath(XtoQ(node->getAttribute(QtoX("xlink:href"))));
         }
@@ -1032,8 +1156,8 @@ QStringList XhtmlDoc::GetAllHrefPaths(const xc::DOMNode &node)
     QStringList hrefs;
     // Get a list of all defined hrefs
     foreach(xc::DOMElement * node, nodes) {
-        if (node->hasAttribute(QtoX("href"))) {
-            hrefs.append(XtoQ(node->getAttribute(QtoX("href"))));
+        if (node->hasAttribute(xn::HREF)) {
+            hrefs.append(XtoQ(node->getAttribute(xn::HREF)));
         }
     }
     return hrefs;
@@ -1066,6 +1190,12 @@ XhtmlDoc::XMLElement XhtmlDoc::CreateXMLElement(QXmlStreamReader &reader)
 
 QString XhtmlDoc::PrepareSourceForXerces(const QString &source)
 {
+    // Most sources have nothing to remove, and then they're
+    // handed to the parser without being copied.
+    if (!source.leftRef(XML_DECLARATION_SEARCH_PREFIX_SIZE).contains(QLatin1String("standalone"))) {
+        return source;
+    }
+
     QString prefix = source.left(XML_DECLARATION_SEARCH_PREFIX_SIZE);
     QRegularExpression standalone(STANDALONE_ATTRIBUTE);
     QRegularExpressionMatch match = standalone.match(prefix);
@@ -1073,11 +1203,47 @@ QString XhtmlDoc::PrepareSourceForXerces(const QString &source)
 }
 
 
+xc::XMLGrammarPool *XhtmlDoc::GetGrammarPool()
+{
+    // The pool is never deleted: parsers can be running on other
+    // threads right up until the application exits.
+    static xc::XMLGrammarPool *pool = NULL;
+    QMutexLocker locker(&s_GrammarPoolMutex);
+
+    if (!pool) {
+        pool = CreateGrammarPool();
+    }
+
+    return pool;
+}
+
+
+xc::XMLGrammarPool *XhtmlDoc::CreateGrammarPool()
+{
+    xc::XMLGrammarPool *pool = new xc::XMLGrammarPoolImpl(xc::XMLPlatformUtils::fgMemoryManager);
+    {
+        // Grammars loaded with toCache set end up in the parser's pool.
+        boost::scoped_ptr< xc::SAX2XMLReader > loader(
+            xc::XMLReaderFactory::createXMLReader(xc::XMLPlatformUtils::fgMemoryManager, pool));
+        loader->setProperty(xc::XMLUni::fgXercesScannerName,
+                            (void *) xc::XMLUni::fgDGXMLScanner);
+        xc::MemBufInputSource xhtml_dtd(XHTML_ENTITIES_DTD, XHTML_ENTITIES_DTD_LEN, XHTML_ENTITIES_DTD_ID);
+        loader->loadGrammar(xhtml_dtd, xc::Grammar::DTDGrammarType, true);
+        xc::MemBufInputSource ncx_dtd(fc::NCX_2005_1_DTD, fc::NCX_2005_1_DTD_LEN, fc::NCX_2005_1_DTD_ID);
+        loader->loadGrammar(ncx_dtd, xc::Grammar::DTDGrammarType, true);
+    }
+    // Once locked, the pool is read only and the parsers
+    // share it without any further synchronization.
+    pool->lockPool();
+    return pool;
+}
+
+
 // Returns the node identified by the specified ViewEditor element hierarchy
 xc::DOMNode *XhtmlDoc::GetNodeFromHierarchy(const xc::DOMDocument &document,
         const QList< ViewEditor::ElementIndex > &hierarchy)
 {
-    xc::DOMNode *node = document.getElementsByTagName(QtoX("html"))->item(0);
+    xc::DOMNode *node = document.getElementsByTagName(xn::HTML)->item(0);
     if (node == NULL) {
         return NULL;
     }
@@ -1120,7 +1286,7 @@ xc::DOMNode *XhtmlDoc::GetNodeFromHierarchy(const xc::DOMDocument &document,
 // Creates a ViewEditor element hierarchy from the specified node
 QList< ViewEditor::ElementIndex > XhtmlDoc::GetHierarchyFromNode(const xc::DOMNode &node)
 {
-    xc::DOMNode *html_node = node.getOwnerDocument()->getElementsByTagName(QtoX("html"))->item(0);
+    xc::DOMNode *html_node = node.getOwnerDocument()->getElementsByTagName(xn::HTML)->item(0);
     const xc::DOMNode *current_node = &node;
     QList< ViewEditor::ElementIndex > element_list;
 
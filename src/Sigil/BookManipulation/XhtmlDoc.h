@@ -36,6 +36,11 @@ class QString;
 class QStringList;
 class QXmlStreamReader;
 
+namespace XercesExt
+{
+class LocationAwareDOMParser;
+}
+
 class XhtmlDoc
 {
 
@@ -97,8 +102,46 @@ public:
 
     static QString GetDomNodeAsString(const xc::DOMNode &node);
 
+    /**
+     * Serializes a document. The XML declaration always says UTF-8,
+     * which is how the text is eventually written to disk.
+     */
     static QString GetDomDocumentAsString(const xc::DOMDocument &document);
 
+    /**
+     * Borrows a DOM parser for as long as the handle lives.
+     * Creating a parser sets up a whole scanner, so the parsers are
+     * kept and reused for the next documents instead of being destroyed.
+     * There are never more parsers than threads parsing at the same time.
+     * The parser must only be used by the thread that created the handle.
+     */
+    class ParserHandle
+    {
+
+    public:
+
+        ParserHandle();
+
+        /**
+         * Destructor. Frees any document the parser still owns
+         * and gives the parser back to the pool.
+         */
+        ~ParserHandle();
+
+        XercesExt::LocationAwareDOMParser &GetParser();
+
+    private:
+
+        // Handles can't be copied.
+        ParserHandle(const ParserHandle &);
+        ParserHandle &operator=(const ParserHandle &);
+
+        // Creates a parser configured for XHTML and NCX documents.
+        static XercesExt::LocationAwareDOMParser *CreateParser();
+
+        XercesExt::LocationAwareDOMParser *m_Parser;
+    };
+
     /**
      * Parses the source text into a DOM and returns a shared pointer
      * to the heap-created document.
@@ -249,6 +292,18 @@ private:
     static XMLElement CreateXMLElement(QXmlStreamReader &reader);
 
     static QString PrepareSourceForXerces(const QString &source);
+
+    // Checks the source with a full Xerces parse. Used for the documents
+    // the WellFormedChecker doesn't support.
+    static WellFormedError XercesWellFormedErrorForSource(const QString &source);
+
+    // Returns the grammar pool shared by all the parsers.
+    // It holds the XHTML entities and NCX DTDs already compiled,
+    // and it's locked, so any number of threads can parse against it.
+    static xc::XMLGrammarPool *GetGrammarPool();
+
+    // Creates the grammar pool and caches the DTDs in it.
+    static xc::XMLGrammarPool *CreateGrammarPool();
 };
 
 #endif // XHTMLDOC_H
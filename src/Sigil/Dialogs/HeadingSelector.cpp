@@ -26,6 +26,7 @@
 #include "BookManipulation/Book.h"
 #include "BookManipulation/FolderKeeper.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Dialogs/HeadingSelector.h"
 #include "Misc/SettingsStore.h"
@@ -56,6 +57,7 @@ HeadingSelector::HeadingSelector(QSharedPointer< Book > book, QWidget *parent)
     ConnectSignalsToSlots();
     ui.tvTOCDisplay->setModel(&m_TableOfContents);
     LockHTMLResources();
+    m_Book->GetFolderKeeper().SyncTextsFromDocuments();
     QList< Headings::Heading > flat_headings = Headings::GetHeadingList(
                 m_Book->GetFolderKeeper().GetResourceTypeList< HTMLResource >(true), true);
     m_Headings = Headings::MakeHeadingHeirarchy(flat_headings);
@@ -266,7 +268,7 @@ int HeadingSelector::UpdateOneHeadingElement(QStandardItem *item, QStringList us
     if (heading != NULL) {
         // Update heading inclusion: if a heading element
         // has one of the SIGIL_NOT_IN_TOC_CLASS classes, then it's not in the TOC
-        const QString &class_attribute = XtoQ(heading->element->getAttribute(QtoX("class")));
+        const QString &class_attribute = XtoQ(heading->element->getAttribute(xn::CLASS));
         QString new_class_attribute = QString(class_attribute)
                                       .remove(SIGIL_NOT_IN_TOC_CLASS)
                                       .remove(OLD_SIGIL_NOT_IN_TOC_CLASS)
@@ -281,15 +283,15 @@ int HeadingSelector::UpdateOneHeadingElement(QStandardItem *item, QStringList us
             heading->is_changed = true;
 
             if (!new_class_attribute.isEmpty()) {
-                heading->element->setAttribute(QtoX("class"), QtoX(new_class_attribute));
+                heading->element->setAttribute(xn::CLASS, QtoX(new_class_attribute));
             } else {
-                heading->element->removeAttribute(QtoX("class"));
+                heading->element->removeAttribute(xn::CLASS);
             }
         }
 
         // Now apply the new id as needed.
-        const QString &existing_id_attribute = heading->element->hasAttribute(QtoX("id"))
-                                               ? XtoQ(heading->element->getAttribute(QtoX("id")))
+        const QString &existing_id_attribute = heading->element->hasAttribute(xn::ID)
+                                               ? XtoQ(heading->element->getAttribute(xn::ID))
                                                : QString();
         QString new_id_attribute(existing_id_attribute);
 
@@ -323,9 +325,9 @@ int HeadingSelector::UpdateOneHeadingElement(QStandardItem *item, QStringList us
             heading->is_changed = true;
 
             if (!new_id_attribute.isEmpty()) {
-                heading->element->setAttribute(QtoX("id"), QtoX(new_id_attribute));
+                heading->element->setAttribute(xn::ID, QtoX(new_id_attribute));
             } else {
-                heading->element->removeAttribute(QtoX("id"));
+                heading->element->removeAttribute(xn::ID);
             }
         }
     }
@@ -368,7 +370,7 @@ void HeadingSelector::UpdateOneHeadingTitle(QStandardItem *item, const QString &
         if (title != heading->title) {
             heading->title = title;
             heading->is_changed = true;
-            heading->element->setAttribute(QtoX("title"), QtoX(title));
+            heading->element->setAttribute(xn::TITLE, QtoX(title));
         }
     }
 }
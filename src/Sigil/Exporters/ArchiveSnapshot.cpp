@@ -0,0 +1,117 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+
+#include "Exporters/ArchiveSnapshot.h"
+#include "ResourceObjects/Resource.h"
+
+
+ArchiveSnapshot::ArchiveSnapshot()
+    :
+    m_ArchiveSize(-1),
+    m_ArchiveModified(0)
+{
+}
+
+
+void ArchiveSnapshot::Clear()
+{
+    m_ArchivePath.clear();
+    m_ArchiveSize = -1;
+    m_ArchiveModified = 0;
+    m_Entries.clear();
+}
+
+
+void ArchiveSnapshot::SetArchive(const QString &fullfilepath)
+{
+    QFileInfo info(fullfilepath);
+    m_ArchivePath = info.absoluteFilePath();
+    m_ArchiveSize = info.size();
+    m_ArchiveModified = info.lastModified().isValid() ? info.lastModified().toMSecsSinceEpoch() : 0;
+}
+
+
+QString ArchiveSnapshot::GetArchivePath() const
+{
+    return m_ArchivePath;
+}
+
+
+bool ArchiveSnapshot::IsValid() const
+{
+    if (m_ArchivePath.isEmpty() || m_Entries.isEmpty()) {
+        return false;
+    }
+
+    QFileInfo info(m_ArchivePath);
+
+    if (!info.exists() || info.size() != m_ArchiveSize) {
+        return false;
+    }
+
+    const qint64 modified = info.lastModified().isValid() ? info.lastModified().toMSecsSinceEpoch() : 0;
+    return modified == m_ArchiveModified;
+}
+
+
+void ArchiveSnapshot::AddEntry(const Resource &resource, const QString &entry_name, const QString &encoding)
+{
+    EntryStamp stamp = CurrentStamp(resource, encoding);
+    stamp.entry_name = entry_name;
+    m_Entries[ resource.GetIdentifier() ] = stamp;
+}
+
+
+QString ArchiveSnapshot::GetReusableEntry(const Resource &resource, const QString &encoding) const
+{
+    if (!m_Entries.contains(resource.GetIdentifier())) {
+        return QString();
+    }
+
+    const EntryStamp &saved   = m_Entries[ resource.GetIdentifier() ];
+    const EntryStamp current = CurrentStamp(resource, encoding);
+
+    if (saved.version       != current.version   ||
+        saved.encoding      != current.encoding  ||
+        saved.file_size     != current.file_size ||
+        saved.file_modified != current.file_modified) {
+        return QString();
+    }
+
+    return saved.entry_name;
+}
+
+
+ArchiveSnapshot::EntryStamp ArchiveSnapshot::CurrentStamp(const Resource &resource, const QString &encoding)
+{
+    // The size and timestamp of the file catch the changes made
+    // on disk that never went through the resource.
+    QFileInfo info(resource.GetFullPath());
+    EntryStamp stamp;
+    stamp.encoding = encoding;
+    stamp.version = resource.GetVersion();
+    stamp.file_size = info.exists() ? info.size() : -1;
+    stamp.file_modified = info.lastModified().isValid() ? info.lastModified().toMSecsSinceEpoch() : 0;
+    return stamp;
+}
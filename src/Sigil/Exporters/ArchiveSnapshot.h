@@ -0,0 +1,146 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef ARCHIVESNAPSHOT_H
+#define ARCHIVESNAPSHOT_H
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+
+class Resource;
+
+/**
+ * Remembers what went into the last archive written for a book,
+ * so that the next save can copy the entries of the resources that
+ * haven't changed straight from that archive instead of compressing
+ * them again.
+ *
+ * An entry can be reused when the resource has the same version,
+ * its file on disk has the same size and timestamp, and it was
+ * encoded the same way (compression, font obfuscation) as when
+ * the archive was written. The archive itself must not have been
+ * touched since we wrote it.
+ */
+class ArchiveSnapshot
+{
+
+public:
+
+    /**
+     * Constructor. Creates an empty snapshot.
+     */
+    ArchiveSnapshot();
+
+    /**
+     * Forgets everything about the archive.
+     */
+    void Clear();
+
+    /**
+     * Records the archive the snapshot describes. Must be
+     * called once the archive has been completely written.
+     *
+     * @param fullfilepath The path to the archive.
+     */
+    void SetArchive(const QString &fullfilepath);
+
+    /**
+     * Returns the path to the archive the snapshot describes.
+     *
+     * @return The path to the archive.
+     */
+    QString GetArchivePath() const;
+
+    /**
+     * Checks that the archive still exists and hasn't changed
+     * since it was recorded.
+     *
+     * @return \c true if entries can be copied from the archive.
+     */
+    bool IsValid() const;
+
+    /**
+     * Records that a resource was written to the archive.
+     *
+     * @param resource The resource that was written.
+     * @param entry_name The name of the resource's entry in the archive.
+     * @param encoding Describes how the data was encoded in the entry.
+     */
+    void AddEntry(const Resource &resource, const QString &entry_name, const QString &encoding);
+
+    /**
+     * Returns the name of the archive entry that holds the
+     * current contents of the resource, if there is one.
+     *
+     * @param resource The resource to look for.
+     * @param encoding Describes how the data needs to be encoded.
+     * @return The entry name, or an empty string if the
+     *         resource needs to be compressed again.
+     */
+    QString GetReusableEntry(const Resource &resource, const QString &encoding) const;
+
+private:
+
+    /**
+     * What we know about a resource written to the archive.
+     */
+    struct EntryStamp {
+        QString entry_name;
+        QString encoding;
+        int version;
+        qint64 file_size;
+        qint64 file_modified;
+    };
+
+    /**
+     * Creates the stamp describing the current state of a resource.
+     */
+    static EntryStamp CurrentStamp(const Resource &resource, const QString &encoding);
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    /**
+     * The path to the archive.
+     */
+    QString m_ArchivePath;
+
+    /**
+     * The size of the archive when it was recorded.
+     */
+    qint64 m_ArchiveSize;
+
+    /**
+     * The timestamp of the archive when it was recorded.
+     */
+    qint64 m_ArchiveModified;
+
+    /**
+     * The entries written to the archive. The keys
+     * are the identifiers of the resources.
+     */
+    QHash< QString, EntryStamp > m_Entries;
+};
+
+#endif // ARCHIVESNAPSHOT_H
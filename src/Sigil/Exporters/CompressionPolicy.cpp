@@ -0,0 +1,157 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <zlib.h>
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+
+#include "Exporters/CompressionPolicy.h"
+#include "ResourceObjects/Resource.h"
+#include "sigil_constants.h"
+
+// Besides TIFF, the images FolderKeeper knows that usually aren't compressed.
+static const QStringList BITMAP_EXTENSIONS = QStringList() << "bm" << "bmp";
+
+// Compressed formats that FolderKeeper files as misc resources.
+static const QStringList OTHER_PRECOMPRESSED_EXTENSIONS = QStringList() << "woff" << "woff2" << "zip";
+static const QStringList OTHER_PRECOMPRESSED_MIMETYPES = QStringList()
+        << "application/font-woff" << "application/x-font-woff"
+        << "font/woff" << "font/woff2" << "application/zip";
+
+// The package files, which FolderKeeper creates itself.
+static const QStringList PACKAGE_EXTENSIONS = QStringList() << "opf" << "ncx";
+
+static const int NORMAL_DATA_LEVEL = 8;
+
+
+CompressionPolicy::CompressionPolicy(SettingsStore::CompressionPreset preset, int text_level)
+{
+    switch (preset) {
+        case SettingsStore::CompressionPreset_Fast:
+            m_TextLevel = Z_BEST_SPEED;
+            m_DataLevel = Z_BEST_SPEED;
+            break;
+
+        case SettingsStore::CompressionPreset_Maximum:
+            m_TextLevel = Z_BEST_COMPRESSION;
+            m_DataLevel = Z_BEST_COMPRESSION;
+            break;
+
+        default:
+            m_TextLevel = qBound(Z_BEST_SPEED, text_level, Z_BEST_COMPRESSION);
+            m_DataLevel = NORMAL_DATA_LEVEL;
+    }
+}
+
+
+CompressionPolicy CompressionPolicy::FromSettings()
+{
+    SettingsStore settings;
+    return CompressionPolicy(settings.compressionPreset(), settings.textCompressionLevel());
+}
+
+
+int CompressionPolicy::GetLevel(const QString &archive_path, const Resource *resource, const QString &mimetype) const
+{
+    const QString extension = QFileInfo(archive_path).suffix().toLower();
+    const QString media_type = mimetype.toLower();
+
+    if (IsPrecompressed(extension, resource, media_type)) {
+        return Z_NO_COMPRESSION;
+    }
+
+    if (IsText(extension, resource, media_type)) {
+        return m_TextLevel;
+    }
+
+    return m_DataLevel;
+}
+
+
+int CompressionPolicy::GetTextLevel() const
+{
+    return m_TextLevel;
+}
+
+
+int CompressionPolicy::GetDataLevel() const
+{
+    return m_DataLevel;
+}
+
+
+bool CompressionPolicy::IsPrecompressed(const QString &extension, const Resource *resource, const QString &mimetype)
+{
+    if (resource &&
+        (resource->Type() == Resource::AudioResourceType ||
+         resource->Type() == Resource::VideoResourceType)) {
+        return true;
+    }
+
+    if (AUDIO_MIMETYPES.contains(mimetype) || mimetype.startsWith("audio/") ||
+        VIDEO_MIMETYPES.contains(mimetype) || mimetype.startsWith("video/") ||
+        IMAGE_MIMEYPES.contains(mimetype) || OTHER_PRECOMPRESSED_MIMETYPES.contains(mimetype)) {
+        return true;
+    }
+
+    // Images like BMP and TIFF still compress well,
+    // so images are matched on the extension alone.
+    if (IMAGE_EXTENSIONS.contains(extension)) {
+        return !TIFF_EXTENSIONS.contains(extension) && !BITMAP_EXTENSIONS.contains(extension);
+    }
+
+    return AUDIO_EXTENSIONS.contains(extension) ||
+           VIDEO_EXTENSIONS.contains(extension) ||
+           OTHER_PRECOMPRESSED_EXTENSIONS.contains(extension);
+}
+
+
+bool CompressionPolicy::IsText(const QString &extension, const Resource *resource, const QString &mimetype)
+{
+    if (resource) {
+        switch (resource->Type()) {
+            case Resource::TextResourceType:
+            case Resource::XMLResourceType:
+            case Resource::HTMLResourceType:
+            case Resource::CSSResourceType:
+            case Resource::SVGResourceType:
+            case Resource::OPFResourceType:
+            case Resource::NCXResourceType:
+            case Resource::MiscTextResourceType:
+                return true;
+
+            default:
+                break;
+        }
+    }
+
+    if (TEXT_MIMETYPES.contains(mimetype) || STYLE_MIMETYPES.contains(mimetype) ||
+        SVG_MIMETYPES.contains(mimetype) || mimetype.startsWith("text/") || mimetype.endsWith("+xml")) {
+        return true;
+    }
+
+    return TEXT_EXTENSIONS.contains(extension) ||
+           STYLE_EXTENSIONS.contains(extension) ||
+           SVG_EXTENSIONS.contains(extension) ||
+           MISC_TEXT_EXTENSIONS.contains(extension) ||
+           PACKAGE_EXTENSIONS.contains(extension);
+}
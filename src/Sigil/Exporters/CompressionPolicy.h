@@ -0,0 +1,117 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef COMPRESSIONPOLICY_H
+#define COMPRESSIONPOLICY_H
+
+#include <QtCore/QString>
+
+#include "Misc/SettingsStore.h"
+
+class Resource;
+
+/**
+ * Decides how hard each entry of an EPUB is compressed.
+ *
+ * Media that is already compressed (JPEG, PNG, GIF, audio, video,
+ * WOFF...) is stored as is since deflating it again only costs time.
+ * The text files (XHTML, CSS, the OPF...) are deflated at the text
+ * level, and everything else at the data level.
+ *
+ * Entries are recognized with the same extensions and media types
+ * FolderKeeper uses to create resources, and by the media type the
+ * OPF manifest gives them.
+ */
+class CompressionPolicy
+{
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param preset The compression preset.
+     * @param text_level The deflate level used for text files
+     *                   with the normal preset.
+     */
+    CompressionPolicy(SettingsStore::CompressionPreset preset = SettingsStore::CompressionPreset_Normal,
+                      int text_level = 8);
+
+    /**
+     * Creates the policy the user has chosen in the preferences.
+     *
+     * @return The policy.
+     */
+    static CompressionPolicy FromSettings();
+
+    /**
+     * Returns the deflate level for an entry.
+     *
+     * @param archive_path The path of the entry in the archive.
+     * @param resource The resource the entry is written from, if any.
+     * @param mimetype The media type of the entry in the manifest, if any.
+     * @return The deflate level. Zero means the entry is stored.
+     */
+    int GetLevel(const QString &archive_path,
+                 const Resource *resource = NULL,
+                 const QString &mimetype = QString()) const;
+
+    /**
+     * Returns the deflate level used for text files.
+     */
+    int GetTextLevel() const;
+
+    /**
+     * Returns the deflate level used for binary data
+     * that isn't already compressed.
+     */
+    int GetDataLevel() const;
+
+private:
+
+    /**
+     * Checks whether the data of an entry is already compressed.
+     */
+    static bool IsPrecompressed(const QString &extension, const Resource *resource, const QString &mimetype);
+
+    /**
+     * Checks whether an entry holds text.
+     */
+    static bool IsText(const QString &extension, const Resource *resource, const QString &mimetype);
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    /**
+     * The deflate level used for text files.
+     */
+    int m_TextLevel;
+
+    /**
+     * The deflate level used for binary data.
+     */
+    int m_DataLevel;
+};
+
+#endif // COMPRESSIONPOLICY_H
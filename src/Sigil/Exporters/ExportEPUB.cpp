@@ -23,18 +23,17 @@
 #define NOMINMAX
 #endif
 
-#include <string.h>
+#include <stdio.h>
 #include <zip.h>
 #ifdef _WIN32
 #include <iowin32.h>
 #endif
 
-#include <QtCore/QDateTime>
+#include <QtCore/QBuffer>
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
-#include <QtCore/QTemporaryFile>
 #include <QtCore/QTextStream>
 
 #include "BookManipulation/CleanSource.h"
@@ -42,8 +41,8 @@
 #include "BookManipulation/XhtmlDoc.h"
 #include "Exporters/EncryptionXmlWriter.h"
 #include "Exporters/ExportEPUB.h"
+#include "Exporters/ParallelZipWriter.h"
 #include "Misc/Utility.h"
-#include "Misc/TempFolder.h"
 #include "Misc/FontObfuscation.h"
 #include "ResourceObjects/FontResource.h"
 #include "sigil_constants.h"
@@ -67,11 +66,13 @@ static const QString EPUB_MIME_TYPE = "application/epub+zip";
 
 // Constructor;
 // the first parameter is the location where the book
-// should be save to, and the second is the book to be saved
-ExportEPUB::ExportEPUB(const QString &fullfilepath, QSharedPointer< Book > book)
+// should be save to, the second is the book to be saved
+// and the third decides how hard the files are compressed
+ExportEPUB::ExportEPUB(const QString &fullfilepath, QSharedPointer< Book > book, const CompressionPolicy &compression)
     :
     m_FullFilePath(fullfilepath),
-    m_Book(book)
+    m_Book(book),
+    m_Compression(compression)
 {
 }
 
@@ -94,138 +95,181 @@ void ExportEPUB::WriteBook()
     m_Book->GetOPF().AddSigilVersionMeta();
     m_Book->GetOPF().AddModificationDateMeta();
     m_Book->SaveAllResourcesToDisk();
-    TempFolder tempfolder;
-    CreatePublication(tempfolder.GetPath());
-
-    if (m_Book->HasObfuscatedFonts()) {
-        ObfuscateFonts(tempfolder.GetPath());
-    }
-
-    SaveFolderAsEpubToLocation(tempfolder.GetPath(), m_FullFilePath);
+    SaveBookAsEpubToLocation(m_FullFilePath);
 }
 
 
-// Creates the publication from the Book
-// (creates XHTML, CSS, OPF, NCX files etc.)
-void ExportEPUB::CreatePublication(const QString &fullfolderpath)
+void ExportEPUB::SaveBookAsEpubToLocation(const QString &fullfilepath)
 {
-    Utility::CopyFiles(m_Book->GetFolderKeeper().GetFullPathToMainFolder(), fullfolderpath);
+    // We write the archive next to the destination so that
+    // it can simply be moved in place once it's complete.
+    QFileInfo destination(fullfilepath);
+    QString tempFile = destination.absolutePath() + "/." + destination.fileName() + "." + Utility::CreateUUID() + ".tmp";
+
+    if (!QFileInfo(destination.absolutePath()).isWritable()) {
+        // Only the file itself might be writable.
+        tempFile = Utility::GetTemporaryFileNameWithExtension(".epub");
+    }
 
-    if (m_Book->HasObfuscatedFonts()) {
-        CreateEncryptionXML(fullfolderpath + METAINF_FOLDER_SUFFIX);
+    ArchiveSnapshot &last_saved = m_Book->GetLastSavedArchive();
+    ArchiveSnapshot new_snapshot;
+    bool reuse_entries = last_saved.IsValid();
+
+    try {
+        WriteArchive(tempFile, reuse_entries, new_snapshot);
+    } catch (const ExceptionBase &) {
+        if (!reuse_entries) {
+            throw;
+        }
+
+        // The previous archive may be damaged; compress everything instead.
+        new_snapshot.Clear();
+        WriteArchive(tempFile, false, new_snapshot);
     }
+
+    // The destination is about to be overwritten, so whatever
+    // we knew about it is of no use if something goes wrong.
+    last_saved.Clear();
+    MoveArchiveToLocation(tempFile, fullfilepath);
+    // Remember what went into the archive for the next save.
+    new_snapshot.SetArchive(fullfilepath);
+    last_saved = new_snapshot;
 }
 
-void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &fullfilepath)
+
+void ExportEPUB::WriteArchive(const QString &tempFile, bool reuse_entries, ArchiveSnapshot &snapshot)
 {
-    QString tempFile = fullfolderpath + "-tmp.epub";
-    QDateTime timeNow = QDateTime::currentDateTime();
-    zip_fileinfo fileInfo;
-#ifdef Q_OS_WIN32
-    zlib_filefunc64_def ffunc;
-    fill_win32_filefunc64W(&ffunc);
-    zipFile zfile = zipOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(tempFile)).c_str(), APPEND_STATUS_CREATE, NULL, &ffunc);
-#else
-    zipFile zfile = zipOpen64(QDir::toNativeSeparators(tempFile).toUtf8().constData(), APPEND_STATUS_CREATE);
-#endif
+    const QString fullfolderpath = m_Book->GetFolderKeeper().GetFullPathToMainFolder();
+    const ArchiveSnapshot &last_saved = m_Book->GetLastSavedArchive();
+    const bool has_obfuscated_fonts = m_Book->HasObfuscatedFonts();
+    QHash< QString, Resource * > resources;
 
-    if (zfile == NULL) {
-        boost_throw(CannotOpenFile() << errinfo_file_fullpath(tempFile.toStdString()));
+    foreach(Resource * resource, m_Book->GetFolderKeeper().GetResourceList()) {
+        resources[ resource->GetRelativePath().remove(0, 1) ] = resource;
     }
 
-    memset(&fileInfo, 0, sizeof(fileInfo));
-    fileInfo.tmz_date.tm_sec = timeNow.time().second();
-    fileInfo.tmz_date.tm_min = timeNow.time().minute();
-    fileInfo.tmz_date.tm_hour = timeNow.time().hour();
-    fileInfo.tmz_date.tm_mday = timeNow.date().day();
-    fileInfo.tmz_date.tm_mon = timeNow.date().month() - 1;
-    fileInfo.tmz_date.tm_year = timeNow.date().year();
-
-    // Write the mimetype. This must be uncompressed and the first entry in the archive.
-    if (zipOpenNewFileInZip64(zfile, "mimetype", &fileInfo, NULL, 0, NULL, 0, NULL, Z_NO_COMPRESSION, 0, 0) != Z_OK) {
-        zipClose(zfile, NULL);
-        QFile::remove(tempFile);
-        boost_throw(CannotStoreFile() << errinfo_file_fullpath("mimetype"));
+    QList< ParallelZipWriter::Entry > entries;
+    // The mimetype must be uncompressed and the first entry in the archive.
+    ParallelZipWriter::Entry mimetype;
+    mimetype.archive_path = "mimetype";
+    mimetype.data = EPUB_MIME_TYPE.toUtf8();
+    mimetype.level = Z_NO_COMPRESSION;
+    entries.append(mimetype);
+
+    // An encryption.xml file that is already part of the book wins.
+    if (has_obfuscated_fonts &&
+        !QFile::exists(fullfolderpath + METAINF_FOLDER_SUFFIX + "/" + ENCRYPTION_XML_FILE_NAME)) {
+        ParallelZipWriter::Entry encryption;
+        encryption.archive_path = METAINF_FOLDER_SUFFIX.mid(1) + "/" + ENCRYPTION_XML_FILE_NAME;
+        encryption.data = CreateEncryptionXML();
+        encryption.level = m_Compression.GetLevel(encryption.archive_path);
+        entries.append(encryption);
     }
 
-    const char *mime_data = EPUB_MIME_TYPE.toUtf8().constData();
+    // The entries are compressed concurrently
+    // and written in the order they are listed.
+    ParallelZipWriter zip(tempFile);
 
-    if (zipWriteInFileInZip(zfile, mime_data, (unsigned int)strlen(mime_data)) != Z_OK) {
-        zipCloseFileInZip(zfile);
-        zipClose(zfile, NULL);
-        QFile::remove(tempFile);
-        boost_throw(CannotStoreFile() << errinfo_file_fullpath("mimetype"));
-    }
+    try {
+        reuse_entries = reuse_entries && zip.SetSourceArchive(last_saved.GetArchivePath());
+        // Add all the files in the book's folder to the archive. They are
+        // read straight from the folder, the text resources having just
+        // been saved to disk.
+        QDirIterator it(fullfolderpath, QDir::Files | QDir::NoDotAndDotDot | QDir::Readable | QDir::Hidden, QDirIterator::Subdirectories);
 
-    zipCloseFileInZip(zfile);
-    // Write all the files in our directory path to the archive.
-    QDirIterator it(fullfolderpath, QDir::Files | QDir::NoDotAndDotDot | QDir::Readable | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            QString relpath = it.filePath().remove(fullfolderpath);
 
-    while (it.hasNext()) {
-        it.next();
-        QString relpath = it.filePath().remove(fullfolderpath);
+            while (relpath.startsWith("/")) {
+                relpath = relpath.remove(0, 1);
+            }
 
-        while (relpath.startsWith("/")) {
-            relpath = relpath.remove(0, 1);
-        }
+            ParallelZipWriter::Entry entry;
+            entry.archive_path = relpath;
+            entry.source_path = it.filePath();
+            Resource *resource = resources.value(relpath);
+            const QString mimetype = resource ? m_Book->GetOPF().GetManifestMediaType(*resource) : QString();
+            entry.level = m_Compression.GetLevel(relpath, resource, mimetype);
+
+            // The OPF and NCX change on every save,
+            // so there's no point in tracking them.
+            if (resource &&
+                resource->Type() != Resource::OPFResourceType &&
+                resource->Type() != Resource::NCXResourceType) {
+                const QString encoding = EntryEncoding(*resource, entry.level);
+
+                if (reuse_entries) {
+                    const QString source_entry = last_saved.GetReusableEntry(*resource, encoding);
+
+                    if (!source_entry.isEmpty() && zip.HasSourceEntry(source_entry)) {
+                        entry.source_entry = source_entry;
+                    }
+                }
+
+                snapshot.AddEntry(*resource, relpath, encoding);
+            }
 
-        // Add the file entry to the archive.
-        // We should check the uncompressed file size. If it's over >= 0xffffffff the last parameter (zip64) should be 1.
-        if (zipOpenNewFileInZip4_64(zfile, relpath.toUtf8().constData(), &fileInfo, NULL, 0, NULL, 0, NULL, Z_DEFLATED, 8, 0, 15, 8, Z_DEFAULT_STRATEGY, NULL, 0, 0x0b00, 1<<11, 0) != Z_OK) {
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            boost_throw(CannotStoreFile() << errinfo_file_fullpath(relpath.toStdString()));
-        }
+            FontResource *font_resource = qobject_cast< FontResource * >(resource);
 
-        // Open the file on disk. We will read this and write what we read into
-        // the archive.
-        QFile dfile(it.filePath());
+            if (has_obfuscated_fonts && entry.source_entry.isEmpty() &&
+                font_resource && !font_resource->GetObfuscationAlgorithm().isEmpty()) {
+                entry.data = ObfuscateFont(*font_resource);
+                entry.source_path.clear();
+            }
 
-        if (!dfile.open(QIODevice::ReadOnly)) {
-            zipCloseFileInZip(zfile);
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            boost_throw(CannotOpenFile() << errinfo_file_fullpath(it.fileName().toStdString()));
+            entries.append(entry);
         }
 
-        // Write the data from the file on disk into the archive.
-        char buff[BUFF_SIZE] = {0};
-        qint64 read = 0;
-
-        while ((read = dfile.read(buff, BUFF_SIZE)) > 0) {
-            if (zipWriteInFileInZip(zfile, buff, read) != Z_OK) {
-                dfile.close();
-                zipCloseFileInZip(zfile);
-                zipClose(zfile, NULL);
-                QFile::remove(tempFile);
-                boost_throw(CannotStoreFile() << errinfo_file_fullpath(relpath.toStdString()));
-            }
-        }
+        zip.AddEntries(entries);
+        zip.Close();
+    } catch (...) {
+        zip.Close();
+        QFile::remove(tempFile);
+        throw;
+    }
+}
 
-        dfile.close();
 
-        // There was an error reading the file on disk.
-        if (read < 0) {
-            zipCloseFileInZip(zfile);
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            boost_throw(CannotStoreFile() << errinfo_file_fullpath(relpath.toStdString()));
-        }
+void ExportEPUB::MoveArchiveToLocation(const QString &tempFile, const QString &fullfilepath)
+{
+    QFileInfo destination(fullfilepath);
+    bool moved = false;
+#ifdef Q_OS_MAC
+    // Replacing the file would lose extended attributes such as labels on OS X,
+    // so an existing file gets its contents overwritten instead.
+    const bool overwrite_contents = destination.exists();
+#else
+    // Replacing a link would replace the link itself, not the file it points to.
+    const bool overwrite_contents = destination.isSymLink();
+#endif
 
-        if (zipCloseFileInZip(zfile) != Z_OK) {
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            boost_throw(CannotStoreFile() << errinfo_file_fullpath(relpath.toStdString()));
+    if (!overwrite_contents) {
+        if (destination.exists()) {
+            QFile::setPermissions(tempFile, QFile::permissions(fullfilepath));
         }
+
+        // Replace the destination in one step, so that it's never left half written.
+#ifdef Q_OS_WIN32
+        moved = MoveFileExW(Utility::QStringToStdWString(QDir::toNativeSeparators(tempFile)).c_str(),
+                            Utility::QStringToStdWString(QDir::toNativeSeparators(fullfilepath)).c_str(),
+                            MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        moved = rename(QFile::encodeName(tempFile).constData(), QFile::encodeName(fullfilepath).constData()) == 0;
+#endif
+    }
+
+    if (moved) {
+        return;
     }
 
-    zipClose(zfile, NULL);
     // Overwrite the contents of the real file with the contents from the temp
     // file we saved the data do. We do this instead of simply copying the file
     // because a file copy will lose extended attributes such as labels on OS X.
     QFile temp_epub(tempFile);
 
     if (!temp_epub.open(QFile::ReadOnly)) {
+        QFile::remove(tempFile);
         boost_throw(CannotOpenFile() << errinfo_file_fullpath(tempFile.toStdString()));
     }
 
@@ -233,6 +277,7 @@ void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const
 
     if (!real_epub.open(QFile::WriteOnly | QFile::Truncate)) {
         temp_epub.close();
+        QFile::remove(tempFile);
         boost_throw(CannotWriteFile() << errinfo_file_fullpath(fullfilepath.toStdString()));
     }
 
@@ -265,49 +310,53 @@ void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const
 }
 
 
-void ExportEPUB::CreateEncryptionXML(const QString &fullfolderpath)
+QString ExportEPUB::EntryEncoding(const Resource &resource, int level)
 {
-    QTemporaryFile file;
+    QString encoding = QString::number(level);
+    const FontResource *font_resource = qobject_cast< const FontResource * >(&resource);
 
-    if (!file.open()) {
-        boost_throw(CannotOpenFile()
-                    << errinfo_file_fullpath(file.fileName().toStdString())
-                    << errinfo_file_errorstring(file.errorString().toStdString())
-                   );
+    if (font_resource && !font_resource->GetObfuscationAlgorithm().isEmpty()) {
+        // Obfuscated fonts also depend on the key used.
+        encoding += " " + font_resource->GetObfuscationAlgorithm() + " " + ObfuscationKey(*font_resource);
     }
 
-    EncryptionXmlWriter enc(*m_Book, file);
-    enc.WriteXML();
-    // Write to disk immediately
-    file.flush();
-    QFile::copy(file.fileName(), fullfolderpath + "/" + ENCRYPTION_XML_FILE_NAME);
+    return encoding;
 }
 
 
-void ExportEPUB::ObfuscateFonts(const QString &fullfolderpath)
+QByteArray ExportEPUB::CreateEncryptionXML()
 {
-    QString uuid_id = m_Book->GetOPF().GetUUIDIdentifierValue();
-    QString main_id = m_Book->GetPublicationIdentifier();
-    QList< FontResource * > font_resources = m_Book->GetFolderKeeper().GetResourceTypeList< FontResource >();
-    foreach(FontResource * font_resource, font_resources) {
-        QString algorithm = font_resource->GetObfuscationAlgorithm();
-
-        if (algorithm.isEmpty()) {
-            continue;
-        }
-
-        QString font_path = fullfolderpath + "/" + font_resource->GetRelativePathToRoot();
-
-        if (algorithm == ADOBE_FONT_ALGO_ID) {
-            FontObfuscation::ObfuscateFile(font_path, algorithm, uuid_id);
-        } else {
-            FontObfuscation::ObfuscateFile(font_path, algorithm, main_id);
-        }
-    }
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    EncryptionXmlWriter enc(*m_Book, buffer);
+    enc.WriteXML();
+    buffer.close();
+    return buffer.data();
 }
 
 
+QByteArray ExportEPUB::ObfuscateFont(const FontResource &font_resource)
+{
+    QFile file(font_resource.GetFullPath());
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        boost_throw(CannotOpenFile()
+                    << errinfo_file_fullpath(file.fileName().toStdString())
+                    << errinfo_file_errorstring(file.errorString().toStdString())
+                   );
+    }
 
+    QByteArray data = file.readAll();
+    FontObfuscation::ObfuscateData(data, font_resource.GetObfuscationAlgorithm(), ObfuscationKey(font_resource));
+    return data;
+}
 
 
+QString ExportEPUB::ObfuscationKey(const FontResource &font_resource)
+{
+    if (font_resource.GetObfuscationAlgorithm() == ADOBE_FONT_ALGO_ID) {
+        return m_Book->GetOPF().GetUUIDIdentifierValue();
+    }
 
+    return m_Book->GetPublicationIdentifier();
+}
@@ -25,8 +25,12 @@
 
 #include "BookManipulation/FolderKeeper.h"
 #include "BookManipulation/Book.h"
+#include "Exporters/ArchiveSnapshot.h"
+#include "Exporters/CompressionPolicy.h"
 #include "Exporters/Exporter.h"
 
+class FontResource;
+
 class ExportEPUB : public Exporter
 {
 
@@ -34,8 +38,12 @@ public:
 
     // Constructor;
     // the first parameter is the location where the book
-    // should be save to, and the second is the book to be saved
-    ExportEPUB(const QString &fullfilepath, QSharedPointer< Book > book);
+    // should be save to, the second is the book to be saved
+    // and the third decides how hard the files are compressed;
+    // by default the preset chosen in the preferences is used
+    ExportEPUB(const QString &fullfilepath,
+               QSharedPointer< Book > book,
+               const CompressionPolicy &compression = CompressionPolicy::FromSettings());
 
     // Destructor
     virtual ~ExportEPUB();
@@ -46,22 +54,38 @@ public:
 
 private:
 
-    // Creates the publication from the Book
-    // (creates XHTML, CSS, OPF, NCX files etc.)
-    void virtual CreatePublication(const QString &fullfolderpath);
+    // Saves the book to the specified file path as an epub.
+    // The archive is written to a temporary file first,
+    // which then replaces the file at the path.
+    void SaveBookAsEpubToLocation(const QString &fullfilepath);
+
+    // Writes the archive for the book to a temporary file,
+    // reading the files straight from the book's folder.
+    // If reuse_entries is true, the entries of the resources
+    // that haven't changed since the last save are copied
+    // from the last saved archive. What went into the
+    // archive is recorded in the snapshot.
+    void WriteArchive(const QString &tempFile,
+                      bool reuse_entries,
+                      ArchiveSnapshot &snapshot);
+
+    // Moves the finished archive to the specified file path,
+    // atomically replacing any existing file if possible
+    void MoveArchiveToLocation(const QString &tempFile, const QString &fullfilepath);
 
-    // Saves the publication in the specified folder
-    // to the specified file path as an epub;
-    // the second optional parameter specifies the
-    // mimetype to write to the special "mimetype" file
-    void SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &fullfilepath);
+    // Describes how the resource's data is encoded in
+    // the archive when compressed at the specified level
+    QString EntryEncoding(const Resource &resource, int level);
 
-    // Creates the publication's encryption.xml file,
-    // if there are any fonts to obfuscate
-    void CreateEncryptionXML(const QString &fullfolderpath);
+    // Creates the contents of the publication's encryption.xml file
+    QByteArray CreateEncryptionXML();
 
-    // Obfuscates the fonts marked for obfuscation
-    void ObfuscateFonts(const QString &fullfolderpath);
+    // Returns the obfuscated data of a font marked for obfuscation
+    QByteArray ObfuscateFont(const FontResource &font_resource);
+
+    // Returns the identifier used as the key
+    // when obfuscating the specified font
+    QString ObfuscationKey(const FontResource &font_resource);
 
 
     ///////////////////////////////
@@ -75,6 +99,9 @@ private:
     // The book being exported
     QSharedPointer< Book > m_Book;
 
+    // Decides the compression level of each file
+    CompressionPolicy m_Compression;
+
 };
 
 #endif // EXPORTEPUB_H
@@ -23,6 +23,7 @@
 
 #include "BookManipulation/Book.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "Exporters/NCXWriter.h"
 #include "Misc/Utility.h"
 #include "ResourceObjects/HTMLResource.h"
@@ -159,7 +160,7 @@ NCXModel::NCXEntry NCXWriter::ConvertHeadingWalker(Headings::Heading &heading)
     if (heading.include_in_toc) {
         ncx_child.text = heading.text;
         QString heading_file = heading.resource_file->GetRelativePathToOEBPS();
-        QString existing_ids = XtoQ(heading.element->getAttribute(QtoX("id"))).simplified();
+        QString existing_ids = XtoQ(heading.element->getAttribute(xn::ID)).simplified();
         QString id_to_use = existing_ids;
         foreach(QString id, existing_ids.split(QChar(' '))) {
             if (id.startsWith(SIGIL_TOC_ID_PREFIX)) {
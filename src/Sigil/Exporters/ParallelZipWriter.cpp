@@ -0,0 +1,505 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#ifdef _WIN32
+#define NOMINMAX
+#endif
+
+#include <string.h>
+#include <unzip.h>
+#include <zip.h>
+#ifdef _WIN32
+#include <iowin32.h>
+#endif
+
+#include <QtConcurrent/QtConcurrent>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFuture>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QThread>
+
+#include "Exporters/ParallelZipWriter.h"
+#include "Misc/Utility.h"
+#include "sigil_exception.h"
+
+// Size of the buffers used when compressing and copying data.
+static const int BUFF_SIZE = 65536;
+
+// Compressed entries larger than this are moved
+// out of memory and into a temporary file.
+static const int SPILL_SIZE = 4 * 1024 * 1024;
+
+// The memory level minizip uses for deflate.
+static const int MEM_LEVEL = 8;
+
+// Version made by: 0x0b00 is what we've always written.
+static const uLong VERSION_MADE_BY = 0x0b00;
+
+// General purpose bit 11 says the file name is UTF-8 encoded.
+static const uLong UTF8_FILE_NAME_FLAG = 1 << 11;
+
+#ifndef MAX_PATH
+// Set Max length to 256 because that's the max path size on many systems.
+#define MAX_PATH 256
+#endif
+
+
+ParallelZipWriter::ParallelZipWriter(const QString &fullfilepath)
+    :
+    m_FullFilePath(fullfilepath),
+    m_ZipFile(NULL),
+    m_SourceArchive(NULL)
+{
+#ifdef Q_OS_WIN32
+    zlib_filefunc64_def ffunc;
+    fill_win32_filefunc64W(&ffunc);
+    m_ZipFile = zipOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(m_FullFilePath)).c_str(), APPEND_STATUS_CREATE, NULL, &ffunc);
+#else
+    m_ZipFile = zipOpen64(QDir::toNativeSeparators(m_FullFilePath).toUtf8().constData(), APPEND_STATUS_CREATE);
+#endif
+
+    if (m_ZipFile == NULL) {
+        boost_throw(CannotOpenFile() << errinfo_file_fullpath(m_FullFilePath.toStdString()));
+    }
+
+    QDateTime timeNow = QDateTime::currentDateTime();
+    memset(&m_FileInfo, 0, sizeof(m_FileInfo));
+    m_FileInfo.tmz_date.tm_sec = timeNow.time().second();
+    m_FileInfo.tmz_date.tm_min = timeNow.time().minute();
+    m_FileInfo.tmz_date.tm_hour = timeNow.time().hour();
+    m_FileInfo.tmz_date.tm_mday = timeNow.date().day();
+    m_FileInfo.tmz_date.tm_mon = timeNow.date().month() - 1;
+    m_FileInfo.tmz_date.tm_year = timeNow.date().year();
+}
+
+
+ParallelZipWriter::~ParallelZipWriter()
+{
+    Close();
+}
+
+
+bool ParallelZipWriter::SetSourceArchive(const QString &fullfilepath)
+{
+    if (m_SourceArchive != NULL) {
+        unzClose(m_SourceArchive);
+        m_SourceArchive = NULL;
+        m_SourceEntries.clear();
+    }
+
+#ifdef Q_OS_WIN32
+    zlib_filefunc64_def ffunc;
+    fill_win32_filefunc64W(&ffunc);
+    m_SourceArchive = unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(fullfilepath)).c_str(), &ffunc);
+#else
+    m_SourceArchive = unzOpen64(QDir::toNativeSeparators(fullfilepath).toUtf8().constData());
+#endif
+
+    if (m_SourceArchive == NULL) {
+        return false;
+    }
+
+    // Read the central directory once so the entries can be found quickly.
+    int res = unzGoToFirstFile(m_SourceArchive);
+
+    while (res == UNZ_OK) {
+        char file_name[MAX_PATH] = {0};
+        unz_file_info64 file_info;
+        unz64_file_pos position;
+
+        if (unzGetCurrentFileInfo64(m_SourceArchive, &file_info, file_name, MAX_PATH, NULL, 0, NULL, 0) != UNZ_OK ||
+            unzGetFilePos64(m_SourceArchive, &position) != UNZ_OK) {
+            break;
+        }
+
+        m_SourceEntries[ QString::fromUtf8(file_name) ] = position;
+        res = unzGoToNextFile(m_SourceArchive);
+    }
+
+    if (res != UNZ_END_OF_LIST_OF_FILE) {
+        unzClose(m_SourceArchive);
+        m_SourceArchive = NULL;
+        m_SourceEntries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+bool ParallelZipWriter::HasSourceEntry(const QString &entry_name) const
+{
+    return m_SourceEntries.contains(entry_name);
+}
+
+
+void ParallelZipWriter::AddEntries(const QList< Entry > &entries)
+{
+    // We keep the workers busy with the entries ahead of the one
+    // currently being written, but not too far ahead so that we
+    // don't hold the whole book in memory.
+    const int max_pending = qMax(2, QThread::idealThreadCount() * 2);
+    QList< QFuture< CompressedEntry > > pending;
+    QList< QSharedPointer< QTemporaryFile > > spill_files;
+    int next = 0;
+
+    try {
+        for (int i = 0; i < entries.count(); ++i) {
+            while (next < entries.count() && next < i + max_pending) {
+                if (entries.at(next).level == 0 || !entries.at(next).source_entry.isEmpty()) {
+                    pending.append(QFuture< CompressedEntry >());
+                    spill_files.append(QSharedPointer< QTemporaryFile >());
+                } else {
+                    QSharedPointer< QTemporaryFile > spill_file = CreateSpillFile(entries.at(next));
+                    const QString &spill_path = spill_file ? spill_file->fileName() : QString();
+                    pending.append(QtConcurrent::run(&ParallelZipWriter::CompressEntry, entries.at(next), spill_path));
+                    spill_files.append(spill_file);
+                }
+
+                ++next;
+            }
+
+            if (!entries.at(i).source_entry.isEmpty()) {
+                CopySourceEntry(entries.at(i));
+            } else if (entries.at(i).level == 0) {
+                WriteStoredEntry(entries.at(i));
+            } else {
+                CompressedEntry compressed = pending.at(i).result();
+                // Release the result held by the future.
+                pending[ i ] = QFuture< CompressedEntry >();
+                WriteCompressedEntry(entries.at(i), compressed, spill_files.at(i).data());
+                spill_files[ i ].clear();
+            }
+        }
+    } catch (...) {
+        // The workers must not outlive the files they are reading.
+        for (int i = 0; i < pending.count(); ++i) {
+            pending[ i ].waitForFinished();
+        }
+
+        throw;
+    }
+}
+
+
+void ParallelZipWriter::Close()
+{
+    if (m_SourceArchive != NULL) {
+        unzClose(m_SourceArchive);
+        m_SourceArchive = NULL;
+        m_SourceEntries.clear();
+    }
+
+    if (m_ZipFile == NULL) {
+        return;
+    }
+
+    zipClose(m_ZipFile, NULL);
+    m_ZipFile = NULL;
+}
+
+
+QSharedPointer< QTemporaryFile > ParallelZipWriter::CreateSpillFile(const Entry &entry)
+{
+    // Deflate hardly ever makes data larger, so only the entries
+    // bigger than the spill size can end up in a spill file.
+    const qint64 size = entry.source_path.isEmpty() ? entry.data.size() : QFileInfo(entry.source_path).size();
+
+    if (size <= SPILL_SIZE) {
+        return QSharedPointer< QTemporaryFile >();
+    }
+
+    QSharedPointer< QTemporaryFile > spill_file(new QTemporaryFile());
+
+    // The file keeps its name once it's closed. The worker opens it
+    // on its own, and it's opened again here once it has been written.
+    if (!spill_file->open()) {
+        return QSharedPointer< QTemporaryFile >();
+    }
+
+    spill_file->close();
+    return spill_file;
+}
+
+
+ParallelZipWriter::CompressedEntry ParallelZipWriter::CompressEntry(const Entry &entry, const QString &spill_path)
+{
+    CompressedEntry compressed;
+    QFile spill_file(spill_path);
+    const bool from_file = !entry.source_path.isEmpty();
+    QFile source(entry.source_path);
+
+    if (from_file && !source.open(QIODevice::ReadOnly)) {
+        compressed.cannot_open = true;
+        return compressed;
+    }
+
+    // Negative window bits make deflate write raw data without
+    // a zlib header, which is what goes into a zip entry.
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (deflateInit2(&stream, entry.level, Z_DEFLATED, -MAX_WBITS, MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+        compressed.failed = true;
+        return compressed;
+    }
+
+    QByteArray in_buff(from_file ? BUFF_SIZE : 0, 0);
+    QByteArray out_buff(BUFF_SIZE, 0);
+    qint64 offset = 0;
+    int flush = Z_NO_FLUSH;
+    compressed.crc = crc32(0L, Z_NULL, 0);
+
+    do {
+        const char *in_data = NULL;
+        qint64 in_length = 0;
+
+        if (from_file) {
+            in_length = source.read(in_buff.data(), BUFF_SIZE);
+
+            if (in_length < 0) {
+                compressed.failed = true;
+                break;
+            }
+
+            in_data = in_buff.constData();
+            flush = in_length == 0 || source.atEnd() ? Z_FINISH : Z_NO_FLUSH;
+        } else {
+            in_length = qMin< qint64 >(BUFF_SIZE, entry.data.size() - offset);
+            in_data = entry.data.constData() + offset;
+            offset += in_length;
+            flush = offset >= entry.data.size() ? Z_FINISH : Z_NO_FLUSH;
+        }
+
+        compressed.crc = crc32(compressed.crc, (const Bytef *)in_data, (uInt)in_length);
+        compressed.uncompressed_size += in_length;
+        stream.next_in = (Bytef *)in_data;
+        stream.avail_in = (uInt)in_length;
+
+        // Run deflate until it stops filling the whole output buffer.
+        do {
+            stream.next_out = (Bytef *)out_buff.data();
+            stream.avail_out = BUFF_SIZE;
+
+            if (deflate(&stream, flush) == Z_STREAM_ERROR) {
+                compressed.failed = true;
+                break;
+            }
+
+            const int have = BUFF_SIZE - stream.avail_out;
+
+            if (have > 0 && !AppendCompressedData(compressed, spill_file, out_buff.constData(), have)) {
+                compressed.failed = true;
+                break;
+            }
+        } while (stream.avail_out == 0);
+    } while (!compressed.failed && flush != Z_FINISH);
+
+    deflateEnd(&stream);
+
+    if (compressed.spilled) {
+        if (!spill_file.flush()) {
+            compressed.failed = true;
+        }
+
+        spill_file.close();
+    }
+
+    return compressed;
+}
+
+
+bool ParallelZipWriter::AppendCompressedData(CompressedEntry &compressed, QFile &spill_file, const char *data, int length)
+{
+    compressed.compressed_size += length;
+
+    if (!compressed.spilled) {
+        // Entries without a spill file stay in memory whatever their size.
+        if (spill_file.fileName().isEmpty() || compressed.data.size() + length <= SPILL_SIZE) {
+            compressed.data.append(data, length);
+            return true;
+        }
+
+        if (!spill_file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+            spill_file.write(compressed.data) != compressed.data.size()) {
+            return false;
+        }
+
+        compressed.data.clear();
+        compressed.spilled = true;
+    }
+
+    return spill_file.write(data, length) == length;
+}
+
+
+void ParallelZipWriter::WriteStoredEntry(const Entry &entry)
+{
+    const bool from_file = !entry.source_path.isEmpty();
+    QFile source(entry.source_path);
+
+    if (from_file && !source.open(QIODevice::ReadOnly)) {
+        boost_throw(CannotOpenFile() << errinfo_file_fullpath(entry.source_path.toStdString()));
+    }
+
+    OpenRawEntry(entry, 0, from_file ? source.size() : entry.data.size());
+    unsigned long crc = crc32(0L, Z_NULL, 0);
+    quint64 written = 0;
+
+    if (from_file) {
+        QByteArray buff(BUFF_SIZE, 0);
+        qint64 read = 0;
+
+        while ((read = source.read(buff.data(), BUFF_SIZE)) > 0) {
+            if (zipWriteInFileInZip(m_ZipFile, buff.constData(), (unsigned int)read) != ZIP_OK) {
+                boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+            }
+
+            crc = crc32(crc, (const Bytef *)buff.constData(), (uInt)read);
+            written += read;
+        }
+
+        // There was an error reading the file on disk.
+        if (read < 0) {
+            boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+        }
+    } else if (!entry.data.isEmpty()) {
+        if (zipWriteInFileInZip(m_ZipFile, entry.data.constData(), (unsigned int)entry.data.size()) != ZIP_OK) {
+            boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+        }
+
+        crc = crc32(crc, (const Bytef *)entry.data.constData(), (uInt)entry.data.size());
+        written = entry.data.size();
+    }
+
+    CloseRawEntry(entry, written, crc);
+}
+
+
+void ParallelZipWriter::WriteCompressedEntry(const Entry &entry, const CompressedEntry &compressed, QTemporaryFile *spill_file)
+{
+    if (compressed.cannot_open) {
+        boost_throw(CannotOpenFile() << errinfo_file_fullpath(entry.source_path.toStdString()));
+    }
+
+    if (compressed.failed) {
+        boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+    }
+
+    OpenRawEntry(entry, Z_DEFLATED, compressed.uncompressed_size);
+
+    if (compressed.spilled) {
+        QByteArray buff(BUFF_SIZE, 0);
+        qint64 read = 0;
+
+        if (!spill_file || !spill_file->open()) {
+            boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+        }
+
+        while ((read = spill_file->read(buff.data(), BUFF_SIZE)) > 0) {
+            if (zipWriteInFileInZip(m_ZipFile, buff.constData(), (unsigned int)read) != ZIP_OK) {
+                boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+            }
+        }
+
+        if (read < 0) {
+            boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+        }
+    } else if (!compressed.data.isEmpty()) {
+        if (zipWriteInFileInZip(m_ZipFile, compressed.data.constData(), (unsigned int)compressed.data.size()) != ZIP_OK) {
+            boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+        }
+    }
+
+    CloseRawEntry(entry, compressed.uncompressed_size, compressed.crc);
+}
+
+
+void ParallelZipWriter::CopySourceEntry(const Entry &entry)
+{
+    if (m_SourceArchive == NULL || !m_SourceEntries.contains(entry.source_entry)) {
+        boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+    }
+
+    unz64_file_pos position = m_SourceEntries.value(entry.source_entry);
+    unz_file_info64 file_info;
+    int method = 0;
+    int level = 0;
+
+    // Opening the entry in raw mode gives us the compressed data as is.
+    if (unzGoToFilePos64(m_SourceArchive, &position) != UNZ_OK ||
+        unzGetCurrentFileInfo64(m_SourceArchive, &file_info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK ||
+        unzOpenCurrentFile2(m_SourceArchive, &method, &level, 1) != UNZ_OK) {
+        boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+    }
+
+    Entry raw_entry = entry;
+    raw_entry.level = level;
+
+    try {
+        OpenRawEntry(raw_entry, method, file_info.uncompressed_size);
+        QByteArray buff(BUFF_SIZE, 0);
+        int read = 0;
+
+        while ((read = unzReadCurrentFile(m_SourceArchive, buff.data(), BUFF_SIZE)) > 0) {
+            if (zipWriteInFileInZip(m_ZipFile, buff.constData(), (unsigned int)read) != ZIP_OK) {
+                boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+            }
+        }
+
+        // Read errors are marked by a negative read amount.
+        if (read < 0) {
+            boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+        }
+    } catch (...) {
+        unzCloseCurrentFile(m_SourceArchive);
+        throw;
+    }
+
+    unzCloseCurrentFile(m_SourceArchive);
+    CloseRawEntry(entry, file_info.uncompressed_size, file_info.crc);
+}
+
+
+void ParallelZipWriter::OpenRawEntry(const Entry &entry, int method, quint64 uncompressed_size)
+{
+    // The level is only used by minizip to set the deflate option bits
+    // in the header, the data itself is already compressed.
+    const int level = method == Z_DEFLATED ? entry.level : 0;
+    const int zip64 = uncompressed_size >= 0xffffffff ? 1 : 0;
+
+    if (zipOpenNewFileInZip4_64(m_ZipFile, entry.archive_path.toUtf8().constData(), &m_FileInfo, NULL, 0, NULL, 0, NULL,
+                                method, level, 1, -MAX_WBITS, MEM_LEVEL, Z_DEFAULT_STRATEGY, NULL, 0,
+                                VERSION_MADE_BY, UTF8_FILE_NAME_FLAG, zip64) != ZIP_OK) {
+        boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+    }
+}
+
+
+void ParallelZipWriter::CloseRawEntry(const Entry &entry, quint64 uncompressed_size, unsigned long crc)
+{
+    if (zipCloseFileInZipRaw64(m_ZipFile, uncompressed_size, crc) != ZIP_OK) {
+        boost_throw(CannotStoreFile() << errinfo_file_fullpath(entry.archive_path.toStdString()));
+    }
+}
@@ -0,0 +1,255 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef PARALLELZIPWRITER_H
+#define PARALLELZIPWRITER_H
+
+#include <unzip.h>
+#include <zip.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+
+class QFile;
+class QTemporaryFile;
+
+/**
+ * Writes a zip archive, compressing the entries concurrently.
+ *
+ * Every entry is deflated on its own z_stream by a worker thread
+ * into a memory buffer (or a temporary file for large entries).
+ * The temporary files are created and read by the calling thread,
+ * the workers only write to them through their own QFile.
+ * The calling thread is the only one touching the archive: it writes
+ * the already compressed data as raw entries, in the order the
+ * entries were given, so the output does not depend on scheduling.
+ *
+ * Entries can also be copied as they are from another archive,
+ * without inflating and deflating them again.
+ */
+class ParallelZipWriter
+{
+
+public:
+
+    /**
+     * Describes an entry to be added to the archive.
+     */
+    struct Entry {
+        /**
+         * The path of the entry inside the archive.
+         */
+        QString archive_path;
+
+        /**
+         * The file on disk with the contents of the entry.
+         * If empty, the contents are taken from data.
+         */
+        QString source_path;
+
+        /**
+         * The contents of the entry, if they are held in memory.
+         */
+        QByteArray data;
+
+        /**
+         * The deflate level to use. Zero stores the entry uncompressed.
+         */
+        int level;
+
+        /**
+         * If set, the entry is copied from the entry with this
+         * name in the source archive and all the other
+         * members but archive_path are ignored.
+         * @see SetSourceArchive()
+         */
+        QString source_entry;
+
+        Entry() : level(Z_DEFAULT_COMPRESSION) {}
+    };
+
+    /**
+     * Constructor. Creates the archive.
+     *
+     * @param fullfilepath The path to the archive to create.
+     * @throws CannotOpenFile if the archive can't be created.
+     */
+    ParallelZipWriter(const QString &fullfilepath);
+
+    /**
+     * Destructor. Closes the archive if that hasn't been done yet.
+     */
+    ~ParallelZipWriter();
+
+    /**
+     * Opens the archive entries can be copied from.
+     *
+     * @param fullfilepath The path to the archive.
+     * @return \c true if the archive could be read.
+     */
+    bool SetSourceArchive(const QString &fullfilepath);
+
+    /**
+     * Checks whether the source archive has an entry.
+     *
+     * @param entry_name The name of the entry in the source archive.
+     * @return \c true if the entry can be copied.
+     */
+    bool HasSourceEntry(const QString &entry_name) const;
+
+    /**
+     * Adds the entries to the archive. The entries are written
+     * in the order they are listed.
+     *
+     * @throws CannotOpenFile if the source of an entry can't be read.
+     * @throws CannotStoreFile if an entry can't be written.
+     */
+    void AddEntries(const QList< Entry > &entries);
+
+    /**
+     * Closes the archive, and the source archive if one is open.
+     * It's safe to call this more than once.
+     */
+    void Close();
+
+private:
+
+    /**
+     * The result of compressing an entry.
+     */
+    struct CompressedEntry {
+        /**
+         * The compressed data, unless it was spilled to disk.
+         */
+        QByteArray data;
+
+        /**
+         * Set if the compressed data was written to the spill file.
+         */
+        bool spilled;
+
+        quint64 uncompressed_size;
+        quint64 compressed_size;
+        unsigned long crc;
+
+        /**
+         * Set if the source could not be read.
+         */
+        bool cannot_open;
+
+        /**
+         * Set if the data could not be compressed.
+         */
+        bool failed;
+
+        CompressedEntry()
+            : spilled(false), uncompressed_size(0), compressed_size(0), crc(0),
+              cannot_open(false), failed(false) {}
+    };
+
+    /**
+     * Creates the temporary file the compressed data of an entry
+     * goes to if it gets large. Entries too small to ever need
+     * one get a null pointer.
+     */
+    static QSharedPointer< QTemporaryFile > CreateSpillFile(const Entry &entry);
+
+    /**
+     * Deflates an entry. This runs on the worker threads.
+     *
+     * @param entry The entry to compress.
+     * @param spill_path The path of the spill file, or an empty
+     *                   string to keep all the data in memory.
+     * @return The compressed entry.
+     */
+    static CompressedEntry CompressEntry(const Entry &entry, const QString &spill_path);
+
+    /**
+     * Appends compressed data to the output of an entry,
+     * moving the output to the spill file once it gets large.
+     *
+     * @return \c false if the data could not be written.
+     */
+    static bool AppendCompressedData(CompressedEntry &compressed, QFile &spill_file, const char *data, int length);
+
+    /**
+     * Writes an entry that is stored without compression.
+     * The data is streamed from its source straight into the archive.
+     */
+    void WriteStoredEntry(const Entry &entry);
+
+    /**
+     * Writes an entry that has already been compressed.
+     */
+    void WriteCompressedEntry(const Entry &entry, const CompressedEntry &compressed, QTemporaryFile *spill_file);
+
+    /**
+     * Copies an entry from the source archive without recompressing it.
+     */
+    void CopySourceEntry(const Entry &entry);
+
+    /**
+     * Opens a new raw entry in the archive.
+     */
+    void OpenRawEntry(const Entry &entry, int method, quint64 uncompressed_size);
+
+    /**
+     * Closes the current raw entry.
+     */
+    void CloseRawEntry(const Entry &entry, quint64 uncompressed_size, unsigned long crc);
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    /**
+     * The path to the archive being written.
+     */
+    QString m_FullFilePath;
+
+    /**
+     * The archive being written.
+     */
+    zipFile m_ZipFile;
+
+    /**
+     * The timestamp used for all the entries.
+     */
+    zip_fileinfo m_FileInfo;
+
+    /**
+     * The archive entries are copied from, if any.
+     */
+    unzFile m_SourceArchive;
+
+    /**
+     * The positions of the entries in the source archive.
+     * The keys are the entry names.
+     */
+    QHash< QString, unz64_file_pos > m_SourceEntries;
+};
+
+#endif // PARALLELZIPWRITER_H
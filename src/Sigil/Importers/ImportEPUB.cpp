@@ -47,6 +47,7 @@
 
 #include "BookManipulation/FolderKeeper.h"
 #include "BookManipulation/Metadata.h"
+#include "BookManipulation/XhtmlDoc.h"
 #include "Importers/ImportEPUB.h"
 #include "Misc/FontObfuscation.h"
 #include "Misc/HTMLEncodingResolver.h"
@@ -76,6 +77,10 @@ static const QString OEBPS_MIMETYPE      = "application/oebps-package+xml";
 static const QString UPDATE_ERROR_STRING = "SG_ERROR";
 const QString NCX_MIMETYPE               = "application/x-dtbncx+xml";
 static const QString NCX_EXTENSION       = "ncx";
+// Archive entries with these extensions are extracted into memory
+// rather than to disk, since we read them back as text anyway.
+static const QStringList TEXT_ENTRY_EXTENSIONS = QStringList() << "xhtml" << "html" << "htm" << "xml"
+                                                               << "css"   << "opf"  << "ncx";
 const QString ADOBE_FONT_ALGO_ID         = "http://ns.adobe.com/pdf/enc#RC";
 const QString IDPF_FONT_ALGO_ID          = "http://www.idpf.org/2008/embedding";
 static const QString CONTAINER_XML       = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
@@ -87,6 +92,35 @@ static const QString CONTAINER_XML       = "<?xml version=\"1.0\" encoding=\"UTF
 
 static QCodePage437Codec *cp437 = 0; 
 
+namespace
+{
+    /**
+     * An HTML file that needs to be checked for well-formedness.
+     * The file path is only set if the file wasn't extracted
+     * into memory and has to be read from disk.
+     */
+    struct HTMLSource {
+        QString fullfilepath;
+        QByteArray data;
+    };
+
+    /**
+     * Runs on the worker threads. The decoded text
+     * is only kept for the duration of the check.
+     */
+    bool IsHTMLSourceWellFormed(const HTMLSource &source)
+    {
+        try {
+            const QString text = source.fullfilepath.isEmpty() ?
+                                 HTMLEncodingResolver::ReadHTMLData(source.data) :
+                                 HTMLEncodingResolver::ReadHTMLFile(source.fullfilepath);
+            return XhtmlDoc::IsDataWellFormed(text);
+        } catch (...) {
+            return false;
+        }
+    }
+}
+
 // Constructor;
 // The parameter is the file to be imported
 ImportEPUB::ImportEPUB(const QString &fullfilepath)
@@ -128,34 +162,64 @@ QSharedPointer<Book> ImportEPUB::GetBook()
     const QHash<QString, QString> updates = LoadFolderStructure();
     const QList<Resource *> resources     = m_Book->GetFolderKeeper().GetResourceList();
 
-    // We're going to check all html files until we find one that isn't well formed then we'll prompt
+    // The text resources were created from the in-memory copies of the archive
+    // entries, so we need to know which entry each resource was loaded from.
+    QHash<QString, QString> new_to_old_paths;
+    foreach(QString old_path, updates.keys()) {
+        new_to_old_paths[ updates.value(old_path) ] = old_path;
+    }
+
+    // We're going to check all html files for well-formedness and then we'll prompt
     // the user if they want to auto fix or not.
     //
     // If we have non-well formed content and they shouldn't be auto fixed we'll pass that on to
     // the universal update function so it knows to skip them. Otherwise we won't include them and
     // let it modify the file.
+    //
+    // The HTML files are not loaded into their resources: the check decodes a transient
+    // copy of each file and the updates work on the files in the book folder, so the
+    // text of a chapter is only kept in memory once a tab or a search needs it.
+    QList<HTMLResource *> html_resources;
+    QList<HTMLSource> html_sources;
+
     for (int i=0; i<resources.count(); ++i) {
-        if (resources.at(i)->Type() == Resource::HTMLResourceType) {
+        const QString text_key = ExtractedTextKey(new_to_old_paths.value("../" + resources.at(i)->GetRelativePathToOEBPS()));
+
+        if (resources.at(i)->Type() == Resource::CSSResourceType && !text_key.isEmpty()) {
+            CSSResource *cresource = dynamic_cast<CSSResource *>(resources.at(i));
+            if (cresource) {
+                cresource->SetText(Utility::ReadUnicodeTextData(m_ExtractedText.value(text_key)));
+            }
+        }
+        if (resources.at(i)->Type() == Resource::HTMLResourceType && (ss.cleanOn() & CLEANON_OPEN)) {
             HTMLResource *hresource = dynamic_cast<HTMLResource *>(resources.at(i));
             if (!hresource) {
                 continue;
             }
-            // Load the content into the HTMLResource so we can perform a well formed check.
-            try {
-                hresource->SetText(HTMLEncodingResolver::ReadHTMLFile(hresource->GetFullPath()));
-            } catch(...) {
-                if (ss.cleanOn() & CLEANON_OPEN) {
-                    non_well_formed << hresource;
-                    continue;
-                }
+            HTMLSource source;
+            if (text_key.isEmpty()) {
+                source.fullfilepath = hresource->GetFullPath();
+            } else {
+                source.data = m_ExtractedText.value(text_key);
             }
-            if (ss.cleanOn() & CLEANON_OPEN) {
-                if (!XhtmlDoc::IsDataWellFormed(hresource->GetText())) {
-                    non_well_formed << hresource;
-                }
+            html_resources.append(hresource);
+            html_sources.append(source);
+        }
+    }
+
+    if (!html_sources.isEmpty()) {
+        const QList<bool> well_formed = QtConcurrent::blockingMapped(html_sources, IsHTMLSourceWellFormed);
+
+        for (int i = 0; i < well_formed.count(); ++i) {
+            if (!well_formed.at(i)) {
+                non_well_formed << html_resources.at(i);
             }
         }
+        html_sources.clear();
     }
+    // Everything that needed the in-memory copies has been checked.
+    m_ExtractedText.clear();
+
     if (!non_well_formed.isEmpty()) {
         QApplication::restoreOverrideCursor();
         if (QMessageBox::Yes == QMessageBox::warning(QApplication::activeWindow(),
@@ -211,11 +275,11 @@ QHash<QString, QString> ImportEPUB::ParseEncryptionXml()
 {
     QString encrpytion_xml_path = m_ExtractedFolderPath + "/META-INF/encryption.xml";
 
-    if (!QFileInfo(encrpytion_xml_path).exists()) {
+    if (!ExtractedFileExists(encrpytion_xml_path)) {
         return QHash<QString, QString>();
     }
 
-    QXmlStreamReader encryption(Utility::ReadUnicodeTextFile(encrpytion_xml_path));
+    QXmlStreamReader encryption(ReadExtractedTextFile(encrpytion_xml_path));
     QHash<QString, QString> encrypted_files;
     QString encryption_algo;
     QString uri;
@@ -293,7 +357,7 @@ void ImportEPUB::AddNonStandardAppleXML()
     aberrant_Apple_filenames.append(m_ExtractedFolderPath + "/META-INF/com.apple.ibooks.display-options.xml");
 
     for (int i = 0; i < aberrant_Apple_filenames.size(); ++i) {
-        if (QFile::exists(aberrant_Apple_filenames.at(i))) {
+        if (ExtractedFileExists(aberrant_Apple_filenames.at(i))) {
             m_Files[ Utility::CreateUUID() ]  = opf_dir.relativeFilePath(aberrant_Apple_filenames.at(i));
         }
     }
@@ -352,24 +416,130 @@ void ImportEPUB::ProcessFontFiles(const QList<Resource *> &resources,
     }
 }
 
+namespace
+{
+    /**
+     * An entry of the archive's central directory,
+     * along with the outcome of extracting it.
+     */
+    struct ArchiveEntry {
+        unz64_file_pos position;
+        quint64 compressed_size;
+        QString file_name;
+        QString cp437_file_name;
+        QString file_path;
+        bool in_memory;
+        bool skip;
+        QByteArray text_data;
+        QString error;
+    };
+
+
+    unzFile OpenArchive(const QString &fullfilepath)
+    {
+#ifdef Q_OS_WIN32
+        zlib_filefunc64_def ffunc;
+        fill_win32_filefunc64W(&ffunc);
+        return unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(fullfilepath)).c_str(), &ffunc);
+#else
+        return unzOpen64(QDir::toNativeSeparators(fullfilepath).toUtf8().constData());
+#endif
+    }
+
+
+    // Inflates one entry into memory or into its file on disk.
+    // Returns false if anything went wrong.
+    bool ExtractOneEntry(unzFile zfile, ArchiveEntry &entry)
+    {
+        if (unzGoToFilePos64(zfile, &entry.position) != UNZ_OK ||
+            unzOpenCurrentFile(zfile) != UNZ_OK) {
+            return false;
+        }
+
+        QFile file(entry.file_path);
+
+        if (!entry.in_memory && !file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            unzCloseCurrentFile(zfile);
+            return false;
+        }
+
+        // Buffered reading and writing.
+        char buff[BUFF_SIZE] = {0};
+        int read = 0;
+
+        while ((read = unzReadCurrentFile(zfile, buff, BUFF_SIZE)) > 0) {
+            if (entry.in_memory) {
+                entry.text_data.append(buff, read);
+            } else {
+                file.write(buff, read);
+            }
+        }
+
+        if (!entry.in_memory) {
+            file.close();
+        }
+
+        // Read errors are marked by a negative read amount.
+        if (read < 0) {
+            unzCloseCurrentFile(zfile);
+            return false;
+        }
+
+        // The file was read but the CRC did not match.
+        // We don't check the read file size vs the uncompressed file size
+        // because if they're different there should be a CRC error.
+        return unzCloseCurrentFile(zfile) != UNZ_CRCERROR;
+    }
+
+
+    // Worker for the parallel extraction. Every worker opens its own handle
+    // to the archive since a minizip handle can't be shared across threads.
+    // The entries are only touched in [first, last), so there's no locking.
+    void ExtractEntryRange(const QString &fullfilepath, ArchiveEntry *entries, int first, int last)
+    {
+        unzFile zfile = OpenArchive(fullfilepath);
+
+        if (zfile == NULL) {
+            entries[ first ].error = QString(QObject::tr("Cannot unzip EPUB: %1")).arg(QDir::toNativeSeparators(fullfilepath));
+            return;
+        }
+
+        for (int i = first; i < last; ++i) {
+            if (entries[ i ].skip) {
+                continue;
+            }
+
+            if (!ExtractOneEntry(zfile, entries[ i ])) {
+                entries[ i ].error = QString(QObject::tr("Cannot extract file: %1")).arg(entries[ i ].file_name);
+                break;
+            }
+        }
+
+        unzClose(zfile);
+    }
+}
+
+
 void ImportEPUB::ExtractContainer()
 {
     int res = 0;
     if (!cp437) {
         cp437 = new QCodePage437Codec();
     }
-#ifdef Q_OS_WIN32
-    zlib_filefunc64_def ffunc;
-    fill_win32_filefunc64W(&ffunc);
-    unzFile zfile = unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(m_FullFilePath)).c_str(), &ffunc);
-#else
-    unzFile zfile = unzOpen64(QDir::toNativeSeparators(m_FullFilePath).toUtf8().constData());
-#endif
+    unzFile zfile = OpenArchive(m_FullFilePath);
 
     if (zfile == NULL) {
         boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(QString(QObject::tr("Cannot unzip EPUB: %1")).arg(QDir::toNativeSeparators(m_FullFilePath)).toStdString()));
     }
 
+    // First we read the central directory and create the folder structure.
+    // That's cheap and done serially, the inflating is then spread
+    // over several threads.
+    QVector< ArchiveEntry > entries;
+    QHash< QString, int > entry_for_path;
+    // We use the dir object to create the path in the temporary directory.
+    // Unfortunately, we need a dir ojbect to do this as it's not a static function.
+    QDir dir(m_ExtractedFolderPath);
     res = unzGoToFirstFile(zfile);
 
     if (res == UNZ_OK) {
@@ -378,102 +548,175 @@ void ImportEPUB::ExtractContainer()
             char file_name[MAX_PATH] = {0};
             unz_file_info64 file_info;
             unzGetCurrentFileInfo64(zfile, &file_info, file_name, MAX_PATH, NULL, 0, NULL, 0);
-            QString qfile_name;
-            QString cp437_file_name;
-            qfile_name = QString::fromUtf8(file_name);
+            ArchiveEntry entry;
+            entry.file_name = QString::fromUtf8(file_name);
             if (!(file_info.flag & (1<<11))) {
                 // General purpose bit 11 says the filename is utf-8 encoded. If not set then
                 // IBM 437 encoding might be used.
-                cp437_file_name = cp437->toUnicode(file_name);
+                entry.cp437_file_name = cp437->toUnicode(file_name);
             }
 
             // If there is no file name then we can't do anything with it.
-            if (!qfile_name.isEmpty()) {
-                // We use the dir object to create the path in the temporary directory.
-                // Unfortunately, we need a dir ojbect to do this as it's not a static function.
-                QDir dir(m_ExtractedFolderPath);
-                // Full file path in the temporary directory.
-                QString file_path = m_ExtractedFolderPath + "/" + qfile_name;
-                QFileInfo qfile_info(file_path);
-
-                // Is this entry a directory?
-                if (file_info.uncompressed_size == 0 && qfile_name.endsWith('/')) {
-                    dir.mkpath(qfile_name);
-                    continue;
-                } else {
-                    dir.mkpath(qfile_info.path());
-                }
+            if (entry.file_name.isEmpty()) {
+                continue;
+            }
 
-                // Open the file entry in the archive for reading.
-                if (unzOpenCurrentFile(zfile) != UNZ_OK) {
-                    unzClose(zfile);
-                    boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
+            // Full file path in the temporary directory.
+            entry.file_path = m_ExtractedFolderPath + "/" + entry.file_name;
+            QFileInfo qfile_info(entry.file_path);
 
-                // Open the file on disk to write the entry in the archive to.
-                QFile entry(file_path);
+            // Is this entry a directory?
+            if (file_info.uncompressed_size == 0 && entry.file_name.endsWith('/')) {
+                dir.mkpath(entry.file_name);
+                continue;
+            } else {
+                dir.mkpath(qfile_info.path());
+            }
 
-                if (!entry.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-                    unzCloseCurrentFile(zfile);
-                    unzClose(zfile);
-                    boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
+            unzGetFilePos64(zfile, &entry.position);
+            entry.compressed_size = file_info.compressed_size;
+            // Text entries are inflated straight into memory, everything
+            // else is written to the file on disk.
+            entry.in_memory = TEXT_ENTRY_EXTENSIONS.contains(qfile_info.suffix().toLower());
+            entry.skip = false;
 
-                // Buffered reading and writing.
-                char buff[BUFF_SIZE] = {0};
-                int read = 0;
+            // An archive can list the same name more than once. Only the last
+            // one used to survive, and two workers must not write the same file.
+            const QString clean_path = QDir::cleanPath(entry.file_path);
 
-                while ((read = unzReadCurrentFile(zfile, buff, BUFF_SIZE)) > 0) {
-                    entry.write(buff, read);
-                }
+            if (entry_for_path.contains(clean_path)) {
+                entries[ entry_for_path.value(clean_path) ].skip = true;
+            }
 
-                entry.close();
+            entry_for_path[ clean_path ] = entries.count();
+            entries.append(entry);
+        } while ((res = unzGoToNextFile(zfile)) == UNZ_OK);
+    }
 
-                // Read errors are marked by a negative read amount.
-                if (read < 0) {
-                    unzCloseCurrentFile(zfile);
-                    unzClose(zfile);
-                    boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
+    unzClose(zfile);
 
-                // The file was read but the CRC did not match.
-                // We don't check the read file size vs the uncompressed file size
-                // because if they're different there should be a CRC error.
-                if (unzCloseCurrentFile(zfile) == UNZ_CRCERROR) {
-                    unzClose(zfile);
-                    boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
+    if (res != UNZ_END_OF_LIST_OF_FILE) {
+        boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(QString(QObject::tr("Cannot open EPUB: %1")).arg(QDir::toNativeSeparators(m_FullFilePath)).toStdString()));
+    }
 
-                if (!cp437_file_name.isEmpty() && cp437_file_name != qfile_name) {
-                    QString cp437_file_path = m_ExtractedFolderPath + "/" + cp437_file_name;
-                    QFile::copy(file_path, cp437_file_path);
-                }
+    // Split the entries into contiguous ranges of roughly the same
+    // compressed size, one for each worker.
+    quint64 total_size = 0;
+
+    foreach(const ArchiveEntry &entry, entries) {
+        total_size += entry.compressed_size;
+    }
+
+    const int num_workers = qMax(1, qMin(QThread::idealThreadCount(), entries.count()));
+    const quint64 range_size = total_size / num_workers + 1;
+    ArchiveEntry *entry_data = entries.data();
+    QFutureSynchronizer< void > sync;
+    int first = 0;
+    quint64 current_size = 0;
+
+    for (int i = 0; i < entries.count(); ++i) {
+        current_size += entries.at(i).compressed_size;
+
+        if (current_size >= range_size || i == entries.count() - 1) {
+            sync.addFuture(QtConcurrent::run(ExtractEntryRange, m_FullFilePath, entry_data, first, i + 1));
+            first = i + 1;
+            current_size = 0;
+        }
+    }
+
+    sync.waitForFinished();
+
+    // Errors are reported for the first failing entry in archive order,
+    // and the results are collected in that same order.
+    for (int i = 0; i < entries.count(); ++i) {
+        const ArchiveEntry &entry = entries.at(i);
+
+        if (!entry.error.isEmpty()) {
+            boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(entry.error.toStdString()));
+        }
+
+        if (entry.skip) {
+            continue;
+        }
+
+        if (entry.in_memory) {
+            m_ExtractedText[ QDir::cleanPath(entry.file_path) ] = entry.text_data;
+        }
+
+        if (!entry.cp437_file_name.isEmpty() && entry.cp437_file_name != entry.file_name) {
+            QString cp437_file_path = m_ExtractedFolderPath + "/" + entry.cp437_file_name;
+
+            if (entry.in_memory) {
+                m_ExtractedText[ QDir::cleanPath(cp437_file_path) ] = entry.text_data;
+            } else {
+                QFile::copy(entry.file_path, cp437_file_path);
             }
-        } while ((res = unzGoToNextFile(zfile)) == UNZ_OK);
+        }
     }
+}
 
-    if (res != UNZ_END_OF_LIST_OF_FILE) {
-        unzClose(zfile);
-        boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(QString(QObject::tr("Cannot open EPUB: %1")).arg(QDir::toNativeSeparators(m_FullFilePath)).toStdString()));
+
+QString ImportEPUB::ExtractedTextKey(const QString &fullfilepath) const
+{
+    QString key = QDir::cleanPath(fullfilepath);
+
+    if (m_ExtractedText.contains(key)) {
+        return key;
     }
 
-    unzClose(zfile);
+    if (!TEXT_ENTRY_EXTENSIONS.contains(QFileInfo(key).suffix().toLower())) {
+        return QString();
+    }
+
+#if defined(Q_OS_WIN32) || defined(Q_OS_MAC)
+    // On case insensitive file systems a reference with the wrong
+    // case used to find the extracted file, so keep accepting it.
+    foreach(QString extracted_key, m_ExtractedText.keys()) {
+        if (extracted_key.compare(key, Qt::CaseInsensitive) == 0) {
+            return extracted_key;
+        }
+    }
+#endif
+
+    return QString();
+}
+
+
+bool ImportEPUB::ExtractedFileExists(const QString &fullfilepath) const
+{
+    return !ExtractedTextKey(fullfilepath).isEmpty() || QFile::exists(fullfilepath);
+}
+
+
+QString ImportEPUB::ReadExtractedTextFile(const QString &fullfilepath) const
+{
+    QString key = ExtractedTextKey(fullfilepath);
+
+    if (key.isEmpty()) {
+        return Utility::ReadUnicodeTextFile(fullfilepath);
+    }
+
+    return Utility::ReadUnicodeTextData(m_ExtractedText.value(key));
 }
 
+
 void ImportEPUB::LocateOPF()
 {
     QString fullpath = m_ExtractedFolderPath + "/META-INF/container.xml";
     QXmlStreamReader container;
     try {
-        container.addData(Utility::ReadUnicodeTextFile(fullpath));
+        container.addData(ReadExtractedTextFile(fullpath));
     }
     catch (CannotOpenFile) {
-        // Find the first OPF file.
+        // Find the first OPF file. OPF files are always extracted into memory.
         QString OPFfile;
-        QDirIterator files(m_ExtractedFolderPath, QStringList() << "*.opf", QDir::NoFilter, QDirIterator::Subdirectories);
-        while (files.hasNext()) {
-            OPFfile = QDir(m_ExtractedFolderPath).relativeFilePath(files.next());
-            break;
+        QStringList extracted_paths = m_ExtractedText.keys();
+        extracted_paths.sort();
+        foreach(QString extracted_path, extracted_paths) {
+            if (extracted_path.endsWith(".opf", Qt::CaseInsensitive)) {
+                OPFfile = QDir(m_ExtractedFolderPath).relativeFilePath(extracted_path);
+                break;
+            }
         }
 
         if (OPFfile.isEmpty()) {
@@ -483,10 +726,8 @@ void ImportEPUB::LocateOPF()
         }
 
         // Create a default container.xml.
-        QDir folder(m_ExtractedFolderPath);
-        folder.mkdir("META-INF");
-        Utility::WriteUnicodeTextFile(CONTAINER_XML.arg(OPFfile), fullpath);
-        container.addData(Utility::ReadUnicodeTextFile(fullpath));
+        m_ExtractedText[ QDir::cleanPath(fullpath) ] = CONTAINER_XML.arg(OPFfile).toUtf8();
+        container.addData(ReadExtractedTextFile(fullpath));
     }
 
     while (!container.atEnd()) {
@@ -515,7 +756,7 @@ void ImportEPUB::LocateOPF()
         boost_throw(EPUBLoadParseError() << errinfo_epub_load_parse_errors(error.toStdString()));
     }
 
-    if (m_OPFFilePath.isEmpty() || !QFile::exists(m_OPFFilePath)) {
+    if (m_OPFFilePath.isEmpty() || !ExtractedFileExists(m_OPFFilePath)) {
         boost_throw(EPUBLoadParseError()
                     << errinfo_epub_load_parse_errors(QString(QObject::tr("No appropriate OPF file found")).toStdString()));
     }
@@ -524,7 +765,7 @@ void ImportEPUB::LocateOPF()
 
 void ImportEPUB::ReadOPF()
 {
-    QString opf_text = PrepareOPFForReading(Utility::ReadUnicodeTextFile(m_OPFFilePath));
+    QString opf_text = PrepareOPFForReading(ReadExtractedTextFile(m_OPFFilePath));
     QXmlStreamReader opf_reader(opf_text);
     QString ncx_id_on_spine;
 
@@ -656,7 +897,7 @@ void ImportEPUB::LocateOrCreateNCX(const QString &ncx_id_on_spine)
 
     m_NCXFilePath = QFileInfo(m_OPFFilePath).absolutePath() % "/" % ncx_href;
 
-    if (ncx_href.isEmpty() || !QFile::exists(m_NCXFilePath)) {
+    if (ncx_href.isEmpty() || !ExtractedFileExists(m_NCXFilePath)) {
         m_NCXNotInManifest = m_NCXId.isEmpty() || ncx_href.isEmpty();
         m_NCXId.clear();
         // Things are really bad and no .ncx file was found in the manifest or
@@ -690,8 +931,8 @@ void ImportEPUB::LocateOrCreateNCX(const QString &ncx_id_on_spine)
 
 void ImportEPUB::LoadInfrastructureFiles()
 {
-    m_Book->GetOPF().SetText(PrepareOPFForReading(Utility::ReadUnicodeTextFile(m_OPFFilePath)));
-    m_Book->GetNCX().SetText(Utility::ReadUnicodeTextFile(m_NCXFilePath));
+    m_Book->GetOPF().SetText(PrepareOPFForReading(ReadExtractedTextFile(m_OPFFilePath)));
+    m_Book->GetNCX().SetText(ReadExtractedTextFile(m_NCXFilePath));
 }
 
 
@@ -728,9 +969,14 @@ QHash<QString, QString> ImportEPUB::LoadFolderStructure()
 tuple<QString, QString> ImportEPUB::LoadOneFile(const QString &path, const QString &mimetype)
 {
     QString fullfilepath = QFileInfo(m_OPFFilePath).absolutePath() + "/" + path;
-    
+    QString text_key = ExtractedTextKey(fullfilepath);
+
     try {
-        Resource &resource = m_Book->GetFolderKeeper().AddContentFileToFolder(fullfilepath, false, mimetype);
+        // Text files go from memory straight into the book folder, and the
+        // files extracted to disk are moved there instead of being copied.
+        Resource &resource = text_key.isEmpty() ?
+                             m_Book->GetFolderKeeper().AddContentFileToFolder(fullfilepath, false, mimetype, true) :
+                             m_Book->GetFolderKeeper().AddContentDataToFolder(fullfilepath, m_ExtractedText.value(text_key), false, mimetype);
         QString newpath = "../" + resource.GetRelativePathToOEBPS();
         return make_tuple(fullfilepath, newpath);
     } catch (FileDoesNotExist &) {
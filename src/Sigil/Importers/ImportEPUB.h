@@ -27,6 +27,7 @@
 #include <boost/tuple/tuple.hpp>
 
 #include <QCoreApplication>
+#include <QtCore/QByteArray>
 #include <QtCore/QHash>
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
@@ -57,9 +58,37 @@ private:
      * Extracts the EPUB file to a temporary folder.
      * The path to the the temp folder with the extracted files
      * is stored in m_ExtractedFolderPath.
+     * The central directory is read once and the entries
+     * are then inflated in parallel, each worker thread
+     * using its own handle to the archive.
      */
     void ExtractContainer();
 
+    /**
+     * Returns the key of the in-memory copy of an extracted file.
+     *
+     * @param fullfilepath The path the file has in the extracted folder.
+     * @return The key into m_ExtractedText, or an empty string if the
+     *         file was not extracted into memory.
+     */
+    QString ExtractedTextKey(const QString &fullfilepath) const;
+
+    /**
+     * Checks whether a file was extracted from the archive,
+     * either into memory or into the extracted folder.
+     *
+     * @param fullfilepath The path the file has in the extracted folder.
+     */
+    bool ExtractedFileExists(const QString &fullfilepath) const;
+
+    /**
+     * Reads an extracted text file, preferring the in-memory copy.
+     *
+     * @param fullfilepath The path the file has in the extracted folder.
+     * @return The decoded text of the file.
+     */
+    QString ReadExtractedTextFile(const QString &fullfilepath) const;
+
     /**
      * Locates the OPF file in the extracted folder.
      * The path to the OPF is then stored in m_OPFFilePath.
@@ -170,6 +199,14 @@ private:
      */
     QString m_ExtractedFolderPath;
 
+    /**
+     * The contents of the text entries of the archive (XHTML, CSS, OPF,
+     * NCX...). These are inflated straight into memory instead of being
+     * written to the extracted folder. The keys are the (clean) paths
+     * the files would have in m_ExtractedFolderPath.
+     */
+    QHash< QString, QByteArray > m_ExtractedText;
+
     /**
      * The full path to the OPF file
      * of the publication.
@@ -32,6 +32,7 @@
 #include "BookManipulation/FolderKeeper.h"
 #include "BookManipulation/Metadata.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Importers/ImportHTML.h"
 #include "Misc/HTMLEncodingResolver.h"
@@ -228,7 +229,7 @@ QHash< QString, QString > ImportHTML::LoadStyleFiles(const xc::DOMDocument *docu
         xc::DOMElement &element = *link_nodes.at(i);
         Q_ASSERT(&element);
         QDir folder(QFileInfo(m_FullFilePath).absoluteDir());
-        QString relative_path = Utility::URLDecodePath(XtoQ(element.getAttribute(QtoX("href"))));
+        QString relative_path = Utility::URLDecodePath(XtoQ(element.getAttribute(xn::HREF)));
         QFileInfo file_info(folder, relative_path);
 
         if (file_info.suffix().toLower() == "css") {
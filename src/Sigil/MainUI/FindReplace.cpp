@@ -731,6 +731,11 @@ QList <Resource *> FindReplace::GetHTMLFiles()
     return resources;
 }
 
+QList <Resource *> FindReplace::GetFilesPossiblyMatching(const QList <Resource *> &resources)
+{
+    return m_MainWindow.GetCurrentBook()->GetFolderKeeper().GetResourcesPossiblyMatching(GetSearchRegex(), resources);
+}
+
 int FindReplace::CountInFiles()
 {
     // For now, this must hold
@@ -744,7 +749,7 @@ int FindReplace::CountInFiles()
     }
     return SearchOperations::CountInFiles(
                GetSearchRegex(),
-               html_files,
+               GetFilesPossiblyMatching(html_files),
                SearchOperations::CodeViewSearch);
 }
 
@@ -762,7 +767,7 @@ int FindReplace::ReplaceInAllFiles()
     int count = SearchOperations::ReplaceInAllFIles(
                     GetSearchRegex(),
                     ui.cbReplace->lineEdit()->text(),
-                    html_files,
+                    GetFilesPossiblyMatching(html_files),
                     SearchOperations::CodeViewSearch);
     return count;
 }
@@ -837,6 +842,8 @@ HTMLResource *FindReplace::GetNextContainingHTMLResource(Searchable::Direction d
         }
     }
 
+    // Only the files the search index can't rule out are searched.
+    const QSet<Resource *> &candidates = GetFilesPossiblyMatching(resources).toSet();
     HTMLResource *next_html_resource = starting_html_resource;
     bool passed_starting_html_resource = false;
 
@@ -851,7 +858,7 @@ HTMLResource *FindReplace::GetNextContainingHTMLResource(Searchable::Direction d
         }
 
         if (next_html_resource) {
-            if (ResourceContainsCurrentRegex(next_html_resource)) {
+            if (candidates.contains(next_html_resource) && ResourceContainsCurrentRegex(next_html_resource)) {
                 return next_html_resource;
             }
 
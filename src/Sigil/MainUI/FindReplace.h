@@ -195,6 +195,9 @@ private:
 
     QList <Resource *> GetHTMLFiles();
 
+    // Leaves out the files the search index rules out.
+    QList <Resource *> GetFilesPossiblyMatching(const QList <Resource *> &resources);
+
     bool IsCurrentFileInHTMLSelection();
 
     void SetKeyModifiers();
@@ -315,9 +318,9 @@ bool FindReplace::ResourceContainsCurrentRegex(T *resource)
     // For now, this must hold
     Q_ASSERT(GetLookWhere() == FindReplace::LookWhere_AllHTMLFiles || GetLookWhere() == FindReplace::LookWhere_SelectedHTMLFiles);
     Resource *generic_resource = resource;
-    return SearchOperations::CountInFiles(
+    return SearchOperations::CountInFile(
                GetSearchRegex(),
-               QList< Resource * >() << generic_resource,
+               generic_resource,
                SearchOperations::CodeViewSearch,
                m_SpellCheck) > 0;
 }
@@ -1891,6 +1891,7 @@ void MainWindow::UpdateWord(QString old_word, QString new_word)
         }
     }
 
+    m_Book->GetFolderKeeper().SyncTextsFromDocuments();
     WordUpdates::UpdateWordInAllFiles(html_resources, old_word, new_word);
     m_Book->SetModified();
     m_SpellcheckEditor->Refresh();
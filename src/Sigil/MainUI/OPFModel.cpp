@@ -363,7 +363,15 @@ bool OPFModel:: RenameResourceList(QList<Resource *> resources, QList<QString> n
     }
 
     if (update.count() > 0) {
-        UniversalUpdates::PerformUniversalUpdates(true, m_Book->GetFolderKeeper().GetResourceList(), update);
+        // Only the files referencing the renamed ones need updating,
+        // along with the OPF and NCX that list every file.
+        FolderKeeper &folder_keeper = m_Book->GetFolderKeeper();
+        QList< Resource * > resources = folder_keeper.GetResourcesReferencing(update.keys());
+        resources.append(&folder_keeper.GetOPF());
+        resources.append(&folder_keeper.GetNCX());
+        // The updates run on worker threads, which don't see the open tabs.
+        folder_keeper.SyncTextsFromDocuments();
+        UniversalUpdates::PerformUniversalUpdates(true, resources, update);
         emit BookContentModified();
     }
 
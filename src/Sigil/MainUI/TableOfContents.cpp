@@ -32,6 +32,7 @@
 #include "MainUI/TableOfContents.h"
 #include "Misc/Utility.h"
 #include "ResourceObjects/NCXResource.h"
+#include "ResourceObjects/TextUpdateQueue.h"
 #include "sigil_constants.h"
 #include "sigil_exception.h"
 
@@ -64,6 +65,8 @@ TableOfContents::TableOfContents(QWidget *parent)
             this,            SLOT(Refresh()));
     connect(&m_NCXModel, SIGNAL(RefreshDone()),
             this,            SLOT(ExpandAll()));
+    connect(TextUpdateQueue::instance(), SIGNAL(ResourcesUpdated(const QList<TextResource *> &)),
+            this,                        SLOT(PendingResourcesUpdated(const QList<TextResource *> &)));
 }
 
 void TableOfContents::showEvent(QShowEvent *event)
@@ -82,6 +85,14 @@ void TableOfContents::SetBook(QSharedPointer< Book > book)
 }
 
 
+void TableOfContents::PendingResourcesUpdated(const QList< TextResource * > &resources)
+{
+    if (m_Book && resources.contains(&m_Book->GetNCX())) {
+        StartRefreshDelay();
+    }
+}
+
+
 void TableOfContents::Refresh()
 {
     m_NCXModel.Refresh();
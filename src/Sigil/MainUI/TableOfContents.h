@@ -36,6 +36,7 @@ class QTimer;
 class QTreeView;
 class QVBoxLayout;
 class QWidget;
+class TextResource;
 
 /**
  * Represents the pane in which the book's NCX TOC is rendered.
@@ -98,6 +99,14 @@ private slots:
 
     void CollapseAll();
 
+    /**
+     * Refreshes the TOC if the NCX was among the resources
+     * updated from other threads.
+     *
+     * @param resources The updated resources.
+     */
+    void PendingResourcesUpdated(const QList< TextResource * > &resources);
+
     void ExpandAll();
 
 protected:
@@ -55,45 +55,25 @@ QByteArray AdobeKeyFromIdentifier(const QString &identifier)
 }
 
 
-void IdpfObfuscate(const QString &filepath, const QString &identifier)
+void IdpfObfuscate(QByteArray &contents, const QString &identifier)
 {
-    QFile file(filepath);
-
-    if (!file.open(QFile::ReadWrite)) {
-        return;
-    }
-
-    QByteArray contents = file.readAll();
     QByteArray key = IdpfKeyFromIdentifier(identifier);
     int key_size   = key.size();
 
     for (int i = 0; (i < IDPF_METHOD_NUM_BYTES) && (i < contents.size()); ++i) {
         contents[ i ] = contents[ i ] ^ key[ i % key_size ];
     }
-
-    file.seek(0);
-    file.write(contents);
 }
 
 
-void AdobeObfuscate(const QString &filepath, const QString &identifier)
+void AdobeObfuscate(QByteArray &contents, const QString &identifier)
 {
-    QFile file(filepath);
-
-    if (!file.open(QFile::ReadWrite)) {
-        return;
-    }
-
-    QByteArray contents = file.readAll();
     QByteArray key = AdobeKeyFromIdentifier(identifier);
     int key_size   = key.size();
 
     for (int i = 0; (i < ADOBE_METHOD_NUM_BYTES) && (i < contents.size()); ++i) {
         contents[ i ] = contents[ i ] ^ key[ i % key_size ];
     }
-
-    file.seek(0);
-    file.write(contents);
 }
 
 };
@@ -113,13 +93,43 @@ void FontObfuscation::ObfuscateFile(const QString &filepath,
                    );
     }
 
+    QFile file(filepath);
+
+    if (!file.open(QFile::ReadWrite)) {
+        return;
+    }
+
+    QByteArray contents = file.readAll();
+
+    try {
+        ObfuscateData(contents, algorithm, identifier);
+    } catch (FontObfuscationError &error) {
+        error << errinfo_font_filepath(filepath.toStdString());
+        throw;
+    }
+
+    file.seek(0);
+    file.write(contents);
+}
+
+
+void FontObfuscation::ObfuscateData(QByteArray &data,
+                                    const QString &algorithm,
+                                    const QString &identifier)
+{
+    if (algorithm.isEmpty() || identifier.isEmpty()) {
+        boost_throw(FontObfuscationError()
+                    << errinfo_font_obfuscation_algorithm(algorithm.toStdString())
+                    << errinfo_font_obfuscation_key(identifier.toStdString())
+                   );
+    }
+
     if (algorithm == ADOBE_FONT_ALGO_ID) {
-        AdobeObfuscate(filepath, identifier);
+        AdobeObfuscate(data, identifier);
     } else if (algorithm == IDPF_FONT_ALGO_ID) {
-        IdpfObfuscate(filepath, identifier);
+        IdpfObfuscate(data, identifier);
     } else {
         boost_throw(FontObfuscationError()
-                    << errinfo_font_filepath(filepath.toStdString())
                     << errinfo_font_obfuscation_algorithm(algorithm.toStdString())
                     << errinfo_font_obfuscation_key(identifier.toStdString())
                    );
@@ -23,6 +23,7 @@
 #ifndef FONTOBFUSCATION_H
 #define FONTOBFUSCATION_H
 
+class QByteArray;
 class QString;
 
 namespace FontObfuscation
@@ -30,6 +31,12 @@ namespace FontObfuscation
 void ObfuscateFile(const QString &filepath,
                    const QString &algorithm,
                    const QString &identifier);
+
+// Same as ObfuscateFile, but transforms the
+// font data in memory instead of the file.
+void ObfuscateData(QByteArray &data,
+                   const QString &algorithm,
+                   const QString &identifier);
 }
 
 #endif // FONTOBFUSCATION_H
@@ -20,6 +20,8 @@
 **
 *************************************************************************/
 
+#include <string.h>
+
 #include <QtCore/QFile>
 #include <QtCore/QString>
 #include <QtCore/QTextCodec>
@@ -36,6 +38,9 @@ const QString CHARSET_ATTRIBUTE    = "charset\\s*=\\s*(?:\"|')([^\"']+)(?:\"|')"
 const QString STANDALONE_ATTRIBUTE = "standalone\\s*=\\s*(?:\"|')([^\"']+)(?:\"|')";
 const QString VERSION_ATTRIBUTE    = "version\\s*=\\s*(?:\"|')([^\"']+)(?:\"|')";
 
+// The IANA MIBenum of UTF-8, as used by QTextCodec.
+static const int UTF8_MIB = 106;
+
 
 // Accepts a full path to an HTML file.
 // Reads the file, detects the encoding
@@ -52,7 +57,40 @@ QString HTMLEncodingResolver::ReadHTMLFile(const QString &fullfilepath)
                    );
     }
 
-    QByteArray data = file.readAll();
+    // The file is decoded straight from its mapping
+    // instead of being read into a buffer first.
+    const qint64 size = file.size();
+
+    if (Utility::CanMapFile(file)) {
+        uchar *mapped = file.map(0, size);
+
+        if (mapped) {
+            const QString text = ReadHTMLData(QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size));
+            file.unmap(mapped);
+            return text;
+        }
+    }
+
+    return ReadHTMLData(file.readAll());
+}
+
+
+// Same as ReadHTMLFile, but for HTML
+// that is already held in memory.
+QString HTMLEncodingResolver::ReadHTMLData(const QByteArray &raw_data)
+{
+    // UTF-8 files are validated and decoded in a single pass that
+    // also converts the line endings and the non-breaking spaces.
+    const QTextCodec *declared_codec = GetDeclaredCodecForHTML(raw_data);
+    QString text;
+
+    if ((!declared_codec || declared_codec->mibEnum() == UTF8_MIB) &&
+        Utility::DecodeUtf8Text(raw_data.constData(), raw_data.size(), text, true)) {
+        return text;
+    }
+
+    // Anything else goes through the codec.
+    QByteArray data = raw_data;
 
     if (IsValidUtf8(data)) {
         data.replace("\xC2\xA0", "&#160;");
@@ -67,6 +105,27 @@ QString HTMLEncodingResolver::ReadHTMLFile(const QString &fullfilepath)
 // We use this function because Qt's QTextCodec::codecForHtml() function
 // leaves a *lot* to be desired.
 const QTextCodec *HTMLEncodingResolver::GetCodecForHTML(const QByteArray &raw_text)
+{
+    const QTextCodec *codec = GetDeclaredCodecForHTML(raw_text);
+
+    if (codec) {
+        return codec;
+    }
+
+    // See if all characters within this document are utf-8.
+    if (IsValidUtf8(raw_text)) {
+        return QTextCodec::codecForName("UTF-8");
+    }
+
+    // Finally, let Qt guess and if it doesn't know it will return the codec
+    // for the current locale.
+    return QTextCodec::codecForHtml(raw_text, QTextCodec::codecForLocale());
+}
+
+
+// Returns the encoding given by the BOM or declared in the first
+// bytes of the HTML stream, or NULL if there is none.
+const QTextCodec *HTMLEncodingResolver::GetDeclaredCodecForHTML(const QByteArray &raw_text)
 {
     unsigned char c1;
     unsigned char c2;
@@ -124,15 +183,7 @@ const QTextCodec *HTMLEncodingResolver::GetCodecForHTML(const QByteArray &raw_te
         }
     }
 
-    // See if all characters within this document are utf-8.
-    if (IsValidUtf8(raw_text)) {
-        return QTextCodec::codecForName("UTF-8");
-    }
-
-    // Finally, let Qt guess and if it doesn't know it will return the codec
-    // for the current locale.
-    text = raw_text;
-    return QTextCodec::codecForHtml(raw_text, QTextCodec::codecForLocale());
+    return NULL;
 }
 
 
@@ -153,16 +204,14 @@ bool HTMLEncodingResolver::IsValidUtf8(const QByteArray &string)
         return false;
     }
 
+    const unsigned char *data = (const unsigned char *) string.constData();
+    const int size = string.size();
     int index = 0;
 
-    while (index < string.size()) {
-        QByteArray dword = string.mid(index, 4);
-
-        if (dword.size() < 4) {
-            dword = dword.leftJustified(4, '\0');
-        }
-
-        const unsigned char *bytes = (const unsigned char *) dword.constData();
+    while (index < size) {
+        // The missing bytes at the end are read as zeros.
+        unsigned char bytes[4] = { 0, 0, 0, 0 };
+        memcpy(bytes, data + index, qMin(4, size - index));
 
         // ASCII
         if (bytes[0] == 0x09 ||
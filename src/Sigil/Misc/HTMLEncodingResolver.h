@@ -23,6 +23,7 @@
 #ifndef HTMLEncodingResolver_H
 #define HTMLEncodingResolver_H
 
+class QByteArray;
 class QString;
 
 class HTMLEncodingResolver
@@ -35,6 +36,10 @@ public:
     // and returns the text converted to Unicode.
     static QString ReadHTMLFile(const QString &fullfilepath);
 
+    // Same as ReadHTMLFile, but for HTML
+    // that is already held in memory.
+    static QString ReadHTMLData(const QByteArray &raw_data);
+
 private:
 
     // Accepts an HTML stream and tries to determine its encoding;
@@ -43,6 +48,10 @@ private:
     // leaves a *lot* to be desired.
     static const QTextCodec *GetCodecForHTML(const QByteArray &raw_text);
 
+    // Returns the encoding given by the BOM or declared in the first
+    // bytes of the HTML stream, or NULL if there is none.
+    static const QTextCodec *GetDeclaredCodecForHTML(const QByteArray &raw_text);
+
     // This function goes through the entire byte array
     // and tries to see whether this is a valid UTF-8 sequence.
     // If it's valid, this is probably a UTF-8 string.
@@ -24,6 +24,7 @@
 #include <signal.h>
 
 #include <QtCore/QtCore>
+#include <QtConcurrent/QtConcurrent>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QProgressDialog>
 
@@ -31,7 +32,6 @@
 #include "BookManipulation/XercesCppUse.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/SearchOperations.h"
-#include "Misc/SettingsStore.h"
 #include "Misc/Utility.h"
 #include "PCRE/PCRECache.h"
 #include "Misc/HTMLSpellCheck.h"
@@ -49,16 +49,31 @@ int SearchOperations::CountInFiles(const QString &search_regex,
                                    SearchType search_type,
                                    bool check_spelling)
 {
-    QProgressDialog progress(QObject::tr("Counting occurrences.."), 0, 0, resources.count(), Utility::GetMainWindow());
-    progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
-    int progress_value = 0;
-    progress.setValue(progress_value);
-    // Count sequentially in order to see if occassional crashes are due to threading
     int count = 0;
-    foreach(Resource * resource, resources) {
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-        count += CountInFile(search_regex, resource, search_type, check_spelling);
+
+    // Hunspell can't be used from several threads at once,
+    // so spell checking goes through the files one at a time.
+    if (check_spelling) {
+        QProgressDialog progress(QObject::tr("Counting occurrences.."), 0, 0, resources.count(), Utility::GetMainWindow());
+        progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
+        int progress_value = 0;
+        progress.setValue(progress_value);
+        foreach(Resource * resource, resources) {
+            progress.setValue(progress_value++);
+            qApp->processEvents();
+            count += CountInFile(search_regex, resource, search_type, check_spelling);
+        }
+        return count;
+    }
+
+    SyncTextsFromDocuments(resources);
+    QFutureWatcher< int > watcher;
+    watcher.setFuture(QtConcurrent::mapped(resources,
+                                           boost::bind(CountInFile, search_regex, _1, search_type, check_spelling)));
+    // A canceled count still reports what was counted so far.
+    WaitForFiles(watcher, QObject::tr("Counting occurrences.."), resources.count());
+    foreach(int file_count, watcher.future().results()) {
+        count += file_count;
     }
     return count;
 }
@@ -69,21 +84,70 @@ int SearchOperations::ReplaceInAllFIles(const QString &search_regex,
                                         QList< Resource * > resources,
                                         SearchType search_type)
 {
-    QProgressDialog progress(QObject::tr("Replacing search term..."), 0, 0, resources.count(), Utility::GetMainWindow());
-    progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
-    int progress_value = 0;
-    progress.setValue(progress_value);
-    // Replace sequentially in order to see if occassional crashes are due to threading
+    SyncTextsFromDocuments(resources);
+    QFutureWatcher< tuple< QString, int > > watcher;
+    watcher.setFuture(QtConcurrent::mapped(resources,
+                                           boost::bind(ReplaceInFile, search_regex, replacement, _1, search_type)));
+
+    // Nothing has been changed yet, so canceling leaves the book as it was.
+    if (!WaitForFiles(watcher, QObject::tr("Replacing search term..."), resources.count())) {
+        return 0;
+    }
+
+    // The new texts are stored from this thread, in the order of the files,
+    // so that the tabs showing the files are updated right away.
     int count = 0;
-    foreach(Resource * resource, resources) {
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-        count += ReplaceInFile(search_regex, replacement, resource, search_type);
+
+    for (int i = 0; i < resources.count(); ++i) {
+        QString new_text;
+        int file_count;
+        tie(new_text, file_count) = watcher.resultAt(i);
+
+        if (file_count > 0) {
+            TextResource *text_resource = qobject_cast< TextResource * >(resources.at(i));
+            QWriteLocker locker(&text_resource->GetLock());
+            text_resource->StoreText(new_text);
+            count += file_count;
+        }
     }
+
     return count;
 }
 
 
+void SearchOperations::SyncTextsFromDocuments(const QList< Resource * > &resources)
+{
+    foreach(Resource * resource, resources) {
+        TextResource *text_resource = qobject_cast< TextResource * >(resource);
+
+        if (text_resource) {
+            text_resource->SyncTextFromDocument();
+        }
+    }
+}
+
+
+bool SearchOperations::WaitForFiles(QFutureWatcherBase &watcher, const QString &label, int file_count)
+{
+    QProgressDialog progress(label, QObject::tr("Cancel"), 0, file_count, Utility::GetMainWindow());
+    progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setValue(0);
+    QEventLoop loop;
+    QObject::connect(&watcher, SIGNAL(progressValueChanged(int)), &progress, SLOT(setValue(int)));
+    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    QObject::connect(&progress, SIGNAL(canceled()), &watcher, SLOT(cancel()));
+
+    if (!watcher.isFinished()) {
+        loop.exec();
+    }
+
+    // Files already being processed when canceling still finish.
+    watcher.waitForFinished();
+    return !watcher.isCanceled();
+}
+
+
 int SearchOperations::CountInFile(const QString &search_regex,
                                   Resource *resource,
                                   SearchType search_type,
@@ -134,12 +198,12 @@ int SearchOperations::CountInTextFile(const QString &search_regex, TextResource
 }
 
 
-int SearchOperations::ReplaceInFile(const QString &search_regex,
-                                    const QString &replacement,
-                                    Resource *resource,
-                                    SearchType search_type)
+tuple< QString, int > SearchOperations::ReplaceInFile(const QString &search_regex,
+        const QString &replacement,
+        Resource *resource,
+        SearchType search_type)
 {
-    QWriteLocker locker(&resource->GetLock());
+    QReadLocker locker(&resource->GetLock());
     HTMLResource *html_resource = qobject_cast< HTMLResource * >(resource);
 
     if (html_resource) {
@@ -153,37 +217,30 @@ int SearchOperations::ReplaceInFile(const QString &search_regex,
     }
 
     // We should never get here.
-    return 0;
+    return make_tuple(QString(), 0);
 }
 
 
-int SearchOperations::ReplaceHTMLInFile(const QString &search_regex,
-                                        const QString &replacement,
-                                        HTMLResource *html_resource,
-                                        SearchType search_type)
+tuple< QString, int > SearchOperations::ReplaceHTMLInFile(const QString &search_regex,
+        const QString &replacement,
+        HTMLResource *html_resource,
+        SearchType search_type)
 {
-    SettingsStore ss;
-
     if (search_type == SearchOperations::CodeViewSearch) {
-        int count;
-        QString new_text;
-        QString text = html_resource->GetText();
-        tie(new_text, count) = PerformGlobalReplace(text, search_regex, replacement);
-        html_resource->SetText(new_text);
-        return count;
+        return PerformGlobalReplace(html_resource->GetText(), search_regex, replacement);
     }
 
     //TODO: BookViewSearch
-    return 0;
+    return make_tuple(QString(), 0);
 }
 
 
-int SearchOperations::ReplaceTextInFile(const QString &search_regex,
-                                        const QString &replacement,
-                                        TextResource *text_resource)
+tuple< QString, int > SearchOperations::ReplaceTextInFile(const QString &search_regex,
+        const QString &replacement,
+        TextResource *text_resource)
 {
     // TODO
-    return 0;
+    return make_tuple(QString(), 0);
 }
 
 
@@ -191,21 +248,9 @@ tuple< QString, int > SearchOperations::PerformGlobalReplace(const QString &text
         const QString &search_regex,
         const QString &replacement)
 {
-    QString new_text = text;
     int count = 0;
     SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
-    QList<SPCRE::MatchInfo> match_info = spcre->getEveryMatchInfo(text);
-
-    for (int i =  match_info.count() - 1; i >= 0; i--) {
-        QString match_segement = Utility::Substring(match_info.at(i).offset.first, match_info.at(i).offset.second, new_text);
-        QString replacement_text;
-
-        if (spcre->replaceText(match_segement, match_info.at(i).capture_groups_offsets, replacement, replacement_text)) {
-            new_text.replace(match_info.at(i).offset.first, match_info.at(i).offset.second - match_info.at(i).offset.first, replacement_text);
-            count++;
-        }
-    }
-
+    const QString &new_text = spcre->replaceMatches(text, spcre->getEveryMatchInfo(text), replacement, count);
     return make_tuple(new_text, count);
 }
 
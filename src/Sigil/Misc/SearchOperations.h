@@ -25,6 +25,7 @@
 
 #include <boost/tuple/tuple.hpp>
 
+class QFutureWatcherBase;
 class Resource;
 class TextResource;
 class HTMLResource;
@@ -43,6 +44,7 @@ public:
 
     /**
      * Returns the number of matching occurrences.
+     * The files are searched in parallel.
      *
      * @param search_regex The regex to match with.
      * @return The number of matching occurrences.
@@ -53,18 +55,43 @@ public:
                             bool check_spelling = false);
 
 
+    /**
+     * Replaces the matching occurrences in all the files.
+     * The replacements are made in parallel, and then stored
+     * in the files in order. Nothing is replaced if the user
+     * cancels.
+     *
+     * @return The number of replaced occurrences.
+     */
     static int ReplaceInAllFIles(const QString &search_regex,
                                  const QString &replacement,
                                  QList< Resource * > resources,
                                  SearchType search_type);
 
-private:
-
+    /**
+     * Returns the number of matching occurrences in a single file.
+     * The file is searched right away, from the calling thread.
+     */
     static int CountInFile(const QString &search_regex,
                            Resource *resource,
                            SearchType search_type,
                            bool check_spelling);
 
+private:
+
+    /**
+     * Brings the texts edited in tabs into the resources,
+     * so that the worker threads don't read the tabs' documents.
+     */
+    static void SyncTextsFromDocuments(const QList< Resource * > &resources);
+
+    /**
+     * Shows the progress of the files processed by the watched
+     * future until it finishes, letting the user cancel it.
+     *
+     * @return \c false if the user canceled.
+     */
+    static bool WaitForFiles(QFutureWatcherBase &watcher, const QString &label, int file_count);
 
     static int CountInHTMLFile(const QString &search_regex,
                                HTMLResource *html_resource,
@@ -75,19 +102,23 @@ private:
     static int CountInTextFile(const QString &search_regex,
                                TextResource *text_resource);
 
-    static int ReplaceInFile(const QString &search_regex,
-                             const QString &replacement,
-                             Resource *resource,
-                             SearchType search_type);
-
-    static int ReplaceHTMLInFile(const QString &search_regex,
-                                 const QString &replacement,
-                                 HTMLResource *html_resource,
-                                 SearchType search_type);
-
-    static int ReplaceTextInFile(const QString &search_regex,
-                                 const QString &replacement,
-                                 TextResource *text_resource);
+    /**
+     * Returns the text of the file with the occurrences replaced
+     * and the number of replacements. The file isn't modified.
+     */
+    static tuple< QString, int > ReplaceInFile(const QString &search_regex,
+            const QString &replacement,
+            Resource *resource,
+            SearchType search_type);
+
+    static tuple< QString, int > ReplaceHTMLInFile(const QString &search_regex,
+            const QString &replacement,
+            HTMLResource *html_resource,
+            SearchType search_type);
+
+    static tuple< QString, int > ReplaceTextInFile(const QString &search_regex,
+            const QString &replacement,
+            TextResource *text_resource);
 
     static tuple< QString, int > PerformGlobalReplace(const QString &text,
             const QString &search_regex,
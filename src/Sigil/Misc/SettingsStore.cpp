@@ -42,6 +42,8 @@ static QString KEY_DEFAULT_USER_DICTIONARY = SETTINGS_GROUP + "/" + "user_dictio
 static QString KEY_ENABLED_USER_DICTIONARIES = SETTINGS_GROUP + "/" + "enabled_user_dictionaries";
 static QString KEY_CLEAN_LEVEL = SETTINGS_GROUP + "/" + "clean_level";
 static QString KEY_CLEAN_ON = SETTINGS_GROUP + "/" + "clean_on";
+static QString KEY_COMPRESSION_PRESET = SETTINGS_GROUP + "/" + "compression_preset";
+static QString KEY_TEXT_COMPRESSION_LEVEL = SETTINGS_GROUP + "/" + "text_compression_level";
 
 static QString KEY_BOOK_VIEW_FONT_FAMILY_STANDARD = SETTINGS_GROUP + "/" + "book_view_font_family_standard";
 static QString KEY_BOOK_VIEW_FONT_FAMILY_SERIF = SETTINGS_GROUP + "/" + "book_view_font_family_serif";
@@ -181,6 +183,30 @@ int SettingsStore::cleanOn()
     return value(KEY_CLEAN_ON, (CLEANON_OPEN | CLEANON_SAVE)).toInt();
 }
 
+SettingsStore::CompressionPreset SettingsStore::compressionPreset()
+{
+    clearSettingsGroup();
+    int preset = value(KEY_COMPRESSION_PRESET, SettingsStore::CompressionPreset_Normal).toInt();
+
+    switch (preset) {
+        case SettingsStore::CompressionPreset_Fast:
+        case SettingsStore::CompressionPreset_Normal:
+        case SettingsStore::CompressionPreset_Maximum:
+            return static_cast<SettingsStore::CompressionPreset>(preset);
+            break;
+
+        default:
+            return SettingsStore::CompressionPreset_Normal;
+    }
+}
+
+int SettingsStore::textCompressionLevel()
+{
+    clearSettingsGroup();
+    int level = value(KEY_TEXT_COMPRESSION_LEVEL, 8).toInt();
+    return qBound(1, level, 9);
+}
+
 SettingsStore::BookViewAppearance SettingsStore::bookViewAppearance()
 {
     clearSettingsGroup();
@@ -316,6 +342,18 @@ void SettingsStore::setCleanOn(int on)
     setValue(KEY_CLEAN_ON, on);
 }
 
+void SettingsStore::setCompressionPreset(SettingsStore::CompressionPreset preset)
+{
+    clearSettingsGroup();
+    setValue(KEY_COMPRESSION_PRESET, preset);
+}
+
+void SettingsStore::setTextCompressionLevel(int level)
+{
+    clearSettingsGroup();
+    setValue(KEY_TEXT_COMPRESSION_LEVEL, level);
+}
+
 void SettingsStore::setBookViewAppearance(const SettingsStore::BookViewAppearance &book_view_appearance)
 {
     clearSettingsGroup();
@@ -55,6 +55,12 @@ public:
         CleanLevel_Tidy            = 200
     };
 
+    enum CompressionPreset {
+        CompressionPreset_Fast    = 0,
+        CompressionPreset_Normal  = 1,
+        CompressionPreset_Maximum = 2
+    };
+
     /**
      * The langauge to use for the user interface
      *
@@ -115,6 +121,21 @@ public:
 
     int cleanOn();
 
+    /**
+     * How hard the entries of an EPUB are compressed on save.
+     *
+     * @return The compression preset.
+     */
+    SettingsStore::CompressionPreset compressionPreset();
+
+    /**
+     * The deflate level (1-9) used for the text files (XHTML, CSS...)
+     * of an EPUB when saving with the normal compression preset.
+     *
+     * @return The deflate level.
+     */
+    int textCompressionLevel();
+
     /**
      * All appearance settings related to BookView.
      */
@@ -250,6 +271,10 @@ public slots:
 
     void setCleanOn(int on);
 
+    void setCompressionPreset(SettingsStore::CompressionPreset preset);
+
+    void setTextCompressionLevel(int level);
+
     /**
      * Set the default font settings to use for rendering Book View/Preview
      */
@@ -19,7 +19,9 @@
 **
 *************************************************************************/
 
+#include <limits.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #include <QApplication>
@@ -39,8 +41,38 @@
 #include <QRegularExpressionMatch>
 
 #include "sigil_exception.h"
+#include "Misc/TempFolder.h"
 #include "Misc/Utility.h"
 
+namespace
+{
+    const quint64 BYTE_ONES  = Q_UINT64_C(0x0101010101010101);
+    const quint64 BYTE_HIGHS = Q_UINT64_C(0x8080808080808080);
+
+    // Checks eight bytes at once: true if they are all printable
+    // ASCII (0x20 to 0x7E), which we can widen to UTF-16 as they are.
+    inline bool IsPrintableAsciiWord(quint64 word)
+    {
+        const quint64 below_space = (word - BYTE_ONES * 0x20) & ~word & BYTE_HIGHS;
+        const quint64 del_xor     = word ^ (BYTE_ONES * 0x7F);
+        const quint64 delete_char = (del_xor - BYTE_ONES) & ~del_xor & BYTE_HIGHS;
+        return ((word & BYTE_HIGHS) | below_space | delete_char) == 0;
+    }
+
+    inline bool IsContinuationByte(uchar byte)
+    {
+        return 0x80 <= byte && byte <= 0xBF;
+    }
+
+    // Larger files are read the regular way,
+    // since a QByteArray can't wrap their mapping.
+    const qint64 MAX_MAPPED_FILE_SIZE = INT_MAX;
+
+    // Mapping smaller files doesn't save enough
+    // over a plain read to be worth it.
+    const qint64 MIN_MAPPED_FILE_SIZE = 1024 * 1024;
+}
+
 // Uses QUuid to generate a random UUID but also removes
 // the curly braces that QUuid::createUuid() adds
 QString Utility::CreateUUID()
@@ -321,7 +353,53 @@ QString Utility::ReadUnicodeTextFile(const QString &fullfilepath)
                    );
     }
 
-    QTextStream in(&file);
+    // The file is decoded straight from its mapping
+    // instead of being read into a buffer first.
+    const qint64 size = file.size();
+
+    if (CanMapFile(file)) {
+        uchar *mapped = file.map(0, size);
+
+        if (mapped) {
+            const QString text = ReadUnicodeTextData(QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size));
+            file.unmap(mapped);
+            return text;
+        }
+    }
+
+    return ReadUnicodeTextData(file.readAll());
+}
+
+
+// Returns true if the opened file is worth reading through a
+// memory mapping and safe to map
+bool Utility::CanMapFile(const QFile &file)
+{
+    const qint64 size = file.size();
+
+    if (size < MIN_MAPPED_FILE_SIZE || size >= MAX_MAPPED_FILE_SIZE) {
+        return false;
+    }
+
+    const QString scratchpad = QDir::cleanPath(TempFolder::GetPathToSigilScratchpad()) + "/";
+    return QDir::cleanPath(QFileInfo(file).absoluteFilePath()).startsWith(scratchpad);
+}
+
+
+// Decodes text that is already held in memory the same
+// way ReadUnicodeTextFile decodes the contents of a file
+QString Utility::ReadUnicodeTextData(const QByteArray &data)
+{
+    // Almost everything we read is UTF-8, which is decoded in a single
+    // pass. Since the UTF-16 and UTF-32 BOMs aren't valid UTF-8,
+    // those files end up being read by the text stream below.
+    QString text;
+
+    if (DecodeUtf8Text(data.constData(), data.size(), text)) {
+        return text;
+    }
+
+    QTextStream in(data, QIODevice::ReadOnly);
     // Input should be UTF-8
     in.setCodec("UTF-8");
     // This will automatically switch reading from
@@ -364,6 +442,122 @@ QString Utility::ConvertLineEndings(const QString &text)
 }
 
 
+bool Utility::DecodeUtf8Text(const char *data, int size, QString &text, bool nbsp_to_entity)
+{
+    const uchar *current = reinterpret_cast<const uchar *>(data);
+    const uchar *end = current + size;
+
+    if (size >= 3 && current[0] == 0xEF && current[1] == 0xBB && current[2] == 0xBF) {
+        current += 3;
+    }
+
+    // No character takes fewer UTF-16 units than it takes bytes in UTF-8,
+    // so the buffer only needs to grow when writing &#160; entities.
+    int capacity = end - current;
+    QString result(capacity, Qt::Uninitialized);
+    ushort *out = reinterpret_cast<ushort *>(result.data());
+    int length = 0;
+
+    while (current < end) {
+        if (end - current >= 8) {
+            quint64 word;
+            memcpy(&word, current, sizeof(word));
+
+            if (IsPrintableAsciiWord(word)) {
+                for (int i = 0; i < 8; ++i) {
+                    out[ length + i ] = current[ i ];
+                }
+
+                length  += 8;
+                current += 8;
+                continue;
+            }
+        }
+
+        const uchar byte = *current;
+
+        if ((0x20 <= byte && byte <= 0x7E) || byte == 0x09 || byte == 0x0A) {
+            out[ length++ ] = byte;
+            current += 1;
+        } else if (byte == 0x0D) {
+            // Mac and Windows line endings become Unix ones.
+            out[ length++ ] = 0x0A;
+            current += 1;
+
+            if (current < end && *current == 0x0A) {
+                current += 1;
+            }
+        } else if (0xC2 <= byte && byte <= 0xDF) {
+            if (end - current < 2 || !IsContinuationByte(current[1])) {
+                return false;
+            }
+
+            if (nbsp_to_entity && byte == 0xC2 && current[1] == 0xA0) {
+                const int needed = length + 6 + (end - current - 2);
+
+                if (needed > capacity) {
+                    capacity = qMax(needed, capacity + capacity / 2);
+                    result.resize(capacity);
+                    out = reinterpret_cast<ushort *>(result.data());
+                }
+
+                const char *entity = "&#160;";
+
+                for (int i = 0; i < 6; ++i) {
+                    out[ length++ ] = entity[ i ];
+                }
+            } else {
+                out[ length++ ] = ((byte & 0x1F) << 6) | (current[1] & 0x3F);
+            }
+
+            current += 2;
+        } else if (0xE0 <= byte && byte <= 0xEF) {
+            // Overlongs and surrogates are not valid.
+            const uchar low  = byte == 0xE0 ? 0xA0 : 0x80;
+            const uchar high = byte == 0xED ? 0x9F : 0xBF;
+
+            if (end - current < 3 ||
+                current[1] < low || current[1] > high ||
+                !IsContinuationByte(current[2])) {
+                return false;
+            }
+
+            out[ length++ ] = ((byte & 0x0F) << 12) | ((current[1] & 0x3F) << 6) | (current[2] & 0x3F);
+            current += 3;
+        } else if (0xF0 <= byte && byte <= 0xF4) {
+            // Overlongs and code points above U+10FFFF are not valid.
+            const uchar low  = byte == 0xF0 ? 0x90 : 0x80;
+            const uchar high = byte == 0xF4 ? 0x8F : 0xBF;
+
+            if (end - current < 4 ||
+                current[1] < low || current[1] > high ||
+                !IsContinuationByte(current[2]) ||
+                !IsContinuationByte(current[3])) {
+                return false;
+            }
+
+            const uint code_point = ((byte & 0x07) << 18) | ((current[1] & 0x3F) << 12) |
+                                    ((current[2] & 0x3F) << 6) | (current[3] & 0x3F);
+            out[ length++ ] = QChar::highSurrogate(code_point);
+            out[ length++ ] = QChar::lowSurrogate(code_point);
+            current += 4;
+        } else {
+            return false;
+        }
+    }
+
+    result.resize(length);
+
+    // Text with many multibyte characters can leave most of the buffer unused.
+    if (length < capacity / 2) {
+        result.squeeze();
+    }
+
+    text = result;
+    return true;
+}
+
+
 QString Utility::URLEncodePath(const QString &path)
 {
     QByteArray encoded_url = QUrl::toPercentEncoding(path, QByteArray("/#"));
@@ -26,6 +26,7 @@
 #include <QCoreApplication>
 #include <QtCore/QString>
 
+class QFile;
 class QStringList;
 class QStringRef;
 class QWidget;
@@ -102,6 +103,17 @@ public:
     // be read, an error dialog is shown and an empty string returned
     static QString ReadUnicodeTextFile(const QString &fullfilepath);
 
+    // Decodes text that is already held in memory the same
+    // way ReadUnicodeTextFile decodes the contents of a file
+    static QString ReadUnicodeTextData(const QByteArray &data);
+
+    // Returns true if the opened file is worth reading through a
+    // memory mapping and safe to map: only large files in Sigil's
+    // own scratchpad are mapped. A mapped file that something else
+    // truncates while we read it crashes us (SIGBUS), so files
+    // opened from anywhere else are always read into a buffer.
+    static bool CanMapFile(const QFile &file);
+
     // Writes the provided text variable to the specified
     // file; if the file exists, it is truncated
     static void WriteUnicodeTextFile(const QString &text, const QString &fullfilepath);
@@ -110,6 +122,14 @@ public:
     // line endings that are expected throughout the Qt framework
     static QString ConvertLineEndings(const QString &text);
 
+    // Decodes UTF-8 data in a single pass, converting the line
+    // endings like ConvertLineEndings does and, if requested, the
+    // non-breaking spaces to the &#160; entity. A UTF-8 BOM is skipped.
+    // Returns false if the data isn't strictly valid UTF-8 (the same
+    // rules HTMLEncodingResolver uses), in which case the caller
+    // needs to fall back to a codec.
+    static bool DecodeUtf8Text(const char *data, int size, QString &text, bool nbsp_to_entity = false);
+
     /**
      * URL encodes the provided path string.
      * The path separator ('/') and the ID hash ('#') are left alone.
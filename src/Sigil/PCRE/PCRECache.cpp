@@ -38,11 +38,14 @@ PCRECache::PCRECache()
 
 bool PCRECache::insert(const QString &key, SPCRE *object)
 {
+    QMutexLocker locker(&m_mutex);
     return m_cache.insert(key, object);
 }
 
 SPCRE *PCRECache::getObject(const QString &key)
 {
+    QMutexLocker locker(&m_mutex);
+
     // Create a new SPCRE if it doesn't alreayd exit.
     // The key is the pattern for initializing the SPCRE.
     if (!m_cache.contains(key)) {
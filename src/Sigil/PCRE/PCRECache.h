@@ -25,6 +25,7 @@
 #define PCRECACHE_H
 
 #include <QtCore/QCache>
+#include <QtCore/QMutex>
 #include <QtCore/QString>
 
 #include "PCRE/SPCRE.h"
@@ -33,6 +34,7 @@
  * Singleton. A cache of SPCRE regular expression objects.
  *
  * The SPCRE's are cached to improve performance.
+ * The cache can be accessed from several threads.
  */
 class PCRECache
 {
@@ -71,6 +73,8 @@ private:
 
     // The cache that we store the SPCRE's.
     QCache<QString, SPCRE> m_cache;
+    // Guards m_cache, which even lookups modify.
+    QMutex m_mutex;
     // The single instance of the cache.
     static PCRECache *m_instance;
 };
@@ -19,6 +19,8 @@
 **
 *************************************************************************/
 
+#include <QtCore/QThreadStorage>
+
 #include "PCRE/SPCRE.h"
 #include "PCRE/PCREReplaceTextBuilder.h"
 #include "sigil_constants.h"
@@ -26,6 +28,47 @@
 // The maximum number of catpures that we will allow.
 const int PCRE_MAX_CAPTURE_GROUPS = 30;
 
+// The JIT stack of a thread starts small and grows up to the maximum
+// for patterns that backtrack a lot over large texts.
+const int JIT_STACK_START_SIZE = 32 * 1024;
+const int JIT_STACK_MAX_SIZE = 1024 * 1024;
+
+// Owns the JIT stack of one thread.
+class JITStack
+{
+public:
+    JITStack()
+        : m_stack(pcre16_jit_stack_alloc(JIT_STACK_START_SIZE, JIT_STACK_MAX_SIZE)) {
+    }
+
+    ~JITStack() {
+        if (m_stack != NULL) {
+            pcre16_jit_stack_free(m_stack);
+        }
+    }
+
+    pcre16_jit_stack *get() {
+        return m_stack;
+    }
+
+private:
+    pcre16_jit_stack *m_stack;
+};
+
+static QThreadStorage<JITStack *> jit_stacks;
+
+// A JIT stack can only be used by one thread at a time, so a pattern shared
+// by several threads gets the stack of the thread executing it. A NULL stack
+// makes PCRE use a small stack on the machine stack instead.
+static pcre16_jit_stack *GetThreadJITStack(void *)
+{
+    if (!jit_stacks.hasLocalData()) {
+        jit_stacks.setLocalData(new JITStack());
+    }
+
+    return jit_stacks.localData()->get();
+}
+
 SPCRE::SPCRE(const QString &patten)
 {
     m_pattern = patten;
@@ -39,8 +82,16 @@ SPCRE::SPCRE(const QString &patten)
     // Pattern is valid.
     if (m_re != NULL) {
         m_valid = true;
-        // Study the pattern and save the results of the study.
-        m_study = pcre16_study(m_re, 0, &error);
+        // Study the pattern and save the results of the study. The pattern
+        // is compiled to machine code as well if the JIT supports it,
+        // otherwise matching falls back to the interpreter.
+        m_study = pcre16_study(m_re, PCRE_STUDY_JIT_COMPILE, &error);
+        int jit = 0;
+
+        if (m_study != NULL && pcre16_fullinfo(m_re, m_study, PCRE_INFO_JIT, &jit) == 0 && jit) {
+            pcre16_assign_jit_stack(m_study, GetThreadJITStack, NULL);
+        }
+
         // Store the number of capture subpatterns.
         pcre16_fullinfo(m_re, m_study, PCRE_INFO_CAPTURECOUNT, &m_captureSubpatternCount);
     }
@@ -58,7 +109,7 @@ SPCRE::~SPCRE()
     }
 
     if (m_study != NULL) {
-        pcre16_free(m_study);
+        pcre16_free_study(m_study);
         m_study = NULL;
     }
 }
@@ -150,18 +201,18 @@ QList<SPCRE::MatchInfo> SPCRE::getEveryMatchInfo(const QString &text)
             info.append(generateMatchInfo(ovector, ovector_count));
         }
 
-        rc = pcre16_exec(m_re, m_study, text.utf16(), text.length(), last_offset[1], 0, ovector, ovector_size);
+        rc = exec(text, last_offset[1], ovector, ovector_size);
     } while (rc >= 0 && ovector[0] != ovector[1] && ovector[1] != last_offset[1] && ovector[0] < ovector[1]);
 
     delete[] ovector;
     return info;
 }
 
-SPCRE::MatchInfo SPCRE::getFirstMatchInfo(const QString &text)
+SPCRE::MatchInfo SPCRE::getFirstMatchInfo(const QString &text, int start_offset)
 {
     SPCRE::MatchInfo match_info;
 
-    if (m_re == NULL || text.isEmpty()) {
+    if (m_re == NULL || start_offset >= text.length()) {
         return match_info;
     }
 
@@ -183,7 +234,7 @@ SPCRE::MatchInfo SPCRE::getFirstMatchInfo(const QString &text)
     // MSVC doesn't support it.
     int *ovector = new int[ovector_size];
     memset(ovector, 0, sizeof(int)*ovector_size);
-    rc = pcre16_exec(m_re, m_study, text.utf16(), text.length(), 0, 0, ovector, ovector_size);
+    rc = exec(text, start_offset, ovector, ovector_size);
 
     if (rc >= 0 && ovector[0] != ovector[1]) {
         match_info = generateMatchInfo(ovector, ovector_count);
@@ -211,6 +262,50 @@ bool SPCRE::replaceText(const QString &text, const QList<std::pair<int, int> > &
     return builder.BuildReplacementText(*this, text, capture_groups_offsets, replacement_pattern, out);
 }
 
+QString SPCRE::replaceMatches(const QString &text, const QList<MatchInfo> &matches, const QString &replacement_pattern, int &count)
+{
+    count = 0;
+    QString out;
+    // Replacements are usually about as long as the matches.
+    out.reserve(text.length());
+    // The end of the text that has been copied to the output.
+    int copied = 0;
+    foreach(const MatchInfo &match, matches) {
+        int match_start = match.offset.first;
+        int match_end = match.offset.second;
+        QString replacement_text;
+
+        if (replaceText(text.mid(match_start, match_end - match_start), match.capture_groups_offsets, replacement_pattern, replacement_text)) {
+            out.append(text.midRef(copied, match_start - copied));
+            out.append(replacement_text);
+            copied = match_end;
+            count++;
+        }
+    }
+
+    if (count == 0) {
+        return text;
+    }
+
+    out.append(text.midRef(copied));
+    return out;
+}
+
+int SPCRE::exec(const QString &text, int start_offset, int ovector[], int ovector_size)
+{
+    int rc = pcre16_exec(m_re, m_study, text.utf16(), text.length(), start_offset, 0, ovector, ovector_size);
+
+    // Even the largest JIT stack can be too small for some patterns,
+    // but the interpreter can still match them.
+    if (rc == PCRE_ERROR_JIT_STACKLIMIT) {
+        pcre16_extra interpreter_study = *m_study;
+        interpreter_study.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+        rc = pcre16_exec(m_re, &interpreter_study, text.utf16(), text.length(), start_offset, 0, ovector, ovector_size);
+    }
+
+    return rc;
+}
+
 SPCRE::MatchInfo SPCRE::generateMatchInfo(int ovector[], int ovector_count)
 {
     MatchInfo match_info;
@@ -40,6 +40,10 @@ using std::pair;
  * This class is a wrapper for the PCRE C library. The C API is used instead
  * of the C++ API because the C++ API does not return offsets within the matched
  * String.
+ *
+ * Patterns are JIT compiled when possible. Matching doesn't modify the object
+ * and every thread uses its own JIT stack, so one SPCRE can be used by several
+ * threads at once.
  */
 class SPCRE
 {
@@ -123,7 +127,17 @@ public:
      * @return A list of MatchInfo objects.
      */
     QList<MatchInfo> getEveryMatchInfo(const QString &text);
-    MatchInfo getFirstMatchInfo(const QString &text);
+    /**
+     * Finds the first match starting at or after an offset. The text before
+     * the offset is still seen by lookbehinds, and the returned offsets are
+     * from the start of the text, so no substring needs to be made.
+     *
+     * @param text The text to get matching information from.
+     * @param start_offset Where in the text to start looking.
+     *
+     * @return The match, or a MatchInfo with an offset of -1 if there is none.
+     */
+    MatchInfo getFirstMatchInfo(const QString &text, int start_offset = 0);
     MatchInfo getLastMatchInfo(const QString &text);
 
     /**
@@ -142,7 +156,29 @@ public:
      */
     bool replaceText(const QString &text, const QList<std::pair<int, int> > &capture_groups_offsets, const QString &replacement_pattern, QString &out);
 
+    /**
+     * Replaces matches within a text. The text is built in a single pass,
+     * so the cost depends on the length of the text and not on the
+     * number of matches.
+     *
+     * @param text The text that was matched.
+     * @param matches The matches to replace, in the order they occur in the text.
+     * @param replacement_pattern The pattern / text to use to create the
+     * replacement texts.
+     * @param[out] count The number of matches that were replaced.
+     *
+     * @return The text with the matches replaced.
+     */
+    QString replaceMatches(const QString &text, const QList<MatchInfo> &matches, const QString &replacement_pattern, int &count);
+
 private:
+    /**
+     * Runs the pattern over the text, like pcre16_exec.
+     *
+     * @return The pcre16_exec result.
+     */
+    int exec(const QString &text, int start_offset, int ovector[], int ovector_size);
+
     MatchInfo generateMatchInfo(int ovector[], int ovector_count);
 
     // Store if the pattern is valid.
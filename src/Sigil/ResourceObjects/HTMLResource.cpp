@@ -29,6 +29,7 @@
 #include "BookManipulation/CleanSource.h"
 #include "BookManipulation/GuideSemantics.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/Utility.h"
 #include "ResourceObjects/HTMLResource.h"
@@ -59,6 +60,12 @@ Resource::ResourceType HTMLResource::Type() const
 
 bool HTMLResource::LoadFromDisk()
 {
+    // The file already is the text of a resource that isn't loaded.
+    if (!IsLoaded()) {
+        emit LoadedFromDisk();
+        return true;
+    }
+
     try {
         const QString &text = Utility::ReadUnicodeTextFile(GetFullPath());
         SetText(text);
@@ -85,11 +92,26 @@ void HTMLResource::SetText(const QString &text)
 
 void HTMLResource::SaveToDisk(bool book_wide_save)
 {
-    SetText(GetText());
+    // The text may have been edited in a tab since it was last set.
+    if (IsLoaded()) {
+        TrackNewResources(GetPathsToLinkedResources());
+    }
+
     XMLResource::SaveToDisk(book_wide_save);
 }
 
 
+void HTMLResource::InitialLoad()
+{
+    if (IsLoaded()) {
+        return;
+    }
+
+    XMLResource::InitialLoad();
+    TrackNewResources(GetPathsToLinkedResources());
+}
+
+
 QStringList HTMLResource::GetLinkedStylesheets()
 {
     return XhtmlDoc::GetLinkedStylesheets(GetText());
@@ -118,15 +140,15 @@ QStringList HTMLResource::GetPathsToLinkedResources()
             Q_ASSERT(&element);
 
             // We skip the link elements that are not stylesheets
-            if (tag == "link" && element.hasAttribute(QtoX("rel")) &&
-                XtoQ(element.getAttribute(QtoX("rel"))).toLower() != "stylesheet") {
+            if (tag == "link" && element.hasAttribute(xn::REL) &&
+                XtoQ(element.getAttribute(xn::REL)).toLower() != "stylesheet") {
                 continue;
             }
 
-            if (element.hasAttribute(QtoX("href"))) {
-                linked_resources.append(XtoQ(element.getAttribute(QtoX("href"))));
-            } else if (element.hasAttribute(QtoX("src"))) {
-                linked_resources.append(XtoQ(element.getAttribute(QtoX("src"))));
+            if (element.hasAttribute(xn::HREF)) {
+                linked_resources.append(XtoQ(element.getAttribute(xn::HREF)));
+            } else if (element.hasAttribute(xn::SRC)) {
+                linked_resources.append(XtoQ(element.getAttribute(xn::SRC)));
             }
         }
     }
@@ -73,6 +73,9 @@ public:
 
     void SaveToDisk(bool book_wide_save = false);
 
+    // inherited
+    virtual void InitialLoad();
+
     /**
      * Splits the content of the resource into multiple section.
      * The SGF section markers are used as the break points.
@@ -32,6 +32,7 @@
 
 #include "BookManipulation/CleanSource.h"
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/Language.h"
 #include "Misc/Utility.h"
@@ -95,8 +96,14 @@ Resource::ResourceType OPFResource::Type() const
 GuideSemantics::GuideSemanticType OPFResource::GetGuideSemanticTypeForResource(const Resource &resource) const
 {
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    return GetGuideSemanticTypeForResource(resource, *document);
+    shared_ptr< const PackageModel > package = GetPackageModel();
+    QString oebps_path = Utility::URLEncodePath(resource.GetRelativePathToOEBPS());
+
+    if (!package->guide_types_by_href.contains(oebps_path)) {
+        return GuideSemantics::NoType;
+    }
+
+    return GuideSemantics::Instance().MapReferenceTypeToGuideEnum(package->guide_types_by_href.value(oebps_path));
 }
 
 QString OPFResource::GetGuideSemanticNameForResource(Resource *resource)
@@ -109,37 +116,22 @@ QHash <QString, QString>  OPFResource::GetGuideSemanticNameForPaths()
     QHash <QString, QString> semantic_types;
 
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-
-    QList< xc::DOMElement * > references =
-        XhtmlDoc::GetTagMatchingDescendants(*document, "reference", OPF_XML_NAMESPACE);
+    shared_ptr< const PackageModel > package = GetPackageModel();
 
-    foreach(xc::DOMElement *reference, references) {
-        const QString &href = XtoQ(reference->getAttribute(QtoX("href")));
-        QStringList parts = href.split('#', QString::KeepEmptyParts);
-
-        const QString &type_text = XtoQ(reference->getAttribute(QtoX("type")));
+    typedef QPair< QString, QString > StringPair;
+    foreach(StringPair reference, package->guide) {
         GuideSemantics::GuideSemanticType type =
-            GuideSemantics::Instance().MapReferenceTypeToGuideEnum(type_text);
-        semantic_types[parts.at(0)] = GuideSemantics::Instance().GetGuideName(type);
+            GuideSemantics::Instance().MapReferenceTypeToGuideEnum(reference.second);
+        semantic_types[reference.first] = GuideSemantics::Instance().GetGuideName(type);
     }
 
     // Cover image semantics don't use reference
-    xc::DOMElement *meta = GetCoverMeta(*document);
-    if (meta) {
-
-        QString cover_id = XtoQ(meta->getAttribute(QtoX("content")));
-
-        QList< xc::DOMElement * > items =
-                XhtmlDoc::GetTagMatchingDescendants(*document, "item", OPF_XML_NAMESPACE);
-        foreach(xc::DOMElement *item, items) {
-            QString id = XtoQ(item->getAttribute(QtoX("id")));
-
-            if (id == cover_id) {
-                QString href = XtoQ(item->getAttribute(QtoX("href")));
+    if (package->has_cover_meta) {
+        foreach(StringPair item, package->manifest) {
+            if (item.first == package->cover_id) {
                 GuideSemantics::GuideSemanticType type =
                      GuideSemantics::Instance().MapReferenceTypeToGuideEnum("cover");
-                semantic_types[href] = GuideSemantics::Instance().GetGuideName(type);
+                semantic_types[item.second] = GuideSemantics::Instance().GetGuideName(type);
             }
         }
     }
@@ -152,21 +144,16 @@ QHash <Resource *, int>  OPFResource::GetReadingOrderAll( const QList < Resource
     QHash <Resource *, int> reading_order;
 
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-
-    QList< xc::DOMElement * > itemrefs =
-        XhtmlDoc::GetTagMatchingDescendants(*document, "itemref", OPF_XML_NAMESPACE);
+    shared_ptr< const PackageModel > package = GetPackageModel();
 
     QHash<QString, int> id_order;
-    for (int i = 0; i < itemrefs.count(); ++i) {
-        QString idref = XtoQ(itemrefs[ i ]->getAttribute(QtoX("idref")));
-        id_order[idref] = i;
+    for (int i = 0; i < package->spine.count(); ++i) {
+        id_order[package->spine.at(i)] = i;
     }
 
-    QHash< Resource *, QString > id_mapping = GetResourceManifestIDMapping(resources, *document);
-
     foreach(Resource *resource, resources) {
-        reading_order[resource] = id_order[id_mapping[resource]];
+        QString oebps_path = Utility::URLEncodePath(resource->GetRelativePathToOEBPS());
+        reading_order[resource] = id_order.value(package->ids_by_href.value(oebps_path));
     }
 
     return reading_order;
@@ -175,29 +162,17 @@ QHash <Resource *, int>  OPFResource::GetReadingOrderAll( const QList < Resource
 int OPFResource::GetReadingOrder(const ::HTMLResource &html_resource) const
 {
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
+    shared_ptr< const PackageModel > package = GetPackageModel();
     const Resource &resource = *static_cast< const Resource * >(&html_resource);
-    QString resource_id = GetResourceManifestID(resource, *document);
-    QList< xc::DOMElement * > itemrefs =
-        XhtmlDoc::GetTagMatchingDescendants(*document, "itemref", OPF_XML_NAMESPACE);
-
-    for (int i = 0; i < itemrefs.count(); ++i) {
-        QString idref = XtoQ(itemrefs[ i ]->getAttribute(QtoX("idref")));
-
-        if (resource_id == idref) {
-            return i;
-        }
-    }
-
-    return -1;
+    QString oebps_path = Utility::URLEncodePath(resource.GetRelativePathToOEBPS());
+    return package->spine_positions.value(package->ids_by_href.value(oebps_path), -1);
 }
 
 
 QString OPFResource::GetMainIdentifierValue() const
 {
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    return XtoQ(GetMainIdentifier(*document).getTextContent());
+    return GetPackageModel()->main_identifier;
 }
 
 
@@ -214,36 +189,23 @@ QString OPFResource::GetUUIDIdentifierValue()
 {
     EnsureUUIDIdentifierPresent();
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    QList< xc::DOMElement * > identifiers =
-        XhtmlDoc::GetTagMatchingDescendants(*document, "identifier", DUBLIN_CORE_NS);
-    foreach(xc::DOMElement * identifier, identifiers) {
-        QString value = XtoQ(identifier->getTextContent()).remove("urn:uuid:");
-
-        if (!QUuid(value).isNull()) {
-            return value;
-        }
-    }
-    // EnsureUUIDIdentifierPresent should ensure we
-    // never reach here.
-    Q_ASSERT(false);
-    return QString();
+    QString value = GetPackageModel()->uuid_identifier;
+    // EnsureUUIDIdentifierPresent should ensure
+    // we always have a value here.
+    Q_ASSERT(!value.isEmpty());
+    return value;
 }
 
 
 void OPFResource::EnsureUUIDIdentifierPresent()
 {
     QWriteLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    QList<xc::DOMElement *> identifiers = XhtmlDoc::GetTagMatchingDescendants(*document, "identifier", DUBLIN_CORE_NS);
-
-    foreach(xc::DOMElement *identifier, identifiers) {
-        QString value = XtoQ(identifier->getTextContent()).remove("urn:uuid:");
 
-        if (!QUuid(value).isNull()) {
-            return;
-        }
+    if (!GetPackageModel()->uuid_identifier.isEmpty()) {
+        return;
     }
+
+    shared_ptr< xc::DOMDocument > document = GetDocument();
     QString uuid = Utility::CreateUUID();
     WriteIdentifier("UUID", uuid, *document);
     UpdateTextFromDom(*document);
@@ -278,10 +240,10 @@ void OPFResource::UpdateNCXOnSpine(const QString &new_ncx_id)
     if (!spine) {
         return;
     }
-    QString ncx_id = XtoQ(spine->getAttribute(QtoX("toc")));
+    QString ncx_id = XtoQ(spine->getAttribute(xn::TOC));
 
     if (new_ncx_id != ncx_id) {
-        spine->setAttribute(QtoX("toc"), QtoX(new_ncx_id));
+        spine->setAttribute(xn::TOC, QtoX(new_ncx_id));
         UpdateTextFromDom(*document);
     }
 }
@@ -291,13 +253,13 @@ void OPFResource::UpdateNCXLocationInManifest(const ::NCXResource &ncx)
     QWriteLocker locker(&GetLock());
     shared_ptr< xc::DOMDocument > document = GetDocument();
     xc::DOMElement *spine = GetSpineElement(*document);
-    QString ncx_id = XtoQ(spine->getAttribute(QtoX("toc")));
+    QString ncx_id = XtoQ(spine->getAttribute(xn::TOC));
     QList<xc::DOMElement *> items = XhtmlDoc::GetTagMatchingDescendants(*document, "item", OPF_XML_NAMESPACE);
     foreach(xc::DOMElement * item, items) {
-        QString id = XtoQ(item->getAttribute(QtoX("id")));
+        QString id = XtoQ(item->getAttribute(xn::ID));
 
         if (id == ncx_id) {
-            item->setAttribute(QtoX("href"), QtoX(ncx.Filename()));
+            item->setAttribute(xn::HREF, QtoX(ncx.Filename()));
             break;
         }
     }
@@ -312,17 +274,17 @@ void OPFResource::AddSigilVersionMeta()
     QList< xc::DOMElement * > metas =
         XhtmlDoc::GetTagMatchingDescendants(*document, "meta", OPF_XML_NAMESPACE);
     foreach(xc::DOMElement * meta, metas) {
-        QString name = XtoQ(meta->getAttribute(QtoX("name")));
+        QString name = XtoQ(meta->getAttribute(xn::NAME));
 
         if (name == SIGIL_VERSION_META_NAME) {
-            meta->setAttribute(QtoX("content"), QtoX(SIGIL_VERSION));
+            meta->setAttribute(xn::CONTENT, QtoX(SIGIL_VERSION));
             UpdateTextFromDom(*document);
             return;
         }
     }
-    xc::DOMElement *element = document->createElementNS(QtoX(OPF_XML_NAMESPACE), QtoX("meta"));
-    element->setAttribute(QtoX("name"),    QtoX("Sigil version"));
-    element->setAttribute(QtoX("content"), QtoX(SIGIL_VERSION));
+    xc::DOMElement *element = document->createElementNS(QtoX(OPF_XML_NAMESPACE), xn::META);
+    element->setAttribute(xn::NAME,    QtoX("Sigil version"));
+    element->setAttribute(xn::CONTENT, QtoX(SIGIL_VERSION));
     xc::DOMElement *metadata = GetMetadataElement(*document);
     if (!metadata) {
         return;
@@ -335,8 +297,16 @@ void OPFResource::AddSigilVersionMeta()
 bool OPFResource::IsCoverImage(const ::ImageResource &image_resource) const
 {
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    return IsCoverImageCheck(image_resource, *document);
+    shared_ptr< const PackageModel > package = GetPackageModel();
+    QString oebps_path = Utility::URLEncodePath(image_resource.GetRelativePathToOEBPS());
+    return package->has_cover_meta && package->cover_id == package->ids_by_href.value(oebps_path);
+}
+
+QString OPFResource::GetManifestMediaType(const Resource &resource) const
+{
+    QReadLocker locker(&GetLock());
+    QString oebps_path = Utility::URLEncodePath(resource.GetRelativePathToOEBPS());
+    return GetPackageModel()->media_types_by_href.value(oebps_path);
 }
 
 bool OPFResource::IsCoverImageCheck(const Resource &resource, xc::DOMDocument &document) const
@@ -350,7 +320,7 @@ bool OPFResource::IsCoverImageCheck(QString resource_id, xc::DOMDocument &docume
     xc::DOMElement *meta = GetCoverMeta(document);
 
     if (meta) {
-        return XtoQ(meta->getAttribute(QtoX("content"))) == resource_id;
+        return XtoQ(meta->getAttribute(xn::CONTENT)) == resource_id;
     }
 
     return false;
@@ -360,8 +330,7 @@ bool OPFResource::IsCoverImageCheck(QString resource_id, xc::DOMDocument &docume
 bool OPFResource::CoverImageExists() const
 {
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    return GetCoverMeta(*document) != NULL;
+    return GetPackageModel()->has_cover_meta;
 }
 
 
@@ -375,26 +344,7 @@ void OPFResource::AutoFixWellFormedErrors()
 QStringList OPFResource::GetSpineOrderFilenames() const
 {
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    QList< xc::DOMElement * > items =
-        XhtmlDoc::GetTagMatchingDescendants(*document, "item", OPF_XML_NAMESPACE);
-    QHash< QString, QString > id_to_filename_mapping;
-    foreach(xc::DOMElement * item, items) {
-        QString id   = XtoQ(item->getAttribute(QtoX("id")));
-        QString href = XtoQ(item->getAttribute(QtoX("href")));
-        id_to_filename_mapping[ id ] = QFileInfo(href).fileName();
-    }
-    QList< xc::DOMElement * > itemrefs =
-        XhtmlDoc::GetTagMatchingDescendants(*document, "itemref", OPF_XML_NAMESPACE);
-    QStringList filenames_in_reading_order;
-    foreach(xc::DOMElement * itemref, itemrefs) {
-        QString idref = XtoQ(itemref->getAttribute(QtoX("idref")));
-
-        if (id_to_filename_mapping.contains(idref)) {
-            filenames_in_reading_order.append(Utility::URLDecodePath(id_to_filename_mapping[ idref ]));
-        }
-    }
-    return filenames_in_reading_order;
+    return GetPackageModel()->spine_filenames;
 }
 
 
@@ -406,8 +356,8 @@ void OPFResource::SetSpineOrderFromFilenames(const QStringList spineOrder)
         XhtmlDoc::GetTagMatchingDescendants(*document, "item", OPF_XML_NAMESPACE);
     QHash< QString, QString > filename_to_id_mapping;
     foreach(xc::DOMElement * item, items) {
-        QString id   = XtoQ(item->getAttribute(QtoX("id")));
-        QString href = XtoQ(item->getAttribute(QtoX("href")));
+        QString id   = XtoQ(item->getAttribute(xn::ID));
+        QString href = XtoQ(item->getAttribute(xn::HREF));
     }
     QList< xc::DOMElement * > itemrefs =
         XhtmlDoc::GetTagMatchingDescendants(*document, "itemref", OPF_XML_NAMESPACE);
@@ -420,7 +370,7 @@ void OPFResource::SetSpineOrderFromFilenames(const QStringList spineOrder)
         while (spineElementSearch.hasNext() && !found) {
             xc::DOMElement *spineElement = spineElementSearch.next();
 
-            if (XtoQ(spineElement->getAttribute(QtoX("idref"))) == spineItem) {
+            if (XtoQ(spineElement->getAttribute(xn::IDREF)) == spineItem) {
                 newSpine.append(spineElement);
                 found = true;
             }
@@ -444,19 +394,7 @@ void OPFResource::SetSpineOrderFromFilenames(const QStringList spineOrder)
 QList< Metadata::MetaElement > OPFResource::GetDCMetadata() const
 {
     QReadLocker locker(&GetLock());
-    shared_ptr< xc::DOMDocument > document = GetDocument();
-    QList< xc::DOMElement * > dc_elements =
-        XhtmlDoc::GetTagMatchingDescendants(*document, "*", DUBLIN_CORE_NS);
-    QList< Metadata::MetaElement > metadata;
-    foreach(xc::DOMElement * dc_element, dc_elements) {
-        // Map the names in the OPF file to internal names
-        Metadata::MetaElement book_meta = Metadata::Instance().MapToBookMetadata(*dc_element);
-
-        if (!book_meta.name.isEmpty() && !book_meta.value.toString().isEmpty()) {
-            metadata.append(book_meta);
-        }
-    }
-    return metadata;
+    return GetPackageModel()->dc_metadata;
 }
 
 
@@ -514,7 +452,7 @@ void OPFResource::RemoveCoverMetaForImage(const Resource &resource, xc::DOMDocum
     QString resource_id = GetResourceManifestID(resource, document);
 
     // Remove entry if there is a cover in meta and if this file is marked as cover
-    if (meta && XtoQ(meta->getAttribute(QtoX("content"))) == resource_id) {
+    if (meta && XtoQ(meta->getAttribute(xn::CONTENT)) == resource_id) {
         GetMetadataElement(document)->removeChild(meta);
     }
 }
@@ -526,7 +464,7 @@ void OPFResource::AddCoverMetaForImage(const Resource &resource, xc::DOMDocument
 
     // If a cover entry exists, update its id, else create one
     if (meta) {
-        meta->setAttribute(QtoX("content"), QtoX(resource_id));
+        meta->setAttribute(xn::CONTENT, QtoX(resource_id));
     } else {
         QHash< QString, QString > attributes;
         attributes[ "name"    ] = "cover";
@@ -556,10 +494,10 @@ void OPFResource::RemoveResource(const Resource &resource)
     }
 
     foreach(xc::DOMElement * child, children) {
-        QString href = XtoQ(child->getAttribute(QtoX("href")));
+        QString href = XtoQ(child->getAttribute(xn::HREF));
 
         if (href == resource_oebps_path) {
-            item_id = XtoQ(child->getAttribute(QtoX("id")));
+            item_id = XtoQ(child->getAttribute(xn::ID));
             manifest->removeChild(child);
             break;
         }
@@ -643,13 +581,13 @@ void OPFResource::ResourceRenamed(const Resource &resource, QString old_full_pat
     QString old_id;
     QString new_id;
     foreach(xc::DOMElement * item, items) {
-        QString href = XtoQ(item->getAttribute(QtoX("href")));
+        QString href = XtoQ(item->getAttribute(xn::HREF));
 
         if (href == resource_oebps_path) {
-            item->setAttribute(QtoX("href"), QtoX(Utility::URLEncodePath(resource.GetRelativePathToOEBPS())));
-            old_id = XtoQ(item->getAttribute(QtoX("id")));
+            item->setAttribute(xn::HREF, QtoX(Utility::URLEncodePath(resource.GetRelativePathToOEBPS())));
+            old_id = XtoQ(item->getAttribute(xn::ID));
             new_id = GetUniqueID(GetValidID(resource.Filename()), *document);
-            item->setAttribute(QtoX("id"), QtoX(new_id));
+            item->setAttribute(xn::ID, QtoX(new_id));
             break;
         }
     }
@@ -692,7 +630,7 @@ void OPFResource::RemoveFromSpine(const QString &id, xc::DOMDocument &document)
     }
     std::vector< xc::DOMElement * > children = xe::GetElementChildren(*spine);
     foreach(xc::DOMElement * child, children) {
-        QString idref = XtoQ(child->getAttribute(QtoX("idref")));
+        QString idref = XtoQ(child->getAttribute(xn::IDREF));
 
         if (idref == id) {
             spine->removeChild(child);
@@ -707,24 +645,130 @@ void OPFResource::UpdateItemrefID(const QString &old_id, const QString &new_id,
     xc::DOMElement *spine = GetSpineElement(document);
     std::vector< xc::DOMElement * > children = xe::GetElementChildren(*spine);
     foreach(xc::DOMElement * child, children) {
-        QString idref = XtoQ(child->getAttribute(QtoX("idref")));
+        QString idref = XtoQ(child->getAttribute(xn::IDREF));
 
         if (idref == old_id) {
-            child->setAttribute(QtoX("idref"), QtoX(new_id));
+            child->setAttribute(xn::IDREF, QtoX(new_id));
+            break;
+        }
+    }
+}
+
+
+shared_ptr< const OPFResource::PackageModel > OPFResource::GetPackageModel() const
+{
+    // Comparing the texts is cheap: unless the text has changed,
+    // both strings share the same data.
+    const QString text = GetText();
+    QMutexLocker locker(&m_PackageModelMutex);
+
+    if (!m_PackageModel || m_PackageModel->text != text) {
+        shared_ptr< PackageModel > package = CreatePackageModel(*LoadDocument(text));
+        package->text = text;
+        m_PackageModel = package;
+    }
+
+    return m_PackageModel;
+}
+
+
+shared_ptr< OPFResource::PackageModel > OPFResource::CreatePackageModel(const xc::DOMDocument &document)
+{
+    shared_ptr< PackageModel > package(new PackageModel());
+    QHash< QString, QString > filenames_by_id;
+    QList< xc::DOMElement * > items =
+        XhtmlDoc::GetTagMatchingDescendants(document, "item", OPF_XML_NAMESPACE);
+    foreach(xc::DOMElement * item, items) {
+        QString id   = XtoQ(item->getAttribute(xn::ID));
+        QString href = XtoQ(item->getAttribute(xn::HREF));
+        package->manifest.append(qMakePair(id, href));
+
+        if (!package->ids_by_href.contains(href)) {
+            package->ids_by_href[ href ] = id;
+            package->media_types_by_href[ href ] = XtoQ(item->getAttribute(QtoX("media-type")));
+        }
+
+        filenames_by_id[ id ] = QFileInfo(href).fileName();
+    }
+    QList< xc::DOMElement * > itemrefs =
+        XhtmlDoc::GetTagMatchingDescendants(document, "itemref", OPF_XML_NAMESPACE);
+    foreach(xc::DOMElement * itemref, itemrefs) {
+        QString idref = XtoQ(itemref->getAttribute(xn::IDREF));
+
+        if (!package->spine_positions.contains(idref)) {
+            package->spine_positions[ idref ] = package->spine.count();
+        }
+
+        package->spine.append(idref);
+
+        if (filenames_by_id.contains(idref)) {
+            package->spine_filenames.append(Utility::URLDecodePath(filenames_by_id[ idref ]));
+        }
+    }
+    QList< xc::DOMElement * > references =
+        XhtmlDoc::GetTagMatchingDescendants(document, "reference", OPF_XML_NAMESPACE);
+    foreach(xc::DOMElement * reference, references) {
+        const QString &href = XtoQ(reference->getAttribute(xn::HREF));
+        QString path = href.split('#', QString::KeepEmptyParts).at(0);
+        QString type = XtoQ(reference->getAttribute(xn::TYPE));
+        package->guide.append(qMakePair(path, type));
+
+        if (!package->guide_types_by_href.contains(path)) {
+            package->guide_types_by_href[ path ] = type;
+        }
+    }
+    xc::DOMElement *meta = GetCoverMeta(document);
+    package->has_cover_meta = meta != NULL;
+
+    if (meta) {
+        package->cover_id = XtoQ(meta->getAttribute(xn::CONTENT));
+    }
+
+    xc::DOMElement *main_identifier = GetMainIdentifierUnsafe(document);
+    Q_ASSERT(main_identifier);
+
+    if (main_identifier) {
+        package->main_identifier = XtoQ(main_identifier->getTextContent());
+    }
+
+    QList< xc::DOMElement * > identifiers =
+        XhtmlDoc::GetTagMatchingDescendants(document, "identifier", DUBLIN_CORE_NS);
+    foreach(xc::DOMElement * identifier, identifiers) {
+        QString value = XtoQ(identifier->getTextContent()).remove("urn:uuid:");
+
+        if (!QUuid(value).isNull()) {
+            package->uuid_identifier = value;
             break;
         }
     }
+    QList< xc::DOMElement * > dc_elements =
+        XhtmlDoc::GetTagMatchingDescendants(document, "*", DUBLIN_CORE_NS);
+    foreach(xc::DOMElement * dc_element, dc_elements) {
+        // Map the names in the OPF file to internal names
+        Metadata::MetaElement book_meta = Metadata::Instance().MapToBookMetadata(*dc_element);
+
+        if (!book_meta.name.isEmpty() && !book_meta.value.toString().isEmpty()) {
+            package->dc_metadata.append(book_meta);
+        }
+    }
+    return package;
 }
 
 
 shared_ptr< xc::DOMDocument > OPFResource::GetDocument() const
+{
+    return LoadDocument(GetText());
+}
+
+
+shared_ptr< xc::DOMDocument > OPFResource::LoadDocument(const QString &text) const
 {
     // The call to ProcessXML is needed because even though we have well-formed
     // checks tied to "focus lost" events of the OPF tab, on Win XP those events
     // are sometimes not delivered at all. Blame MS. In the mean time, this
     // work-around makes sure we get valid XML into Xerces no matter what.
     shared_ptr< xc::DOMDocument > document =
-        XhtmlDoc::LoadTextIntoDocument(CleanSource::ProcessXML(GetText()));
+        XhtmlDoc::LoadTextIntoDocument(CleanSource::ProcessXML(text));
 
     if (!BasicStructurePresent(*document)) {
         document = CreateOPFFromScratch(document.get());
@@ -807,7 +851,7 @@ xc::DOMElement *OPFResource::GetGuideReferenceForResource(const Resource &resour
     QList< xc::DOMElement * > references =
         XhtmlDoc::GetTagMatchingDescendants(document, "reference", OPF_XML_NAMESPACE);
     foreach(xc::DOMElement * reference, references) {
-        const QString &href = XtoQ(reference->getAttribute(QtoX("href")));
+        const QString &href = XtoQ(reference->getAttribute(xn::HREF));
         QStringList parts = href.split('#', QString::KeepEmptyParts);
 
         if (parts.at(0) == resource_oebps_path) {
@@ -839,7 +883,7 @@ GuideSemantics::GuideSemanticType OPFResource::GetGuideSemanticTypeForResource(
     xc::DOMElement *reference = GetGuideReferenceForResource(resource, document);
 
     if (reference) {
-        QString type = XtoQ(reference->getAttribute(QtoX("type")));
+        QString type = XtoQ(reference->getAttribute(xn::TYPE));
         return GuideSemantics::Instance().MapReferenceTypeToGuideEnum(type);
     }
 
@@ -858,8 +902,8 @@ void OPFResource::SetGuideSemanticTypeForResource(
     tie(type_attribute, title_attribute) = GuideSemantics::Instance().GetGuideTypeMapping()[ type ];
 
     if (reference) {
-        reference->setAttribute(QtoX("type"), QtoX(type_attribute));
-        reference->setAttribute(QtoX("title"), QtoX(title_attribute));
+        reference->setAttribute(xn::TYPE, QtoX(type_attribute));
+        reference->setAttribute(xn::TITLE, QtoX(title_attribute));
     } else {
         QHash< QString, QString > attributes;
         attributes[ "type"  ] = type_attribute;
@@ -892,7 +936,7 @@ void OPFResource::RemoveDuplicateGuideTypes(
     }
     QList<xc::DOMElement *> references = XhtmlDoc::GetTagMatchingDescendants(document, "reference", OPF_XML_NAMESPACE);
     foreach(xc::DOMElement * reference, references) {
-        QString type_text = XtoQ(reference->getAttribute(QtoX("type")));
+        QString type_text = XtoQ(reference->getAttribute(xn::TYPE));
         GuideSemantics::GuideSemanticType current_type = GuideSemantics::Instance().MapReferenceTypeToGuideEnum(type_text);
 
         if (current_type == new_type) {
@@ -926,7 +970,7 @@ QHash< ::HTMLResource *, xc::DOMElement * > OPFResource::GetItemrefsForHTMLResou
         ::HTMLResource *html_resource = qobject_cast< ::HTMLResource * >(resource);
         QString resource_id = id_mapping.value(resource, "");
         foreach(xc::DOMElement * itemref, itemrefs) {
-            QString idref = XtoQ(itemref->getAttribute(QtoX("idref")));
+            QString idref = XtoQ(itemref->getAttribute(xn::IDREF));
 
             if (idref == resource_id) {
                 itmeref_mapping[ html_resource ] = itemref;
@@ -961,7 +1005,7 @@ xc::DOMElement *OPFResource::GetCoverMeta(const xc::DOMDocument &document)
     QList< xc::DOMElement * > metas =
         XhtmlDoc::GetTagMatchingDescendants(document, "meta", OPF_XML_NAMESPACE);
     foreach(xc::DOMElement * meta, metas) {
-        QString name = XtoQ(meta->getAttribute(QtoX("name")));
+        QString name = XtoQ(meta->getAttribute(xn::NAME));
 
         if (name == "cover") {
             return meta;
@@ -990,7 +1034,7 @@ xc::DOMElement *OPFResource::GetMainIdentifierUnsafe(const xc::DOMDocument &docu
     QString unique_identifier = XtoQ(package->getAttribute(QtoX("unique-identifier")));
     QList<xc::DOMElement *> identifiers = XhtmlDoc::GetTagMatchingDescendants(document, "identifier", DUBLIN_CORE_NS);
     foreach(xc::DOMElement * identifier, identifiers) {
-        QString id = XtoQ(identifier->getAttribute(QtoX("id")));
+        QString id = XtoQ(identifier->getAttribute(xn::ID));
 
         if (id == unique_identifier) {
             return identifier;
@@ -1005,10 +1049,10 @@ QString OPFResource::GetResourceManifestID(const Resource &resource, const xc::D
     QList< xc::DOMElement * > items =
         XhtmlDoc::GetTagMatchingDescendants(document, "item", OPF_XML_NAMESPACE);
     foreach(xc::DOMElement * item, items) {
-        QString href = XtoQ(item->getAttribute(QtoX("href")));
+        QString href = XtoQ(item->getAttribute(xn::HREF));
 
         if (href == oebps_path) {
-            return XtoQ(item->getAttribute(QtoX("id")));
+            return XtoQ(item->getAttribute(xn::ID));
         }
     }
     return QString();
@@ -1025,10 +1069,10 @@ QHash< Resource *, QString > OPFResource::GetResourceManifestIDMapping(
     foreach(Resource * resource, resources) {
         QString oebps_path = Utility::URLEncodePath(resource->GetRelativePathToOEBPS());
         foreach(xc::DOMElement * item, items) {
-            QString href = XtoQ(item->getAttribute(QtoX("href")));
+            QString href = XtoQ(item->getAttribute(xn::HREF));
 
             if (href == oebps_path) {
-                id_mapping[ resource ] = XtoQ(item->getAttribute(QtoX("id")));
+                id_mapping[ resource ] = XtoQ(item->getAttribute(xn::ID));
                 break;
             }
         }
@@ -1166,7 +1210,7 @@ void OPFResource::WriteIdentifier(
     // of the main identifier that we preserved, so we don't write
     // it out if it is.
     if (metavalue == XtoQ(main_identifier.getTextContent()) &&
-        metaname == XtoQ(main_identifier.getAttributeNS(QtoX(OPF_XML_NAMESPACE), QtoX("scheme")))) {
+        metaname == XtoQ(main_identifier.getAttributeNS(QtoX(OPF_XML_NAMESPACE), xn::SCHEME))) {
         return;
     }
 
@@ -1305,8 +1349,8 @@ shared_ptr< xc::DOMDocument > OPFResource::CreateOPFFromScratch(const xc::DOMDoc
                 if (XtoQ(children.at(i)->getAttribute(QtoX("media-type"))).toLower() == NCX_MIMETYPE) {
                     continue;
                 }
-                id = XtoQ(children.at(i)->getAttribute(QtoX("id")));
-                href = XtoQ(children.at(i)->getAttribute(QtoX("href")));
+                id = XtoQ(children.at(i)->getAttribute(xn::ID));
+                href = XtoQ(children.at(i)->getAttribute(xn::HREF));
                 if (!id.isEmpty() && !href.isEmpty()) {
                     manifest_recovered.append(std::pair<QString, QString>(id, href));
                 }
@@ -1317,7 +1361,7 @@ shared_ptr< xc::DOMDocument > OPFResource::CreateOPFFromScratch(const xc::DOMDoc
         if (elem) {
             children = XhtmlDoc::GetTagMatchingDescendants(*elem, "itemref");;
             for (int i=0; i<children.length(); ++i) {
-                id = XtoQ(children.at(i)->getAttribute(QtoX("idref")));
+                id = XtoQ(children.at(i)->getAttribute(xn::IDREF));
                 if (!id.isEmpty()) {
                     spine_recovered.append(id);
                 }
@@ -25,6 +25,8 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <QtCore/QMutex>
+
 #include "BookManipulation/GuideSemantics.h"
 #include "ResourceObjects/XMLResource.h"
 #include "BookManipulation/Metadata.h"
@@ -86,6 +88,14 @@ public:
 
     bool IsCoverImage(const ::ImageResource &image_resource) const;
 
+    /**
+     * Returns the media type the manifest gives a resource.
+     *
+     * @return The media type, or an empty string if the
+     *         resource isn't in the manifest.
+     */
+    QString GetManifestMediaType(const Resource &resource) const;
+
     bool IsCoverImageCheck(const Resource &resource, xc::DOMDocument &document) const;
 
     bool IsCoverImageCheck(QString resource_id, xc::DOMDocument &document) const;
@@ -157,8 +167,88 @@ private:
 
     static void UpdateItemrefID(const QString &old_id, const QString &new_id, xc::DOMDocument &document);
 
+    /**
+     * What the read-only queries need to know about the package.
+     * It is extracted from the OPF DOM in a single pass, so that
+     * the queries don't have to parse the OPF text every time.
+     */
+    struct PackageModel {
+        /**
+         * The OPF text the model was built from.
+         */
+        QString text;
+
+        /**
+         * The (id, href) pairs of the manifest items, in document order.
+         */
+        QList< QPair< QString, QString > > manifest;
+
+        /**
+         * The id of the first manifest item with each href.
+         */
+        QHash< QString, QString > ids_by_href;
+
+        /**
+         * The media type of the first manifest item with each href.
+         */
+        QHash< QString, QString > media_types_by_href;
+
+        /**
+         * The idrefs of the spine itemrefs, in reading order.
+         */
+        QStringList spine;
+
+        /**
+         * The position of the first itemref with each idref.
+         */
+        QHash< QString, int > spine_positions;
+
+        /**
+         * The decoded file names of the spine items, in reading order.
+         */
+        QStringList spine_filenames;
+
+        /**
+         * The (href without fragment, type) pairs of the guide
+         * references, in document order.
+         */
+        QList< QPair< QString, QString > > guide;
+
+        /**
+         * The type of the first guide reference to each href.
+         */
+        QHash< QString, QString > guide_types_by_href;
+
+        bool has_cover_meta;
+
+        /**
+         * The content of the cover meta.
+         */
+        QString cover_id;
+
+        QString main_identifier;
+
+        /**
+         * The first identifier holding a UUID, without its "urn:uuid:"
+         * prefix. Empty if there is none.
+         */
+        QString uuid_identifier;
+
+        QList< Metadata::MetaElement > dc_metadata;
+    };
+
+    /**
+     * Returns the model of the current OPF text. The model is
+     * cached and only rebuilt after the text has changed.
+     */
+    boost::shared_ptr< const PackageModel > GetPackageModel() const;
+
+    static boost::shared_ptr< PackageModel > CreatePackageModel(const xc::DOMDocument &document);
+
     boost::shared_ptr< xc::DOMDocument > GetDocument() const;
 
+    boost::shared_ptr< xc::DOMDocument > LoadDocument(const QString &text) const;
+
     static xc::DOMElement *GetPackageElement(const xc::DOMDocument &document);
 
     static xc::DOMElement *GetMetadataElement(const xc::DOMDocument &document);
@@ -292,6 +382,13 @@ private:
      */
     QHash< QString, QString > m_Mimetypes;
 
+    /**
+     * The model of the OPF text last queried.
+     * Guarded by m_PackageModelMutex.
+     */
+    mutable boost::shared_ptr< const PackageModel > m_PackageModel;
+
+    mutable QMutex m_PackageModelMutex;
 };
 
 #endif // OPFRESOURCE_H
@@ -40,8 +40,10 @@ Resource::Resource(const QString &mainfolder, const QString &fullfilepath, QObje
     m_LastSaved(0),
     m_LastWrittenTo(0),
     m_LastWrittenSize(0),
+    m_Version(0),
     m_ReadWriteLock(QReadWriteLock::Recursive)
 {
+    connect(this, SIGNAL(Modified()), this, SLOT(IncrementVersion()));
 }
 
 bool Resource::operator< (const Resource &other)
@@ -171,6 +173,16 @@ void Resource::SaveToDisk(bool book_wide_save)
     }
 }
 
+int Resource::GetVersion() const
+{
+    return m_Version.load();
+}
+
+void Resource::IncrementVersion()
+{
+    m_Version.ref();
+}
+
 void Resource::FileChangedOnDisk()
 {
     QFileInfo latestFileInfo(m_FullFilePath);
@@ -202,6 +214,9 @@ void Resource::ResourceFileModified()
         m_LastWrittenSize = latestWrittenSize;
         QTimer::singleShot(WAIT_FOR_WRITE_DELAY, this, SLOT(ResourceFileModified()));
     } else {
+        // Whatever we knew about the file is out of date now.
+        IncrementVersion();
+
         if (LoadFromDisk()) {
             // will trigger marking the book as modified
             emit ResourceUpdatedFromDisk(*this);
@@ -23,6 +23,7 @@
 #ifndef RESOURCE_H
 #define RESOURCE_H
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QObject>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QUrl>
@@ -179,6 +180,15 @@ public:
      */
     virtual void SaveToDisk(bool book_wide_save = false);
 
+    /**
+     * Returns the resource's version. The version is incremented
+     * every time the resource is modified, so comparing it with
+     * a previously returned value tells whether anything changed.
+     *
+     * @return The resource's version.
+     */
+    int GetVersion() const;
+
     /**
      * Called by FolderKeeper when files get changed on disk.
      * May trigger a resource internal update if the files were not changed by Sigil.
@@ -231,6 +241,15 @@ protected:
      */
     virtual bool LoadFromDisk();
 
+protected slots:
+    /**
+     * Increments the resource's version.
+     * Subclasses that store their data from other threads call this
+     * directly once the data is stored, so that the new version is
+     * visible before the queued Modified() signal is delivered.
+     */
+    void IncrementVersion();
+
 private slots:
     /**
      * When ResourceFileChanged detects a modification this slot is activated on
@@ -267,6 +286,11 @@ private:
      */
     qint64 m_LastWrittenSize;
 
+    /**
+     * The resource's version, incremented on every modification.
+     */
+    QAtomicInt m_Version;
+
     /**
      * The ReadWriteLock guarding access to the resource's data.
      */
@@ -22,36 +22,65 @@
 #include <QtCore/QFile>
 #include <QtCore/QString>
 #include <QtCore/QThread>
-#include <QtCore/QTimer>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QPlainTextDocumentLayout>
 #include <QtGui/QTextDocument>
 
 #include "Misc/Utility.h"
 #include "ResourceObjects/TextResource.h"
+#include "ResourceObjects/TextUpdateQueue.h"
 #include "sigil_exception.h"
 
 TextResource::TextResource(const QString &mainfolder, const QString &fullfilepath, QObject *parent)
     :
     Resource(mainfolder, fullfilepath, parent),
-    m_CacheInUse(false),
-    m_TextDocument(new QTextDocument(this)),
-    m_IsLoaded(false)
+    m_UpdatePending(false),
+    m_TextDocument(NULL),
+    m_DocumentChanged(false),
+    m_IsLoaded(false),
+    m_SavedVersion(-1)
 {
-    m_TextDocument->setDocumentLayout(new QPlainTextDocumentLayout(m_TextDocument));
-    connect(m_TextDocument, SIGNAL(contentsChanged()), this, SIGNAL(Modified()));
+}
+
+
+TextResource::~TextResource()
+{
+    QMutexLocker locker(&m_TextAccessMutex);
+
+    if (m_UpdatePending) {
+        TextUpdateQueue::instance()->Remove(this);
+    }
 }
 
 
 QString TextResource::GetText() const
 {
-    QMutexLocker locker(&m_CacheAccessMutex);
+    QMutexLocker locker(&m_TextAccessMutex);
 
-    if (m_CacheInUse) {
-        return m_Cache;
+    // Until the text is needed, the file is the only copy we keep.
+    // Once it has been read, we keep the text so that the file
+    // isn't read again on every call. The lock stays held so that
+    // StoreText() can't write the file while we read it.
+    if (!m_IsLoaded) {
+        try {
+            m_Text = Utility::ReadUnicodeTextFile(GetFullPath());
+            m_IsLoaded = true;
+        } catch (CannotOpenFile) {
+            // The file may not have been written yet.
+            return QString();
+        }
     }
 
-    return m_TextDocument->toPlainText();
+    // The text being edited in a tab is newer than ours. The document
+    // can only be read from the GUI thread; other threads get the text
+    // last synced with SyncTextFromDocument().
+    if (m_TextDocument && m_DocumentChanged && !m_UpdatePending &&
+        QThread::currentThread() == QApplication::instance()->thread()) {
+        m_Text = m_TextDocument->toPlainText();
+        m_DocumentChanged = false;
+    }
+
+    return m_Text;
 }
 
 
@@ -64,34 +93,90 @@ void TextResource::SetText(const QString &text)
     // CodeView base class to update as well and that will crash us since
     // the base class derives from QWidget (and those can only be updated
     // in the GUI thread).
-    //   So we cache the text update into m_Cache and update the QTextDocument
-    // when we return to the GUI thread. The single-shot timer makes sure
-    // of that.
+    //   So we store the text right away and update the QTextDocument
+    // when we return to the GUI thread. The TextUpdateQueue makes sure
+    // of that, batching the updates of all the resources set this way.
     if (QThread::currentThread() == QApplication::instance()->thread()) {
         SetTextInternal(text);
     } else {
-        QMutexLocker locker(&m_CacheAccessMutex);
-        m_Cache = text;
+        QMutexLocker locker(&m_TextAccessMutex);
+        SetTextDelayed(text);
+    }
+}
+
 
-        // We want to make sure we schedule only one delayed update
-        if (!m_CacheInUse) {
-            m_CacheInUse = true;
-            QTimer::singleShot(0, this, SLOT(DelayedUpdateToTextDocument()));
+void TextResource::StoreText(const QString &text)
+{
+    {
+        QMutexLocker locker(&m_TextAccessMutex);
+
+        if (!m_IsLoaded) {
+            Utility::WriteUnicodeTextFile(text, GetFullPath());
+            IncrementVersion();
+            locker.unlock();
+            emit Modified();
+            return;
         }
     }
+
+    SetText(text);
 }
 
 
 QTextDocument &TextResource::GetTextDocumentForWriting()
 {
-    Q_ASSERT(m_TextDocument);
+    if (!m_TextDocument) {
+        LoadText();
+        QTextDocument *document = new QTextDocument(this);
+        document->setDocumentLayout(new QPlainTextDocumentLayout(document));
+        document->setPlainText(GetText());
+        document->setModified(false);
+        connect(document, SIGNAL(contentsChanged()), this, SLOT(TextDocumentChanged()));
+        QMutexLocker locker(&m_TextAccessMutex);
+        m_TextDocument = document;
+        m_DocumentChanged = false;
+    }
+
     return *m_TextDocument;
 }
 
 
+void TextResource::ReleaseTextDocument()
+{
+    if (!m_TextDocument) {
+        return;
+    }
+
+    QMutexLocker locker(&m_TextAccessMutex);
+
+    if (m_DocumentChanged && !m_UpdatePending) {
+        m_Text = m_TextDocument->toPlainText();
+    }
+
+    QTextDocument *document = m_TextDocument;
+    m_TextDocument = NULL;
+    m_DocumentChanged = false;
+    locker.unlock();
+    disconnect(document, 0, this, 0);
+    // The views of the closing tab may still be using the document.
+    document->deleteLater();
+}
+
+
+void TextResource::SyncTextFromDocument()
+{
+    QMutexLocker locker(&m_TextAccessMutex);
+
+    if (m_TextDocument && m_DocumentChanged && !m_UpdatePending) {
+        m_Text = m_TextDocument->toPlainText();
+        m_DocumentChanged = false;
+    }
+}
+
+
 void TextResource::SaveToDisk(bool book_wide_save)
 {
-    if (!m_IsLoaded) {
+    if (!IsLoaded()) {
         return;
     }
 
@@ -99,16 +184,29 @@ void TextResource::SaveToDisk(bool book_wide_save)
     // here because that causes problems with epub export
     // when the user has not changed the text file.
     // (some text files have placeholder text on disk)
+    // We do skip the write if we already wrote this very version
+    // of the text though, so that the file keeps its timestamp.
+    bool update_pending = false;
     {
+        QMutexLocker locker(&m_TextAccessMutex);
+        update_pending = m_UpdatePending;
+    }
+    const int version = GetVersion();
+
+    if (update_pending || version != m_SavedVersion || !QFile::exists(GetFullPath())) {
         QWriteLocker locker(&GetLock());
         Utility::WriteUnicodeTextFile(GetText(), GetFullPath());
+        m_SavedVersion = version;
     }
 
     if (!book_wide_save) {
         emit ResourceUpdatedOnDisk();
     }
 
-    m_TextDocument->setModified(false);
+    if (m_TextDocument) {
+        m_TextDocument->setModified(false);
+    }
+
     Resource::SaveToDisk(book_wide_save);
 }
 
@@ -124,23 +222,18 @@ void TextResource::InitialLoad()
       * from the constructor would fail (which it used to do).
       *
       * For some resource types there is a call made afterwards which will result
-      * in the resource being loaded such as for HTML files, CSS, NCX and OPF
-      * (see UniversalUpdates.cpp and code setting default text for new html pages etc).
+      * in the resource being loaded such as for CSS, NCX and OPF
+      * (see ImportEPUB.cpp and code setting default text for new html pages etc).
       *
-      * For other text resource types, they will only get loaded on demand, when
-      * the tab is actually opened, TextTab.cpp will call this InitialLoad() function.
+      * HTML files are not loaded when a book is opened: their updates are
+      * written straight back to disk. Other text resource types are loaded
+      * when the tab is actually opened, TextTab.cpp will call this function.
       *
-      * If you were to write some code to iterate over resources that do not fall
-      * into the special cases above, you *must* call InitialLoad() first to ensure
-      * the data is loaded, or else it will be blank or have data depending on whether
-      * it had been opened in a tab first.
+      * GetText() reads the file of a resource that hasn't been loaded, so code
+      * iterating over resources doesn't need to call InitialLoad() first.
       */
     QWriteLocker locker(&GetLock());
-    Q_ASSERT(m_TextDocument);
-
-    if (m_TextDocument->toPlainText().isEmpty() && QFile::exists(GetFullPath())) {
-        SetText(Utility::ReadUnicodeTextFile(GetFullPath()));
-    }
+    LoadText();
 }
 
 
@@ -151,17 +244,15 @@ Resource::ResourceType TextResource::Type() const
 
 bool TextResource::LoadFromDisk()
 {
+    // The file already is the text of a resource that isn't loaded.
+    if (!IsLoaded()) {
+        return true;
+    }
+
     try {
         const QString &text = Utility::ReadUnicodeTextFile(GetFullPath());
-        QMutexLocker locker(&m_CacheAccessMutex);
-        m_Cache = text;
-
-        // We want to make sure we schedule only one delayed update
-        if (!m_CacheInUse) {
-            m_CacheInUse = true;
-            QTimer::singleShot(0, this, SLOT(DelayedUpdateToTextDocument()));
-        }
-
+        QMutexLocker locker(&m_TextAccessMutex);
+        SetTextDelayed(text);
         return true;
     } catch (CannotOpenFile) {
         // ?
@@ -171,30 +262,102 @@ bool TextResource::LoadFromDisk()
 }
 
 
-void TextResource::DelayedUpdateToTextDocument()
+void TextResource::LoadText()
 {
-    QMutexLocker locker(&m_CacheAccessMutex);
+    QMutexLocker locker(&m_TextAccessMutex);
 
-    if (!m_CacheInUse) {
+    if (m_IsLoaded) {
         return;
     }
 
-    SetTextInternal(m_Cache);
+    m_Text = ReadTextFromDisk();
+    m_IsLoaded = true;
+}
+
+
+QString TextResource::ReadTextFromDisk() const
+{
+    try {
+        return Utility::ReadUnicodeTextFile(GetFullPath());
+    } catch (CannotOpenFile) {
+        return QString();
+    }
+}
+
+
+void TextResource::SetTextDelayed(const QString &text)
+{
+    m_Text = text;
+    m_IsLoaded = true;
+    // Readers on other threads compare versions to find stale data,
+    // so don't wait for Modified() to reach the GUI thread.
+    IncrementVersion();
+
+    // We want to make sure we queue only one delayed update
+    if (!m_UpdatePending) {
+        m_UpdatePending = true;
+        TextUpdateQueue::instance()->Enqueue(this);
+    }
 }
 
 
-void TextResource::SetTextInternal(const QString &text)
+bool TextResource::ApplyPendingUpdate()
 {
+    QString text;
+    {
+        QMutexLocker locker(&m_TextAccessMutex);
+
+        if (!m_UpdatePending) {
+            return false;
+        }
+
+        text = m_Text;
+    }
+    // The views showing the document still need the document's own
+    // signals. Everybody else is told by the queue in one go.
+    SetTextInternal(text, false);
+    return !m_TextDocument;
+}
+
+
+void TextResource::TextDocumentChanged()
+{
+    {
+        QMutexLocker locker(&m_TextAccessMutex);
+        m_DocumentChanged = true;
+    }
+    emit Modified();
+}
+
+
+void TextResource::SetTextInternal(const QString &text, bool notify)
+{
+    {
+        QMutexLocker locker(&m_TextAccessMutex);
+        m_Text = text;
+        m_UpdatePending = false;
+        // Our resource has now been loaded with some text
+        m_IsLoaded = true;
+        IncrementVersion();
+    }
+
+    if (!m_TextDocument) {
+        if (notify) {
+            emit Modified();
+        }
+
+        return;
+    }
+
     m_TextDocument->setPlainText(text);
     m_TextDocument->setModified(false);
-    // Clear anything left in the cache
-    m_Cache = "";
-    m_CacheInUse = false;
-    // Our resource has now been loaded with some text
-    m_IsLoaded = true;
+    // The document now holds the very same text.
+    QMutexLocker locker(&m_TextAccessMutex);
+    m_DocumentChanged = false;
 }
 
-bool TextResource::IsLoaded()
+bool TextResource::IsLoaded() const
 {
+    QMutexLocker locker(&m_TextAccessMutex);
     return m_IsLoaded;
 }
@@ -32,6 +32,11 @@ class QTextDocument;
 /**
  * A parent class for textual resources like CSS and SVG images.
  * Takes care of loading and caching content etc.
+ *
+ * The text is kept in a plain (implicitly shared) QString. A QTextDocument
+ * is only created while a tab is editing the resource: it then holds the
+ * text being edited, which is synced back into the string when needed
+ * and when the tab releases the document.
  */
 class TextResource : public Resource
 {
@@ -49,7 +54,19 @@ public:
     TextResource(const QString &mainfolder, const QString &fullfilepath, QObject *parent = NULL);
 
     /**
-     * Returns the text stored in the resource.
+     * Destructor.
+     */
+    ~TextResource();
+
+    /**
+     * Returns the text stored in the resource. The text of a
+     * resource that hasn't been loaded yet is read from its file
+     * and kept, so the file is only read once.
+     *
+     * Only the GUI thread sees the edits made in an attached document
+     * right away. Other threads get the text as of the last call to
+     * SyncTextFromDocument(), so work on the book's resources has to
+     * be preceded by FolderKeeper::SyncTextsFromDocuments().
      *
      * @return The resource text.
      */
@@ -58,29 +75,79 @@ public:
     /**
      * Sets the text of the resource, replacing the stored content.
      */
-    void SetText(const QString &text);
+    virtual void SetText(const QString &text);
+
+    /**
+     * Replaces the text of the resource like SetText(), except that
+     * the text of a resource that hasn't been loaded yet is written
+     * straight to its file and the resource stays unloaded. Use this
+     * for book-wide updates so that files nobody has read don't
+     * end up in memory.
+     *
+     * @param text The new text.
+     */
+    void StoreText(const QString &text);
 
     /**
      * Returns a reference to the QTextDocument that can be read and written to
-     * in consumers. If you need just read access, use GetTextDocumentForReading().
+     * in consumers. The document is created with the text of the resource the
+     * first time this is called, and stays attached to the resource until
+     * ReleaseTextDocument() is called.
      *
      * @warning Make sure to get a write lock externally before calling this function!
+     * @warning Only call this from the GUI thread.
      *
      * @return A reference to the QTextDocument cache.
      */
     QTextDocument &GetTextDocumentForWriting();
 
+    /**
+     * Syncs the text of the attached QTextDocument back into the
+     * resource and drops the document. Tabs call this when they close.
+     * Does nothing if no document is attached.
+     *
+     * @warning Only call this from the GUI thread.
+     */
+    void ReleaseTextDocument();
+
+    /**
+     * Syncs the text being edited in the attached QTextDocument back
+     * into the resource, so that other threads can then read the text
+     * without touching the document.
+     * Does nothing if no document is attached.
+     *
+     * @warning Only call this from the GUI thread.
+     */
+    void SyncTextFromDocument();
+
     // inherited
     void SaveToDisk(bool book_wide_save = false);
 
     /**
-     * Loads the text content into the QTextDocument cache if
-     * nothing has been loaded so far. This is not done automatically
+     * Loads the text content from the file if nothing has
+     * been loaded so far. This is not done automatically
      * because we want to do loading on demand (for performance reasons).
      */
     virtual void InitialLoad();
 
-    bool IsLoaded();
+    /**
+     * Brings the attached QTextDocument up to date with the text
+     * set from another thread. Modified() is only emitted if a
+     * document is attached; otherwise the caller is responsible
+     * for notifying about the update.
+     *
+     * @return \c true if the text was updated without a document,
+     *         so that no Modified() signal has been emitted.
+     * @warning Only call this from the GUI thread.
+     * @see TextUpdateQueue
+     */
+    bool ApplyPendingUpdate();
+
+    /**
+     * Checks whether the text has been loaded into the resource.
+     * Until then, the file on disk holds the text of the resource.
+     */
+    bool IsLoaded() const;
 
     // inherited
     virtual ResourceType Type() const;
@@ -91,19 +158,40 @@ protected:
 private slots:
 
     /**
-     * Performs the delayed update of m_TextDocument with the text
-     * stored in m_Cache.
+     * Called when the text in the attached QTextDocument changes.
      */
-    void DelayedUpdateToTextDocument();
+    void TextDocumentChanged();
 
 private:
 
     /**
-     * Actually sets the text to m_TextDocument.
+     * Loads the text from the file if nothing has been loaded so far.
+     */
+    void LoadText();
+
+    /**
+     * Reads the text of the resource from its file.
+     *
+     * @return The text, or an empty string if the file can't be read.
+     */
+    QString ReadTextFromDisk() const;
+
+    /**
+     * Stores the text and queues the update
+     * of the document on the GUI thread.
+     *
+     * @warning m_TextAccessMutex must be locked when calling this.
+     */
+    void SetTextDelayed(const QString &text);
+
+    /**
+     * Actually sets the text on the GUI thread.
      *
      * @param text The text to set.
+     * @param notify If \c false, Modified() is not emitted
+     *               when no document is attached.
      */
-    void SetTextInternal(const QString &text);
+    void SetTextInternal(const QString &text, bool notify = true);
 
 
     ///////////////////////////////
@@ -111,27 +199,44 @@ private:
     ///////////////////////////////
 
     /**
-     * If \c true, then the m_Cache var is holding cached text.
+     * The text of the resource. While a document is attached and
+     * m_DocumentChanged is set, the document holds newer text.
      */
-    bool m_CacheInUse;
+    mutable QString m_Text;
 
     /**
-     * The cached text used when threads are in use. @see SetText() internals.
+     * If \c true, text set from another thread still has to
+     * be passed on to the document. @see SetText() internals.
      */
-    QString m_Cache;
+    bool m_UpdatePending;
 
     /**
-     * The access mutex for the cache.
+     * The access mutex for the text.
      */
-    mutable QMutex m_CacheAccessMutex;
+    mutable QMutex m_TextAccessMutex;
 
     /**
-     * The syntax colored cache of the TextResource text content.
+     * The syntax colored copy of the text that the tab editing
+     * the resource works on, or NULL if no tab is bound to it.
      */
     QTextDocument *m_TextDocument;
 
-    bool m_IsLoaded;
+    /**
+     * If \c true, the document has been edited
+     * since m_Text was last synced with it.
+     */
+    mutable bool m_DocumentChanged;
+
+    /**
+     * If \c false, the text hasn't been read from the file yet.
+     */
+    mutable bool m_IsLoaded;
+
+    /**
+     * The version of the resource that was last written to disk,
+     * or -1 if SaveToDisk() hasn't written anything yet.
+     */
+    int m_SavedVersion;
 };
 
 #endif // TEXTRESOURCE_H
-
@@ -0,0 +1,123 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QTimer>
+
+#include "ResourceObjects/TextResource.h"
+#include "ResourceObjects/TextUpdateQueue.h"
+
+// How long the GUI thread spends applying
+// updates before it handles other events.
+static const int TIME_SLICE_MSECS = 30;
+
+static QMutex s_InstanceMutex;
+
+TextUpdateQueue *TextUpdateQueue::m_instance = 0;
+
+TextUpdateQueue *TextUpdateQueue::instance()
+{
+    QMutexLocker locker(&s_InstanceMutex);
+
+    if (m_instance == 0) {
+        m_instance = new TextUpdateQueue();
+    }
+
+    return m_instance;
+}
+
+
+TextUpdateQueue::TextUpdateQueue()
+    :
+    m_ApplyScheduled(false)
+{
+    // The queue can be created from a worker thread,
+    // but the updates must always be applied on the GUI thread.
+    moveToThread(QCoreApplication::instance()->thread());
+}
+
+
+void TextUpdateQueue::Enqueue(TextResource *resource)
+{
+    QMutexLocker locker(&m_AccessMutex);
+
+    if (!m_PendingSet.contains(resource)) {
+        m_PendingSet.insert(resource);
+        m_Pending.append(resource);
+    }
+
+    if (!m_ApplyScheduled) {
+        m_ApplyScheduled = true;
+        QMetaObject::invokeMethod(this, "ApplyPendingUpdates", Qt::QueuedConnection);
+    }
+}
+
+
+void TextUpdateQueue::Remove(TextResource *resource)
+{
+    QMutexLocker locker(&m_AccessMutex);
+
+    if (m_PendingSet.remove(resource)) {
+        m_Pending.removeOne(resource);
+    }
+}
+
+
+void TextUpdateQueue::ApplyPendingUpdates()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QList< TextResource * > updated;
+
+    forever {
+        TextResource *resource = NULL;
+        {
+            QMutexLocker locker(&m_AccessMutex);
+
+            if (m_Pending.isEmpty()) {
+                m_ApplyScheduled = false;
+                break;
+            }
+
+            if (timer.elapsed() >= TIME_SLICE_MSECS) {
+                // Let the event loop breathe before the next slice.
+                QTimer::singleShot(0, this, SLOT(ApplyPendingUpdates()));
+                break;
+            }
+
+            resource = m_Pending.takeFirst();
+            m_PendingSet.remove(resource);
+        }
+
+        // The lock is released so that workers can keep queueing
+        // updates (and the resource can take its own locks).
+        if (resource->ApplyPendingUpdate()) {
+            updated.append(resource);
+        }
+    }
+
+    if (!updated.isEmpty()) {
+        emit ResourcesUpdated(updated);
+    }
+}
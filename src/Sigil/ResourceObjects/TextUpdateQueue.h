@@ -0,0 +1,131 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef TEXTUPDATEQUEUE_H
+#define TEXTUPDATEQUEUE_H
+
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+
+class TextResource;
+
+/**
+ * Singleton. Collects the text resources whose text was set from
+ * worker threads and brings them up to date on the GUI thread.
+ *
+ * Instead of every resource scheduling its own update, the pending
+ * resources are applied together in bounded time slices, so a
+ * book-wide update doesn't flood the event loop and the UI stays
+ * responsive while the updates are being applied. A resource set
+ * several times before its update runs is only updated once.
+ *
+ * Resources without a QTextDocument don't emit Modified() for the
+ * updates applied here; ResourcesUpdated() is emitted once per slice
+ * for all of them instead. Resources with a document still notify
+ * their views through the document.
+ */
+class TextUpdateQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * The accessor function to access the queue.
+     * Safe to call from any thread.
+     */
+    static TextUpdateQueue *instance();
+
+    /**
+     * Queues the update of a resource. Safe to call from any thread.
+     *
+     * @param resource The resource with a pending update.
+     */
+    void Enqueue(TextResource *resource);
+
+    /**
+     * Drops the pending update of a resource.
+     * Called when the resource is destroyed.
+     *
+     * @param resource The resource to forget.
+     */
+    void Remove(TextResource *resource);
+
+signals:
+
+    /**
+     * Emitted once per applied slice of updates, on the GUI thread.
+     *
+     * @param resources The resources updated without emitting Modified().
+     */
+    void ResourcesUpdated(const QList< TextResource * > &resources);
+
+private slots:
+
+    /**
+     * Applies the pending updates until the time slice is used up,
+     * and schedules the rest for later.
+     */
+    void ApplyPendingUpdates();
+
+private:
+
+    /**
+     * Private constructor.
+     */
+    TextUpdateQueue();
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    /**
+     * The resources with pending updates, in the order
+     * their updates were queued.
+     */
+    QList< TextResource * > m_Pending;
+
+    /**
+     * The same resources, for fast lookups.
+     */
+    QSet< TextResource * > m_PendingSet;
+
+    /**
+     * Set when ApplyPendingUpdates() has been scheduled to run.
+     */
+    bool m_ApplyScheduled;
+
+    /**
+     * The access mutex for the pending updates.
+     */
+    QMutex m_AccessMutex;
+
+    /**
+     * The single instance of the queue.
+     */
+    static TextUpdateQueue *m_instance;
+};
+
+#endif // TEXTUPDATEQUEUE_H
@@ -29,6 +29,7 @@
 #include <QtConcurrent/QtConcurrent>
 
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/Utility.h"
 #include "ResourceObjects/HTMLResource.h"
@@ -105,7 +106,7 @@ void AnchorUpdates::UpdateAnchorsInOneFile(HTMLResource *html_resource,
     QWriteLocker locker(&html_resource->GetLock());
     shared_ptr<xc::DOMDocument> d = XhtmlDoc::LoadTextIntoDocument(html_resource->GetText());
     xc::DOMDocument &document = *d.get();
-    xc::DOMNodeList *anchors  = document.getElementsByTagName(QtoX("a"));
+    xc::DOMNodeList *anchors  = document.getElementsByTagName(xn::A);
     const QString &resource_filename = html_resource->Filename();
     bool is_changed = false;
 
@@ -113,9 +114,9 @@ void AnchorUpdates::UpdateAnchorsInOneFile(HTMLResource *html_resource,
         xc::DOMElement &element = *static_cast< xc::DOMElement * >(anchors->item(i));
         Q_ASSERT(&element);
 
-        if (element.hasAttribute(QtoX("href")) &&
-            QUrl(XtoQ(element.getAttribute(QtoX("href")))).isRelative()) {
-            QString href = XtoQ(element.getAttribute(QtoX("href")));
+        if (element.hasAttribute(xn::HREF) &&
+            QUrl(XtoQ(element.getAttribute(xn::HREF))).isRelative()) {
+            QString href = XtoQ(element.getAttribute(xn::HREF));
             QStringList parts = href.split(QChar('#'), QString::KeepEmptyParts);
 
             if (parts.length() > 1) {
@@ -130,7 +131,7 @@ void AnchorUpdates::UpdateAnchorsInOneFile(HTMLResource *html_resource,
                                               .append(Utility::URLEncodePath(file_id))
                                               .append("#")
                                               .append(fragment_id);
-                    element.setAttribute(QtoX("href"), QtoX(attribute_value));
+                    element.setAttribute(xn::HREF, QtoX(attribute_value));
                     is_changed = true;
                 }
             }
@@ -149,7 +150,7 @@ void AnchorUpdates::UpdateExternalAnchorsInOneFile(HTMLResource *html_resource,
     QWriteLocker locker(&html_resource->GetLock());
     shared_ptr<xc::DOMDocument> d = XhtmlDoc::LoadTextIntoDocument(html_resource->GetText());
     xc::DOMDocument &document = *d.get();
-    xc::DOMNodeList *anchors  = document.getElementsByTagName(QtoX("a"));
+    xc::DOMNodeList *anchors  = document.getElementsByTagName(xn::A);
     QString original_filename_with_relative_path = "../" % TEXT_FOLDER_NAME % "/" % originating_filename;
     bool is_changed = false;
 
@@ -160,9 +161,9 @@ void AnchorUpdates::UpdateExternalAnchorsInOneFile(HTMLResource *html_resource,
         // We're only interested in hrefs of the form "originating_filename#fragment_id".
         // But must be wary of hrefs that are "originating_filename", "originating_filename#" or "#fragment_id"
         // First, we find the hrefs that are relative and contain a fragment id.
-        if (element.hasAttribute(QtoX("href")) &&
-            QUrl(XtoQ(element.getAttribute(QtoX("href")))).isRelative()) {
-            QString href = XtoQ(element.getAttribute(QtoX("href")));
+        if (element.hasAttribute(xn::HREF) &&
+            QUrl(XtoQ(element.getAttribute(xn::HREF))).isRelative()) {
+            QString href = XtoQ(element.getAttribute(xn::HREF));
             QStringList parts = href.split(QChar('#'), QString::KeepEmptyParts);
 
             // If the href pointed to the original file then update the file_id.
@@ -174,7 +175,7 @@ void AnchorUpdates::UpdateExternalAnchorsInOneFile(HTMLResource *html_resource,
                                           .append(Utility::URLEncodePath(ID_locations.value(fragment_id)))
                                           .append("#")
                                           .append(fragment_id);
-                element.setAttribute(QtoX("href"), QtoX(attribute_value));
+                element.setAttribute(xn::HREF, QtoX(attribute_value));
                 is_changed = true;
             }
         }
@@ -195,7 +196,7 @@ void AnchorUpdates::UpdateAllAnchorsInOneFile(HTMLResource *html_resource,
     QWriteLocker locker(&html_resource->GetLock());
     shared_ptr<xc::DOMDocument> d = XhtmlDoc::LoadTextIntoDocument(html_resource->GetText());
     xc::DOMDocument &document = *d.get();
-    xc::DOMNodeList *anchors  = document.getElementsByTagName(QtoX("a"));
+    xc::DOMNodeList *anchors  = document.getElementsByTagName(xn::A);
     bool is_changed = false;
 
     for (uint i = 0; i < anchors->getLength(); ++i) {
@@ -203,17 +204,17 @@ void AnchorUpdates::UpdateAllAnchorsInOneFile(HTMLResource *html_resource,
         Q_ASSERT(&element);
 
         // We find the hrefs that are relative and contain an href.
-        if (element.hasAttribute(QtoX("href")) &&
-            QUrl(XtoQ(element.getAttribute(QtoX("href")))).isRelative()) {
+        if (element.hasAttribute(xn::HREF) &&
+            QUrl(XtoQ(element.getAttribute(xn::HREF))).isRelative()) {
             // Is this href in the form "originating_filename#fragment_id" or "originating_filename" or "#fragment_id"?
-            QString href = XtoQ(element.getAttribute(QtoX("href")));
+            QString href = XtoQ(element.getAttribute(xn::HREF));
             QStringList parts = href.split(QChar('#'), QString::KeepEmptyParts);
 
             // If the href pointed to the original file then update the file_id.
             if (originating_filename_links.contains(parts.at(0))) {
                 if (parts.count() == 1 || parts.at(1).isEmpty()) {
                     // This is a straight href with no anchor fragment
-                    element.setAttribute(QtoX("href"), QtoX(new_filename));
+                    element.setAttribute(xn::HREF, QtoX(new_filename));
                 } else {
                     // Rather than using parts.at(1) we will allow a # being part of the anchor
                     QString fragment_id = href.right(href.size() - (parts.at(0).length() + 1));
@@ -223,7 +224,7 @@ void AnchorUpdates::UpdateAllAnchorsInOneFile(HTMLResource *html_resource,
                                               .append(Utility::URLEncodePath(ID_locations.value(fragment_id)))
                                               .append("#")
                                               .append(fragment_id);
-                    element.setAttribute(QtoX("href"), QtoX(attribute_value));
+                    element.setAttribute(xn::HREF, QtoX(attribute_value));
                 }
 
                 is_changed = true;
@@ -244,7 +245,7 @@ void AnchorUpdates::UpdateTOCEntries(NCXResource *ncx_resource, const QString &o
     QWriteLocker locker(&ncx_resource->GetLock());
     shared_ptr<xc::DOMDocument> d = XhtmlDoc::LoadTextIntoDocument(ncx_resource->GetText());
     xc::DOMDocument &document = *d.get();
-    xc::DOMNodeList *anchors  = document.getElementsByTagName(QtoX("content"));
+    xc::DOMNodeList *anchors  = document.getElementsByTagName(xn::CONTENT);
     QString original_filename_with_relative_path = TEXT_FOLDER_NAME % "/" % originating_filename;
 
     for (uint i = 0; i < anchors->getLength(); ++i) {
@@ -253,9 +254,9 @@ void AnchorUpdates::UpdateTOCEntries(NCXResource *ncx_resource, const QString &o
 
         // We're only interested in src links of the form "originating_filename#fragment_id".
         // First, we find the hrefs that are relative and contain a fragment id.
-        if (element.hasAttribute(QtoX("src")) &&
-            QUrl(XtoQ(element.getAttribute(QtoX("src")))).isRelative()) {
-            QString src = XtoQ(element.getAttribute(QtoX("src")));
+        if (element.hasAttribute(xn::SRC) &&
+            QUrl(XtoQ(element.getAttribute(xn::SRC))).isRelative()) {
+            QString src = XtoQ(element.getAttribute(xn::SRC));
             QStringList parts = src.split(QChar('#'), QString::KeepEmptyParts);
 
             // If the src pointed to the original file then update the file_id.
@@ -266,7 +267,7 @@ void AnchorUpdates::UpdateTOCEntries(NCXResource *ncx_resource, const QString &o
                                           .append(Utility::URLEncodePath(ID_locations.value(fragment_id)))
                                           .append("#")
                                           .append(fragment_id);
-                element.setAttribute(QtoX("src"), QtoX(attribute_value));
+                element.setAttribute(xn::SRC, QtoX(attribute_value));
             }
         }
     }
@@ -27,6 +27,7 @@
 #include <QtConcurrent/QtConcurrent>
 
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "ResourceObjects/HTMLResource.h"
 #include "Misc/Utility.h"
@@ -50,10 +51,10 @@ void LinkUpdates::UpdateLinksInOneFile(HTMLResource *html_resource, QList<QStrin
     shared_ptr<xc::DOMDocument> d = XhtmlDoc::LoadTextIntoDocument(html_resource->GetText());
     xc::DOMDocument &document = *d.get();
     // head should only appear once
-    xc::DOMNodeList *heads = document.getElementsByTagName(QtoX("head"));
+    xc::DOMNodeList *heads = document.getElementsByTagName(xn::HEAD);
     xc::DOMElement &head_element = *static_cast< xc::DOMElement * >(heads->item(0));
     // We only want links in the head
-    xc::DOMNodeList *links = head_element.getElementsByTagName(QtoX("link"));
+    xc::DOMNodeList *links = head_element.getElementsByTagName(xn::LINK);
     // Remove the old stylesheet links
     // Link count is dynamic
     uint links_count = links->getLength();
@@ -63,20 +64,20 @@ void LinkUpdates::UpdateLinksInOneFile(HTMLResource *html_resource, QList<QStrin
         xc::DOMElement &element = *static_cast< xc::DOMElement * >(links->item(0));
         Q_ASSERT(&element);
 
-        if (element.hasAttribute(QtoX("type")) &&
-            XtoQ(element.getAttribute(QtoX("type"))) == "text/css" &&
-            element.hasAttribute(QtoX("rel")) &&
-            XtoQ(element.getAttribute(QtoX("rel"))) == "stylesheet") {
+        if (element.hasAttribute(xn::TYPE) &&
+            XtoQ(element.getAttribute(xn::TYPE)) == "text/css" &&
+            element.hasAttribute(xn::REL) &&
+            XtoQ(element.getAttribute(xn::REL)) == "stylesheet") {
             head_element.removeChild(&element);
         }
     }
 
     // Add the new stylesheet links
     foreach(QString stylesheet, new_stylesheets) {
-        xc::DOMElement *element = document.createElementNS(QtoX(HTML_XML_NAMESPACE), QtoX("link"));
-        element->setAttribute(QtoX("href"), QtoX(stylesheet));
-        element->setAttribute(QtoX("type"), QtoX("text/css"));
-        element->setAttribute(QtoX("rel"),  QtoX("stylesheet"));
+        xc::DOMElement *element = document.createElementNS(QtoX(HTML_XML_NAMESPACE), xn::LINK);
+        element->setAttribute(xn::HREF, QtoX(stylesheet));
+        element->setAttribute(xn::TYPE, QtoX("text/css"));
+        element->setAttribute(xn::REL,  QtoX("stylesheet"));
         head_element.appendChild(element);
     }
     html_resource->SetText(XhtmlDoc::GetDomDocumentAsString(document));
@@ -0,0 +1,373 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QtCore/QFileInfo>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+
+#include "sigil_constants.h"
+#include "SourceUpdates/PerformCSSUpdates.h"
+#include "SourceUpdates/PerformHTMLTextUpdates.h"
+#include "SourceUpdates/PerformHTMLUpdates.h"
+
+static const QString STYLE = "style";
+
+
+static inline bool IsXmlWhitespace(QChar c)
+{
+    ushort u = c.unicode();
+    return u == 0x20 || u == 0x9 || u == 0xA || u == 0xD;
+}
+
+
+// Returns the part of a qualified name after the prefix, without copying it.
+static QString LocalName(const QString &source, int start, int end)
+{
+    for (int i = end - 1; i >= start; --i) {
+        if (source.at(i) == QChar(':')) {
+            start = i + 1;
+            break;
+        }
+    }
+
+    return QString::fromRawData(source.constData() + start, end - start);
+}
+
+
+PerformHTMLTextUpdates::PerformHTMLTextUpdates(const QString &source,
+                                               const QHash< QString, QString > &html_updates,
+                                               const QHash< QString, QString > &css_updates)
+    :
+    m_Source(source),
+    m_HTMLUpdates(html_updates),
+    m_CSSUpdates(css_updates),
+    m_PathTags(PerformHTMLUpdates::PathTags()),
+    m_PathAttributes(PerformHTMLUpdates::PathAttributes()),
+    m_Copied(0),
+    m_Unsupported(false)
+{
+    foreach(QString key_path, css_updates.keys()) {
+        m_CSSFileNames.append(QFileInfo(key_path).fileName());
+    }
+}
+
+
+QString PerformHTMLTextUpdates::operator()()
+{
+    int length = m_Source.length();
+    int position = 0;
+
+    // The source is well-formed, so the markup only needs
+    // to be told apart, not checked.
+    while (!m_Unsupported) {
+        int tag_start = m_Source.indexOf(QChar('<'), position);
+
+        if (tag_start == -1) {
+            break;
+        }
+
+        const QStringRef &markup = m_Source.midRef(tag_start, 9);
+        int end = -1;
+
+        if (markup.startsWith(QLatin1String("<!--"))) {
+            end = m_Source.indexOf(QLatin1String("-->"), tag_start + 4);
+            position = end + 3;
+        } else if (markup.startsWith(QLatin1String("<![CDATA["))) {
+            end = m_Source.indexOf(QLatin1String("]]>"), tag_start + 9);
+            position = end + 3;
+        } else if (markup.startsWith(QLatin1String("<?"))) {
+            end = m_Source.indexOf(QLatin1String("?>"), tag_start + 2);
+            position = end + 2;
+
+            if (tag_start == 0 && end != -1 && markup.startsWith(QLatin1String("<?xml")) &&
+                markup.length() > 5 && IsXmlWhitespace(markup.at(5))) {
+                UpdateXmlDeclaration(end);
+            }
+        } else if (markup.startsWith(QLatin1String("<!"))) {
+            // The DOCTYPE. Its literals can hold any character.
+            for (int i = tag_start + 2; i < length; ++i) {
+                QChar c = m_Source.at(i);
+
+                if (c == QChar('"') || c == QChar('\'')) {
+                    i = m_Source.indexOf(c, i + 1);
+
+                    if (i == -1) {
+                        break;
+                    }
+                } else if (c == QChar('[')) {
+                    // An internal subset can declare entities and
+                    // attribute defaults that only a parser understands.
+                    m_Unsupported = true;
+                    break;
+                } else if (c == QChar('>')) {
+                    end = i;
+                    break;
+                }
+            }
+
+            position = end + 1;
+        } else if (markup.startsWith(QLatin1String("</"))) {
+            end = m_Source.indexOf(QChar('>'), tag_start + 2);
+            position = end + 1;
+        } else {
+            end = UpdateStartTag(tag_start);
+            position = end;
+        }
+
+        if (end == -1) {
+            m_Unsupported = true;
+        }
+    }
+
+    if (m_Unsupported) {
+        return QString();
+    }
+
+    // Nothing was replaced, so the source is returned as it was.
+    if (m_Result.isNull()) {
+        return m_Source;
+    }
+
+    m_Result.append(m_Source.midRef(m_Copied));
+    return m_Result;
+}
+
+
+int PerformHTMLTextUpdates::UpdateStartTag(int tag_start)
+{
+    int length = m_Source.length();
+    int i = tag_start + 1;
+
+    while (i < length && !IsXmlWhitespace(m_Source.at(i)) && m_Source.at(i) != QChar('>') && m_Source.at(i) != QChar('/')) {
+        ++i;
+    }
+
+    const QString &tag_name = LocalName(m_Source, tag_start + 1, i);
+    bool is_path_tag = m_PathTags.contains(tag_name, Qt::CaseInsensitive);
+    bool is_style_tag = tag_name.compare(STYLE, Qt::CaseInsensitive) == 0;
+    bool is_empty = false;
+    // Like PerformHTMLUpdates, only the first reference
+    // of an element that needs updating is updated.
+    bool path_updated = false;
+
+    while (true) {
+        while (i < length && IsXmlWhitespace(m_Source.at(i))) {
+            ++i;
+        }
+
+        if (i >= length) {
+            return -1;
+        }
+
+        if (m_Source.at(i) == QChar('>')) {
+            ++i;
+            break;
+        }
+
+        if (m_Source.at(i) == QChar('/')) {
+            i += 2;
+            is_empty = true;
+            break;
+        }
+
+        int name_start = i;
+
+        while (i < length && !IsXmlWhitespace(m_Source.at(i)) && m_Source.at(i) != QChar('=')) {
+            ++i;
+        }
+
+        int name_end = i;
+
+        while (i < length && m_Source.at(i) != QChar('"') && m_Source.at(i) != QChar('\'')) {
+            ++i;
+        }
+
+        if (i >= length) {
+            return -1;
+        }
+
+        QChar quote = m_Source.at(i);
+        int value_start = i + 1;
+        int value_end = m_Source.indexOf(quote, value_start);
+
+        if (value_end == -1) {
+            return -1;
+        }
+
+        i = value_end + 1;
+        const QString &attribute_name = LocalName(m_Source, name_start, name_end);
+
+        if (is_path_tag && !path_updated && m_PathAttributes.contains(attribute_name, Qt::CaseInsensitive)) {
+            QString value;
+
+            if (!DecodeAttributeValue(m_Source.mid(value_start, value_end - value_start), value)) {
+                return -1;
+            }
+
+            const QString &new_value = PerformXMLUpdates::UpdatedPathValue(value, m_HTMLUpdates);
+
+            if (!new_value.isEmpty()) {
+                Replace(value_start, value_end, EscapeAttributeValue(new_value, quote));
+                path_updated = true;
+            }
+        } else if (attribute_name.compare(STYLE, Qt::CaseInsensitive) == 0) {
+            UpdateCSS(value_start, value_end, true);
+        }
+    }
+
+    if (is_style_tag && !is_empty) {
+        int style_end = m_Source.indexOf(QLatin1String("</"), i);
+
+        if (style_end == -1) {
+            return -1;
+        }
+
+        UpdateCSS(i, style_end);
+        i = style_end;
+    }
+
+    return i;
+}
+
+
+void PerformHTMLTextUpdates::UpdateXmlDeclaration(int declaration_end)
+{
+    // The file is always written out as UTF-8.
+    QRegularExpression encoding(ENCODING_ATTRIBUTE);
+    QRegularExpressionMatch match = encoding.match(m_Source.left(declaration_end));
+
+    if (match.hasMatch() && match.captured(1).compare("UTF-8", Qt::CaseInsensitive) != 0) {
+        Replace(match.capturedStart(1), match.capturedEnd(1), "UTF-8");
+    }
+}
+
+
+void PerformHTMLTextUpdates::UpdateCSS(int start, int end, bool inline_style)
+{
+    if (m_CSSUpdates.isEmpty()) {
+        return;
+    }
+
+    const QString &css = m_Source.mid(start, end - start);
+    bool has_reference = false;
+
+    foreach(QString file_name, m_CSSFileNames) {
+        if (css.contains(file_name)) {
+            has_reference = true;
+            break;
+        }
+    }
+
+    if (!has_reference) {
+        return;
+    }
+
+    // PerformCSSUpdates only recognizes terminated declarations, but
+    // the last one of an inline style usually has no ';', as in
+    // style="background-image:url(../Images/a.png)". We terminate it
+    // for the update and take the terminator off again afterwards.
+    QString updated_css = PerformCSSUpdates(inline_style ? css + ";" : css, m_CSSUpdates)();
+
+    if (inline_style) {
+        updated_css.chop(1);
+    }
+
+    if (updated_css != css) {
+        Replace(start, end, updated_css);
+    }
+}
+
+
+void PerformHTMLTextUpdates::Replace(int start, int end, const QString &text)
+{
+    Q_ASSERT(start >= m_Copied);
+
+    if (m_Result.isNull()) {
+        m_Result.reserve(m_Source.length() + text.length());
+    }
+
+    m_Result.append(m_Source.midRef(m_Copied, start - m_Copied));
+    m_Result.append(text);
+    m_Copied = end;
+}
+
+
+bool PerformHTMLTextUpdates::DecodeAttributeValue(const QString &raw_value, QString &value)
+{
+    value.reserve(raw_value.length());
+    int length = raw_value.length();
+
+    for (int i = 0; i < length; ++i) {
+        QChar c = raw_value.at(i);
+
+        if (c == QChar('\t') || c == QChar('\n') || c == QChar('\r')) {
+            value.append(QChar(' '));
+            continue;
+        }
+
+        if (c != QChar('&')) {
+            value.append(c);
+            continue;
+        }
+
+        int end = raw_value.indexOf(QChar(';'), i);
+
+        if (end == -1) {
+            return false;
+        }
+
+        const QString &name = raw_value.mid(i + 1, end - i - 1);
+        i = end;
+
+        if (name == "amp") {
+            value.append(QChar('&'));
+        } else if (name == "lt") {
+            value.append(QChar('<'));
+        } else if (name == "gt") {
+            value.append(QChar('>'));
+        } else if (name == "quot") {
+            value.append(QChar('"'));
+        } else if (name == "apos") {
+            value.append(QChar('\''));
+        } else if (name.startsWith('#')) {
+            bool ok = false;
+            uint code_point = name.startsWith("#x") ? name.mid(2).toUInt(&ok, 16) : name.mid(1).toUInt(&ok, 10);
+
+            if (!ok) {
+                return false;
+            }
+
+            value.append(QString::fromUcs4(&code_point, 1));
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+QString PerformHTMLTextUpdates::EscapeAttributeValue(const QString &value, QChar quote)
+{
+    QString escaped = value;
+    escaped.replace("&", "&amp;").replace("<", "&lt;");
+    return quote == QChar('"') ? escaped.replace("\"", "&quot;") : escaped.replace("'", "&apos;");
+}
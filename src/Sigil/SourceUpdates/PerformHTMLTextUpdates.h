@@ -0,0 +1,138 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef PERFORMHTMLTEXTUPDATES_H
+#define PERFORMHTMLTEXTUPDATES_H
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+/**
+ * Performs path updates directly on the text of a well-formed
+ * XHTML file, without building a DOM.
+ *
+ * Only the values of the path attributes PerformHTMLUpdates looks at,
+ * the style attributes and the contents of style elements are rewritten.
+ * Every other character of the source is left as it was, so the
+ * formatting of the file survives the updates.
+ */
+class PerformHTMLTextUpdates
+{
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param source The text of the XHTML file. It must be well-formed.
+     * @param html_updates The path updates for the path attributes.
+     * @param css_updates The path updates for the CSS in the file.
+     */
+    PerformHTMLTextUpdates(const QString &source,
+                           const QHash< QString, QString > &html_updates,
+                           const QHash< QString, QString > &css_updates);
+
+    /**
+     * Performs the updates.
+     *
+     * @return The updated source, or a null string if the source has
+     *         markup that can only be handled by PerformHTMLUpdates,
+     *         like an internal DTD subset.
+     */
+    QString operator()();
+
+private:
+
+    /**
+     * Scans the start tag beginning at the specified position,
+     * and updates its attributes and the style element it may open.
+     *
+     * @return The position after the tag, or -1 if the tag can't be handled.
+     */
+    int UpdateStartTag(int tag_start);
+
+    /**
+     * Makes sure the XML declaration, if any, says the file is UTF-8.
+     */
+    void UpdateXmlDeclaration(int declaration_end);
+
+    /**
+     * Runs the CSS updates over the specified part of the source.
+     *
+     * @param inline_style Set for the value of a style attribute, whose
+     *                     last declaration doesn't need to end with a ';'.
+     */
+    void UpdateCSS(int start, int end, bool inline_style = false);
+
+    /**
+     * Replaces a part of the source in the result.
+     * Replacements have to be made from the start of the source to its end.
+     */
+    void Replace(int start, int end, const QString &text);
+
+    /**
+     * Resolves the references and normalizes the whitespace in
+     * an attribute value the way an XML parser would.
+     *
+     * @return False if the value has a reference to an entity
+     *         that isn't predefined.
+     */
+    static bool DecodeAttributeValue(const QString &raw_value, QString &value);
+
+    static QString EscapeAttributeValue(const QString &value, QChar quote);
+
+
+    ///////////////////////////////
+    // PRIVATE MEMBER VARIABLES
+    ///////////////////////////////
+
+    const QString &m_Source;
+
+    const QHash< QString, QString > &m_HTMLUpdates;
+
+    const QHash< QString, QString > &m_CSSUpdates;
+
+    /**
+     * The file names of the CSS updates. Parts of the source
+     * without any of them don't need to go through the CSS updates.
+     */
+    QStringList m_CSSFileNames;
+
+    QStringList m_PathTags;
+
+    QStringList m_PathAttributes;
+
+    /**
+     * The updated source, up to the position m_Copied of the original.
+     */
+    QString m_Result;
+
+    int m_Copied;
+
+    /**
+     * Set when the source can't be updated as text.
+     */
+    bool m_Unsupported;
+};
+
+#endif // PERFORMHTMLTEXTUPDATES_H
@@ -60,10 +60,16 @@ shared_ptr< xc::DOMDocument > PerformHTMLUpdates::operator()()
 }
 
 
-void PerformHTMLUpdates::InitPathTags()
+QStringList PerformHTMLUpdates::PathTags()
 {
     // We look at a different set of tags
     // This is the list of tags whose contents will be scanned for file references
     // that need to be updated.
-    m_PathTags = QStringList() << "audio" << "link" << "a" << "img" << "image" << "script" << "video";
+    return QStringList() << "audio" << "link" << "a" << "img" << "image" << "script" << "video";
+}
+
+
+void PerformHTMLUpdates::InitPathTags()
+{
+    m_PathTags = PathTags();
 }
@@ -40,6 +40,11 @@ public:
 
     shared_ptr< xc::DOMDocument > operator()();
 
+    /**
+     * The tags whose attributes can hold file references.
+     */
+    static QStringList PathTags();
+
 private:
 
     void InitPathTags();
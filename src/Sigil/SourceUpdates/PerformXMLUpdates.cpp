@@ -85,84 +85,106 @@ void PerformXMLUpdates::UpdateReferenceInNode(xc::DOMElement *node)
 {
     xc::DOMNamedNodeMap &attributes = *node->getAttributes();
     int num_attributes = attributes.getLength();
-    const QList< QString > &keys = m_XMLUpdates.keys();
-    int num_keys = keys.count();
 
     for (int i = 0; i < num_attributes; ++i) {
         xc::DOMAttr &attribute = *static_cast< xc::DOMAttr * >(attributes.item(i));
         Q_ASSERT(&attribute);
 
-        if (!m_PathAttributes.contains(XhtmlDoc::GetAttributeName(attribute), Qt::CaseInsensitive)) {
+        // The name without its prefix is only compared,
+        // so it's viewed in place rather than copied.
+        const XMLCh *name = attribute.getName();
+        int colon_index = xc::XMLString::lastIndexOf(name, xc::chColon);
+
+        if (!m_PathAttributes.contains(XtoQView(name + colon_index + 1), Qt::CaseInsensitive)) {
             continue;
         }
 
-        for (int j = 0; j < num_keys; ++j) {
-            const QString &key_path        = keys.at(j);
-            const QString &filename        = QFileInfo(key_path).fileName();
-            const QString &atrribute_value = Utility::URLDecodePath(XtoQ(attribute.getValue()));
-            int name_index = atrribute_value.lastIndexOf(filename);
-
-            if (name_index == -1) {
-                continue;
-            }
-
-            int filename_length  = filename.length();
-            int name_end_index   = name_index + filename_length;
-            bool has_fragment_id = name_end_index < atrribute_value.length() &&
-                                   atrribute_value.at(name_end_index) == POUND_SIGN;
-            // The left() call returns the part of the string before the
-            // fragment ID, if any.
-            const QString &attribute_path_dir_name =
-                !has_fragment_id                                                   ?
-                QFileInfo(atrribute_value).dir().dirName()                       :
-                QFileInfo(atrribute_value.left(name_end_index)).dir().dirName();
-            const QString &old_path_dir_name = QFileInfo(key_path).dir().dirName();
-
-            // We need to make sure that files that have the same name,
-            // but a different parent directory still compare differently.
-            // This still isn't perfect since they could differ in the
-            // grandfather directory, but comparing absolute values would
-            // mean querying the filesystem and that would kill performance.
-            // This is good enough (famous last words etc...).
-            if (!attribute_path_dir_name.isEmpty()           &&
-                attribute_path_dir_name != DOT               &&
-                attribute_path_dir_name != DOT_DOT           &&
-                attribute_path_dir_name != old_path_dir_name) {
-                continue;
-            }
-
-            int atr_value_length = atrribute_value.length();
-            QString new_path;
-
-            // First we look at whether the filename matches the attribute value,
-            // and then we determine whether it's actually a path that ends with the filename
-            if (filename_length == atr_value_length ||
-                (name_end_index == atr_value_length &&
-                 atrribute_value.at(name_index - 1) == FORWARD_SLASH
-                )
-               ) {
-                new_path = m_XMLUpdates.value(key_path);
-            } else if (has_fragment_id &&
-                       (name_index == 0 ||
-                        atrribute_value.at(name_index - 1) == FORWARD_SLASH
-                       )
-                      ) {
-                new_path = atrribute_value.mid(name_end_index).prepend(m_XMLUpdates.value(key_path));
-            }
-
-            if (!new_path.isEmpty()) {
-                attribute.setValue(QtoX(Utility::URLEncodePath(new_path)));
-                // We assign to "i" to break the outer loop
-                i = num_attributes;
-                break;
-            }
+        const QString &new_value = UpdatedPathValue(XtoQ(attribute.getValue()), m_XMLUpdates);
+
+        if (!new_value.isEmpty()) {
+            attribute.setValue(QtoX(new_value));
+            break;
         }
     }
 }
 
 
+QString PerformXMLUpdates::UpdatedPathValue(const QString &value, const QHash< QString, QString > &xml_updates)
+{
+    const QString &atrribute_value = Utility::URLDecodePath(value);
+    const QList< QString > &keys = xml_updates.keys();
+    int num_keys = keys.count();
+
+    for (int j = 0; j < num_keys; ++j) {
+        const QString &key_path        = keys.at(j);
+        const QString &filename        = QFileInfo(key_path).fileName();
+        int name_index = atrribute_value.lastIndexOf(filename);
+
+        if (name_index == -1) {
+            continue;
+        }
+
+        int filename_length  = filename.length();
+        int name_end_index   = name_index + filename_length;
+        bool has_fragment_id = name_end_index < atrribute_value.length() &&
+                               atrribute_value.at(name_end_index) == POUND_SIGN;
+        // The left() call returns the part of the string before the
+        // fragment ID, if any.
+        const QString &attribute_path_dir_name =
+            !has_fragment_id                                                   ?
+            QFileInfo(atrribute_value).dir().dirName()                       :
+            QFileInfo(atrribute_value.left(name_end_index)).dir().dirName();
+        const QString &old_path_dir_name = QFileInfo(key_path).dir().dirName();
+
+        // We need to make sure that files that have the same name,
+        // but a different parent directory still compare differently.
+        // This still isn't perfect since they could differ in the
+        // grandfather directory, but comparing absolute values would
+        // mean querying the filesystem and that would kill performance.
+        // This is good enough (famous last words etc...).
+        if (!attribute_path_dir_name.isEmpty()           &&
+            attribute_path_dir_name != DOT               &&
+            attribute_path_dir_name != DOT_DOT           &&
+            attribute_path_dir_name != old_path_dir_name) {
+            continue;
+        }
+
+        int atr_value_length = atrribute_value.length();
+        QString new_path;
+
+        // First we look at whether the filename matches the attribute value,
+        // and then we determine whether it's actually a path that ends with the filename
+        if (filename_length == atr_value_length ||
+            (name_end_index == atr_value_length &&
+             atrribute_value.at(name_index - 1) == FORWARD_SLASH
+            )
+           ) {
+            new_path = xml_updates.value(key_path);
+        } else if (has_fragment_id &&
+                   (name_index == 0 ||
+                    atrribute_value.at(name_index - 1) == FORWARD_SLASH
+                   )
+                  ) {
+            new_path = atrribute_value.mid(name_end_index).prepend(xml_updates.value(key_path));
+        }
+
+        if (!new_path.isEmpty()) {
+            return Utility::URLEncodePath(new_path);
+        }
+    }
+
+    return QString();
+}
+
+
+QStringList PerformXMLUpdates::PathAttributes()
+{
+    return QStringList() << "href" << "src";
+}
+
+
 void PerformXMLUpdates::InitPathAttributes()
 {
-    m_PathAttributes << "href" << "src";
+    m_PathAttributes = PathAttributes();
 }
 
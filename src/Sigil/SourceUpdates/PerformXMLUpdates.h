@@ -68,6 +68,20 @@ public:
      */
     virtual shared_ptr< xc::DOMDocument > operator()();
 
+    /**
+     * Works out the new value of an attribute that holds a path.
+     *
+     * @param value The current value of the attribute, with entities resolved.
+     * @param xml_updates The path updates.
+     * @return The new value, or an empty string if the path isn't updated.
+     */
+    static QString UpdatedPathValue(const QString &value, const QHash< QString, QString > &xml_updates);
+
+    /**
+     * The attributes of path tags that can hold file references.
+     */
+    static QStringList PathAttributes();
+
 protected:
 
     /**
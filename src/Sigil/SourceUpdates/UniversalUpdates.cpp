@@ -40,6 +40,7 @@
 #include "ResourceObjects/CSSResource.h"
 #include "sigil_constants.h"
 #include "sigil_exception.h"
+#include "SourceUpdates/PerformHTMLTextUpdates.h"
 #include "SourceUpdates/PerformHTMLUpdates.h"
 #include "SourceUpdates/PerformCSSUpdates.h"
 #include "SourceUpdates/PerformNCXUpdates.h"
@@ -208,14 +209,25 @@ QString UniversalUpdates::LoadAndUpdateOneHTMLFile(HTMLResource *html_resource,
         return QString();
     }
 
-    // non_well_formed will only be set if the user has chosen not to have
-    // the file auto fixed.
-    if (non_well_formed.contains(html_resource)) {
-        return QString("%1: %2").arg(NON_WELL_FORMED_MESSAGE).arg(html_resource->Filename());
-    }
+    // The text is not loaded into the resource. We work on a copy
+    // decoded from the file and write the result back to the file.
+    const bool from_disk = !html_resource->IsLoaded();
+    QString original;
 
     try {
-        source = XhtmlDoc::ResolveCustomEntities(html_resource->GetText());
+        original = from_disk ?
+                   HTMLEncodingResolver::ReadHTMLFile(html_resource->GetFullPath()) :
+                   html_resource->GetText();
+        source = original;
+
+        // non_well_formed will only be set if the user has chosen not to have
+        // the file auto fixed.
+        if (non_well_formed.contains(html_resource)) {
+            KeepOriginalHTML(html_resource, original, from_disk);
+            return QString("%1: %2").arg(NON_WELL_FORMED_MESSAGE).arg(html_resource->Filename());
+        }
+
+        source = XhtmlDoc::ResolveCustomEntities(source);
         source = CleanSource::NbspToEntity(source);
 
         if (ss.cleanOn() & CLEANON_OPEN) {
@@ -227,27 +239,52 @@ QString UniversalUpdates::LoadAndUpdateOneHTMLFile(HTMLResource *html_resource,
             throw QObject::tr(NON_WELL_FORMED_MESSAGE);
         }
 
-        source = XhtmlDoc::GetDomDocumentAsString(*PerformHTMLUpdates(source, html_updates, css_updates)().get());
-        // For files that are valid we need to do a second clean because Xerces (PerformHTMLUpdates) will remove
-        // the formatting.
-        if (ss.cleanOn() & CLEANON_OPEN) {
-            source = CleanSource::Clean(source);
+        // The references are updated in the text, which leaves the rest of the file alone.
+        const QString &updated_source = PerformHTMLTextUpdates(source, html_updates, css_updates)();
+
+        if (!updated_source.isNull()) {
+            source = updated_source;
+        } else {
+            source = XhtmlDoc::GetDomDocumentAsString(*PerformHTMLUpdates(source, html_updates, css_updates)().get());
+
+            // For files that are valid we need to do a second clean because Xerces (PerformHTMLUpdates) will remove
+            // the formatting.
+            if (ss.cleanOn() & CLEANON_OPEN) {
+                source = CleanSource::Clean(source);
+            }
         }
-        html_resource->SetText(source);
+        html_resource->StoreText(source);
         return QString();
     } catch (const ErrorBuildingDOM &) {
         // It would be great if we could just let this exception bubble up,
         // but we can't since QtConcurrent doesn't let exceptions cross threads.
         // So we just leave the old source in the resource.
+        KeepOriginalHTML(html_resource, original, from_disk);
         return QString(QObject::tr("Invalid HTML file: %1")).arg(html_resource->Filename());
     } catch (const QString &err) {
+        KeepOriginalHTML(html_resource, original, from_disk);
         return QString("%1: %2").arg(err).arg(html_resource->Filename());
     } catch (...) {
+        KeepOriginalHTML(html_resource, original, from_disk);
         return QString("Cannot perform HTML updates there was an unrecoverable error: %1").arg(html_resource->Filename());
     }
 }
 
 
+void UniversalUpdates::KeepOriginalHTML(HTMLResource *html_resource, const QString &original, bool from_disk)
+{
+    // The file may still be in the encoding it had in the epub,
+    // so we store the decoded text back as UTF-8.
+    if (from_disk && !original.isEmpty()) {
+        try {
+            html_resource->StoreText(original);
+        } catch (...) {
+            // The file is left as it is.
+        }
+    }
+}
+
+
 void UniversalUpdates::LoadAndUpdateOneCSSFile(CSSResource *css_resource,
         const QHash< QString, QString > &css_updates)
 {
@@ -255,7 +292,10 @@ void UniversalUpdates::LoadAndUpdateOneCSSFile(CSSResource *css_resource,
         return;
     }
 
-    const QString &source = Utility::ReadUnicodeTextFile(css_resource->GetFullPath());
+    // The importer may have already loaded the text from the archive.
+    const QString &source = css_resource->IsLoaded() ?
+                            css_resource->GetText() :
+                            Utility::ReadUnicodeTextFile(css_resource->GetFullPath());
     css_resource->SetText(PerformCSSUpdates(source, css_updates)());
 }
 
@@ -64,6 +64,8 @@ private:
                                             const QHash< QString, QString > &css_updates,
                                             const QList<XMLResource *> &non_well_formed=QList<XMLResource *>());
 
+    static void KeepOriginalHTML(HTMLResource *html_resource, const QString &original, bool from_disk);
+
     static QString UpdateOPFFile(OPFResource *opf_resource,
                                  const QHash< QString, QString > &xml_updates);
 
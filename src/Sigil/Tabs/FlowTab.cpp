@@ -40,6 +40,7 @@
 #include "Misc/SettingsStore.h"
 #include "Misc/Utility.h"
 #include "ResourceObjects/HTMLResource.h"
+#include "ResourceObjects/TextUpdateQueue.h"
 #include "sigil_constants.h"
 #include "Tabs/FlowTab.h"
 #include "Tabs/WellFormedCheckComponent.h"
@@ -81,6 +82,8 @@ FlowTab::FlowTab(HTMLResource &resource,
     // Loading a flow tab can take a while. We set the wait
     // cursor and clear it at the end of the delayed initialization.
     QApplication::setOverrideCursor(Qt::WaitCursor);
+    // The text of the resource may still be on disk only.
+    m_HTMLResource.InitialLoad();
 
     if (view_state == MainWindow::ViewState_BookView) {
         CreateBookViewIfRequired(false);
@@ -129,6 +132,9 @@ FlowTab::~FlowTab()
         delete(m_views);
         m_views = 0;
     }
+
+    // The resource only keeps a text document while a tab is editing it.
+    m_HTMLResource.ReleaseTextDocument();
 }
 
 void FlowTab::CreateBookViewIfRequired(bool is_delayed_load)
@@ -388,7 +394,10 @@ void FlowTab::SaveTabContent()
     }
 
     // Either from being in CV or saving from BV above we now reset the resource to say no user changes unsaved.
-    m_HTMLResource.GetTextDocumentForWriting().setModified(false);
+    // Only CV works on the resource's text document.
+    if (m_wCodeView) {
+        m_wCodeView->document()->setModified(false);
+    }
 }
 
 void FlowTab::ResourceModified()
@@ -409,6 +418,13 @@ void FlowTab::ResourceModified()
     EmitUpdatePreview();
 }
 
+void FlowTab::PendingResourcesUpdated(const QList< TextResource * > &resources)
+{
+    if (resources.contains(&m_HTMLResource)) {
+        ResourceModified();
+    }
+}
+
 void FlowTab::LinkedResourceModified()
 {
     QWebSettings::clearMemoryCaches();
@@ -1507,6 +1523,8 @@ void FlowTab::DelayedConnectSignalsToSlots()
     connect(&m_HTMLResource, SIGNAL(TextChanging()), this, SLOT(ResourceTextChanging()));
     connect(&m_HTMLResource, SIGNAL(LinkedResourceUpdated()), this, SLOT(LinkedResourceModified()));
     connect(&m_HTMLResource, SIGNAL(Modified()), this, SLOT(ResourceModified()));
+    connect(TextUpdateQueue::instance(), SIGNAL(ResourcesUpdated(const QList<TextResource *> &)),
+            this, SLOT(PendingResourcesUpdated(const QList<TextResource *> &)));
     connect(&m_HTMLResource, SIGNAL(LoadedFromDisk()), this, SLOT(ReloadTabIfPending()));
 }
 
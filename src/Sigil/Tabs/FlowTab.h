@@ -42,6 +42,7 @@ class BookViewEditor;
 class CodeViewEditor;
 class HTMLResource;
 class Resource;
+class TextResource;
 class ViewEditor;
 class WellFormedCheckComponent;
 
@@ -349,6 +350,10 @@ private slots:
     void ResourceModified();
     void LinkedResourceModified();
 
+    // Called when text updates queued from other threads have been applied.
+    // Our resource doesn't emit Modified() for those while it has no document.
+    void PendingResourcesUpdated(const QList< TextResource * > &resources);
+
     // Called when the underlying text inside the control is being replaced
     // Store our caret location as required.
     void ResourceTextChanging();
@@ -50,6 +50,13 @@ TextTab::TextTab(TextResource &resource,
 }
 
 
+TextTab::~TextTab()
+{
+    // The resource only keeps a text document while a tab is editing it.
+    m_TextResource.ReleaseTextDocument();
+}
+
+
 void TextTab::ScrollToLine(int line)
 {
     m_wCodeView.ScrollToLine(line);
@@ -28,6 +28,7 @@
 #include <QtWebKitWidgets/QWebFrame>
 
 #include "BookManipulation/XercesCppUse.h"
+#include "BookManipulation/XercesNames.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/Utility.h"
@@ -454,7 +455,7 @@ BookViewPreview::SearchTools BookViewPreview::GetSearchTools() const
     search_tools.fulltext = "";
     search_tools.document = XhtmlDoc::LoadTextIntoDocument(page()->mainFrame()->toHtml());
     QList< xc::DOMNode * > text_nodes = XhtmlDoc::GetVisibleTextNodes(
-                                            *(search_tools.document->getElementsByTagName(QtoX("body"))->item(0)));
+                                            *(search_tools.document->getElementsByTagName(xn::BODY)->item(0)));
     xc::DOMNode *current_block_ancestor = NULL;
 
     // We concatenate all text nodes that have the same
@@ -90,6 +90,8 @@ CodeViewEditor::CodeViewEditor(HighlighterType high_type, bool check_spelling, Q
     m_reformatCSSEnabled(false),
     m_reformatHTMLEnabled(false),
     m_lastFindRegex(QString()),
+    m_DocumentMatchesRevision(-1),
+    m_DocumentRevision(0),
     m_spellingMapper(new QSignalMapper(this)),
     m_addSpellingMapper(new QSignalMapper(this)),
     m_addDictMapper(new QSignalMapper(this)),
@@ -130,6 +132,7 @@ QSize CodeViewEditor::sizeHint() const
 void CodeViewEditor::CustomSetDocument(QTextDocument &document)
 {
     setDocument(&document);
+    m_DocumentRevision++;
     document.setModified(false);
 
     if (m_Highlighter) {
@@ -713,7 +716,9 @@ bool CodeViewEditor::FindNext(const QString &search_regex,
     SPCRE::MatchInfo match_info;
     int start_offset = 0;
     int start = 0;
-    int end = toPlainText().length();
+    // The document always ends with a paragraph separator
+    // that isn't part of the plain text.
+    int end = document()->characterCount() - 1;
     if (marked_text) {
         if (!MoveToMarkedText(search_direction, wrap)) {
             return false;
@@ -727,17 +732,21 @@ bool CodeViewEditor::FindNext(const QString &search_regex,
     if (search_direction == Searchable::Direction_Up) {
         if (misspelled_words) {
             match_info = GetMisspelledWord(toPlainText(), 0, selection_offset, search_regex, search_direction);
+        } else if (!marked_text) {
+            match_info = FindMatchInDocument(search_regex, selection_offset, search_direction);
         } else {
             match_info = spcre->getLastMatchInfo(Utility::Substring(start, selection_offset, toPlainText()));
         }
     } else {
         if (misspelled_words) {
             match_info = GetMisspelledWord(toPlainText(), selection_offset, toPlainText().count(), search_regex, search_direction);
+            start_offset = selection_offset;
+        } else if (!marked_text) {
+            match_info = FindMatchInDocument(search_regex, selection_offset, search_direction);
         } else {
             match_info = spcre->getFirstMatchInfo(Utility::Substring(selection_offset, end, toPlainText()));
+            start_offset = selection_offset;
         }
-
-        start_offset = selection_offset;
     }
 
     if (marked_text) {
@@ -894,31 +903,18 @@ int CodeViewEditor::ReplaceAll(const QString &search_regex,
     SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
     QList<SPCRE::MatchInfo> match_info = spcre->getEveryMatchInfo(text);
 
-    // Run though all match offsets making the replacement in reverse order.
-    // This way changes in text length won't change the offsets as we make
-    // our changes.
-    for (int i = match_info.count() - 1; i >= 0; i--) {
-        QString replaced_text;
-        if (!wrap) {
-            if (direction == Searchable::Direction_Up) {
-                if (match_info.at(i).offset.first > position) {
-                    break;
-                }
-            } else if (!wrap){
-                if (match_info.at(i).offset.second < position) {
-                    break;
-                }
+    if (!wrap) {
+        // Only the matches on the searched side of the cursor are replaced.
+        QList<SPCRE::MatchInfo> matches_in_direction;
+        foreach(const SPCRE::MatchInfo &match, match_info) {
+            if (direction == Searchable::Direction_Up ? match.offset.first <= position : match.offset.second >= position) {
+                matches_in_direction.append(match);
             }
         }
-
-        bool replacement_made = spcre->replaceText(Utility::Substring(match_info.at(i).offset.first, match_info.at(i).offset.second, text), match_info.at(i).capture_groups_offsets, replacement, replaced_text);
-
-        if (replacement_made) {
-            // Replace the text.
-            text = text.replace(match_info.at(i).offset.first, match_info.at(i).offset.second - match_info.at(i).offset.first, replaced_text);
-            count++;
-        }
+        match_info = matches_in_direction;
     }
+
+    text = spcre->replaceMatches(text, match_info, replacement, count);
     if (marked_text) {
         // Merge the replaced marked text into the original text and adjust the marker.
         QString replaced_text = toPlainText();
@@ -1823,6 +1819,8 @@ void CodeViewEditor::EmitFilteredCursorMoved()
 
 void CodeViewEditor::TextChangedFilter()
 {
+    m_DocumentRevision++;
+
     // Clear marked text to prevent marked area not matching entered text
     // if user types text, uses Undo, etc.
     if (!m_ReplacingInMarkedText && IsMarkedText()) {
@@ -2115,7 +2113,7 @@ int CodeViewEditor::GetSelectionOffset(Searchable::Direction search_direction, b
                 offset = m_MarkedTextEnd;
             }
             else {
-                offset = toPlainText().length();
+                offset = document()->characterCount() - 1;
             }
         }
         else {
@@ -2139,6 +2137,62 @@ int CodeViewEditor::GetSelectionOffset(Searchable::Direction search_direction, b
 }
 
 
+SPCRE::MatchInfo CodeViewEditor::FindMatchInDocument(const QString &search_regex, int position, Searchable::Direction search_direction)
+{
+    if (search_regex != m_DocumentMatchesRegex || m_DocumentMatchesRevision != m_DocumentRevision) {
+        m_DocumentMatches = PCRECache::instance()->getObject(search_regex)->getEveryMatchInfo(toPlainText());
+        m_DocumentMatchesRegex = search_regex;
+        m_DocumentMatchesRevision = m_DocumentRevision;
+    }
+
+    // The matches don't overlap, so they are sorted
+    // by where they end as well as by where they start.
+    int low = 0;
+    int high = m_DocumentMatches.count();
+
+    if (search_direction == Searchable::Direction_Up) {
+        while (low < high) {
+            int middle = (low + high) / 2;
+
+            if (m_DocumentMatches.at(middle).offset.second <= position) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        // With the position inside a cached match, the text before the
+        // position can still end with a match (like "123" for \d+ in
+        // "12345" searched from 3), so it has to be searched itself.
+        if (low < m_DocumentMatches.count() && m_DocumentMatches.at(low).offset.first < position) {
+            return PCRECache::instance()->getObject(search_regex)->getLastMatchInfo(toPlainText().left(position));
+        }
+
+        return low > 0 ? m_DocumentMatches.at(low - 1) : SPCRE::MatchInfo();
+    }
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+
+        if (m_DocumentMatches.at(middle).offset.first < position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // The cached matches don't overlap, so a match starting inside
+    // the previous one (like "234" for \d{3} in "12345" searched
+    // from 1) isn't among them. Only a search from the position
+    // itself can find it.
+    if (low > 0 && m_DocumentMatches.at(low - 1).offset.second > position) {
+        return PCRECache::instance()->getObject(search_regex)->getFirstMatchInfo(toPlainText(), position);
+    }
+
+    return low < m_DocumentMatches.count() ? m_DocumentMatches.at(low) : SPCRE::MatchInfo();
+}
+
+
 void CodeViewEditor::ScrollByLine(bool down)
 {
     int current_scroll_value = verticalScrollBar()->value();
@@ -568,6 +568,22 @@ private:
      */
     int GetSelectionOffset(Searchable::Direction search_direction, bool ignore_selection_offset, bool marked_text) const;
 
+    /**
+     * Finds the match of the regex closest to a position in the document.
+     * The matches are looked up in m_DocumentMatches, which is only
+     * rebuilt when the regex or the text changes. Searching from inside
+     * one of those matches runs the regex over the text after (down)
+     * or before (up) the position instead.
+     *
+     * @param search_regex The regex to match with.
+     * @param position The offset from the start of the document.
+     * @param search_direction Up returns the last match ending at or before
+     *                         the position, Down the first match starting
+     *                         at or after it.
+     * @return The match, with offsets from the start of the document.
+     */
+    SPCRE::MatchInfo FindMatchInDocument(const QString &search_regex, int position, Searchable::Direction search_direction);
+
     /**
      * Scrolls the whole screen by one line.
      * Used for ScrollOneLineUp and ScrollOneLineDown shortcuts.
@@ -798,6 +814,20 @@ private:
     SPCRE::MatchInfo m_lastMatch;
     QString m_lastFindRegex;
 
+    /**
+     * Every match of m_DocumentMatchesRegex in the document, in order, as of
+     * revision m_DocumentMatchesRevision. Repeated finds look matches up here
+     * instead of copying and searching the text again.
+     */
+    QList<SPCRE::MatchInfo> m_DocumentMatches;
+    QString m_DocumentMatchesRegex;
+    int m_DocumentMatchesRevision;
+
+    /**
+     * Incremented every time the text of the document changes.
+     */
+    int m_DocumentRevision;
+
     /**
      * Map spelling suggestion actions from the context menu to the
      * ReplaceSelected slot.
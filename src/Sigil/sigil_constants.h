@@ -51,6 +51,9 @@ extern const QString MISC_FOLDER_NAME;
 extern const QStringList IMAGE_MIMEYPES;
 extern const QStringList TEXT_MIMETYPES;
 extern const QStringList STYLE_MIMETYPES;
+extern const QStringList SVG_MIMETYPES;
+extern const QStringList AUDIO_MIMETYPES;
+extern const QStringList VIDEO_MIMETYPES;
 extern const QString SIGIL_TOC_ID_PREFIX;
 extern const QStringList HEADING_TAGS;
 extern const QString SIGIL_NOT_IN_TOC_CLASS;
@@ -68,6 +71,8 @@ extern const QStringList JPG_EXTENSIONS;
 extern const QStringList TIFF_EXTENSIONS;
 extern const QStringList VIDEO_EXTENSIONS;
 extern const QStringList AUDIO_EXTENSIONS;
+extern const QStringList STYLE_EXTENSIONS;
+extern const QStringList MISC_TEXT_EXTENSIONS;
 extern const QString ENCODING_ATTRIBUTE;
 extern const QString STANDALONE_ATTRIBUTE;
 extern const QString VERSION_ATTRIBUTE;
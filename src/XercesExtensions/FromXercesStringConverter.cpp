@@ -26,25 +26,39 @@ namespace XercesExt
 {
 
 FromXercesStringConverter::FromXercesStringConverter( const XMLCh* const xerces_string )
+    : m_Utf8String( NULL )
 {
-    if ( xerces_string && 
-         xc::XMLString::stringLen( xerces_string ) > 0 )
+    if ( !xerces_string || !*xerces_string )
+
+        return;
+
+    size_t i = 0;
+
+    for ( ; i < INLINE_LENGTH - 1 && xerces_string[ i ]; ++i )
     {
-        xc::TranscodeToStr transcoder( xerces_string, "UTF-8" );
+        if ( xerces_string[ i ] >= 0x80 )
 
-        m_Utf8String = (char*) transcoder.adopt();
+            break;
+
+        m_Buffer[ i ] = (char) xerces_string[ i ];
     }
 
-    else
+    if ( !xerces_string[ i ] )
     {
-        m_Utf8String = NULL;
+        m_Buffer[ i ] = 0;
+        m_Utf8String = m_Buffer;
+        return;
     }
+
+    xc::TranscodeToStr transcoder( xerces_string, "UTF-8" );
+
+    m_Utf8String = (char*) transcoder.adopt();
 }
 
 
 FromXercesStringConverter::~FromXercesStringConverter()
 {
-    if ( m_Utf8String )
+    if ( m_Utf8String && m_Utf8String != m_Buffer )
         
         xc::XMLString::release( &m_Utf8String );
 }
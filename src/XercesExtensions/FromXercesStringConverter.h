@@ -44,6 +44,17 @@ namespace XercesExt
 
     private:
 
+        // Not copyable, the string may point into the object itself.
+        FromXercesStringConverter( const FromXercesStringConverter& );
+        FromXercesStringConverter& operator=( const FromXercesStringConverter& );
+
+        /**
+         * Short ASCII strings are narrowed into this buffer
+         * instead of being transcoded into a heap allocated string.
+         */
+        enum { INLINE_LENGTH = 64 };
+        char m_Buffer[ INLINE_LENGTH ];
+
         char* m_Utf8String;
     };
 }
@@ -22,15 +22,7 @@
 #include <xercesc/internal/XMLScanner.hpp>
 #include <xercesc/dom/DOMNamedNodeMap.hpp>
 #include "LocationAwareDOMParser.h"
-#include "LocationInfoDataHandler.h"
-
-// This can't be a member variable of the parser since it needs to be around
-// even after the parser is destroyed. The cleanup methods of the parser's
-// super class call the handle() method of the handler.
-// We only ever need a single handler and a const one at that... this could
-// also easily go into a singleton, but this approach is simpler.
-static const XercesExt::LocationInfoDataHandler LOCATION_DATA_HANDLER;
-const char *LOCATION_INFO_KEY = "LocationInfoKey";
+
 typedef unsigned int uint; 
 
 namespace XercesExt
@@ -42,13 +34,29 @@ LocationAwareDOMParser::LocationAwareDOMParser( xc::XMLValidator   *const valToA
     :
     xc::XercesDOMParser( valToAdopt, manager, gramPool )
 {
-    m_LocationInfoKey = xc::XMLString::transcode( LOCATION_INFO_KEY );
 }
 
 
 LocationAwareDOMParser::~LocationAwareDOMParser()
 {
-    xc::XMLString::release( &m_LocationInfoKey );
+}
+
+
+void LocationAwareDOMParser::startDocument()
+{
+    xc::XercesDOMParser::startDocument();
+
+    // Whatever is left over comes from a parse that failed.
+    m_Locations.clear();
+}
+
+
+void LocationAwareDOMParser::endDocument()
+{
+    xc::XercesDOMParser::endDocument();
+
+    NodeLocationTable::Attach( *getDocument(), m_Locations );
+    m_Locations.clear();
 }
 
 
@@ -64,19 +72,10 @@ void LocationAwareDOMParser::startElement( const xc::XMLElementDecl &elemDecl,
             elemDecl, uriId, prefixName, attrList, attrCount, isEmpty, isRoot );
 
     const xc::Locator* locator = getScanner()->getLocator();
-    int line_number   = (int) locator->getLineNumber();
-    int column_number = (int) locator->getColumnNumber();
+    NodeLocationInfo location( (int) locator->getLineNumber(), (int) locator->getColumnNumber() );
 
     xc::DOMNode *current_node = getCurrentNode();
-
-    // It's OK to const_cast the handler since the parser will only ever
-    // call the handler's handle() method, which doesn't mutate the handler.
-    // In fact, this function not accepting a const handler is probably a design
-    // error on the part of Xerces developers.
-    current_node->setUserData( 
-        m_LocationInfoKey,
-        new NodeLocationInfo( line_number, column_number ),
-        const_cast< XercesExt::LocationInfoDataHandler* >( &LOCATION_DATA_HANDLER ) );
+    m_Locations.push_back( NodeLocationTable::Entry( current_node, location ) );
 
     // Attribute nodes get the same location as the opening tag
     // of the element they were declared in... it's the best we can do.
@@ -87,10 +86,7 @@ void LocationAwareDOMParser::startElement( const xc::XMLElementDecl &elemDecl,
 
     for ( uint i = 0; i < attribute_map->getLength(); ++i )
     {
-        attribute_map->item( i )->setUserData( 
-            m_LocationInfoKey,
-            new NodeLocationInfo( line_number, column_number ),
-            const_cast< XercesExt::LocationInfoDataHandler* >( &LOCATION_DATA_HANDLER ) );
+        m_Locations.push_back( NodeLocationTable::Entry( attribute_map->item( i ), location ) );
     }
 }
 
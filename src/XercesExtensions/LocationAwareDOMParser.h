@@ -23,9 +23,10 @@
 #ifndef LOCATIONAWAREDOMPARSER_H
 #define LOCATIONAWAREDOMPARSER_H
 
+#include <vector>
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/parsers/XercesDOMParser.hpp>
-#include "NodeLocationInfo.h"
+#include "NodeLocationTable.h"
 
 namespace xc = XERCES_CPP_NAMESPACE;
 
@@ -45,6 +46,12 @@ public:
       */
     ~LocationAwareDOMParser();
 
+    // override
+    void startDocument();
+
+    // override
+    void endDocument();
+
     // override
     void startElement( const xc::XMLElementDecl &elemDecl,
                        const unsigned int uriId,
@@ -55,7 +62,14 @@ public:
                        const bool isRoot );
 
 private:
-    XMLCh *m_LocationInfoKey;
+
+    /**
+     * The locations of the nodes of the document being parsed.
+     * They are moved into the document's location table once
+     * the whole document has been read. The vector keeps its
+     * storage from one document to the next.
+     */
+    std::vector< NodeLocationTable::Entry > m_Locations;
 };
 
 }
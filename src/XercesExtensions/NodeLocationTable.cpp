@@ -0,0 +1,124 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of FlightCrew.
+**
+**  FlightCrew is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU Lesser General Public License as published
+**  by the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  FlightCrew is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU Lesser General Public License for more details.
+**
+**  You should have received a copy of the GNU Lesser General Public License
+**  along with FlightCrew.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <new>
+#include <xercesc/dom/DOMDocument.hpp>
+#include <xercesc/dom/DOMMemoryManager.hpp>
+#include <xercesc/util/XMLUni.hpp>
+#include "NodeLocationTable.h"
+
+// The key the table is stored under, in the user data of the document.
+static const XMLCh LOCATION_TABLE_KEY[] =
+{
+    'N', 'o', 'd', 'e', 'L', 'o', 'c', 'a', 't', 'i', 'o', 'n', 'T', 'a', 'b', 'l', 'e', 0
+};
+
+static const size_t MIN_TABLE_SIZE = 16;
+
+namespace XercesExt
+{
+
+void NodeLocationTable::Attach( xc::DOMDocument &document, const std::vector< Entry > &entries )
+{
+    // Keep the table at most half full so the probe sequences stay short.
+    size_t size = MIN_TABLE_SIZE;
+
+    while ( size < entries.size() * 2 )
+    {
+        size *= 2;
+    }
+
+    xc::DOMMemoryManager *heap = static_cast< xc::DOMMemoryManager* >(
+        document.getFeature( xc::XMLUni::fgXercescInterfaceDOMMemoryManager, 0 ) );
+
+    // Neither the table nor the entries need a destructor,
+    // the document frees its heap when it's released.
+    Entry *slots = static_cast< Entry* >( heap->allocate( size * sizeof( Entry ) ) );
+
+    for ( size_t i = 0; i < size; ++i )
+    {
+        new ( slots + i ) Entry();
+    }
+
+    const size_t mask = size - 1;
+
+    for ( size_t i = 0; i < entries.size(); ++i )
+    {
+        size_t slot = Slot( entries[ i ].Node, mask );
+
+        while ( slots[ slot ].Node && slots[ slot ].Node != entries[ i ].Node )
+        {
+            slot = ( slot + 1 ) & mask;
+        }
+
+        slots[ slot ] = entries[ i ];
+    }
+
+    NodeLocationTable *table = new ( heap->allocate( sizeof( NodeLocationTable ) ) )
+        NodeLocationTable( slots, mask );
+
+    document.setUserData( LOCATION_TABLE_KEY, table, 0 );
+}
+
+
+const NodeLocationTable* NodeLocationTable::ForNode( const xc::DOMNode &node )
+{
+    const xc::DOMDocument *document = node.getNodeType() == xc::DOMNode::DOCUMENT_NODE ?
+                                      static_cast< const xc::DOMDocument* >( &node ) :
+                                      node.getOwnerDocument();
+
+    if ( !document )
+
+        return 0;
+
+    return static_cast< const NodeLocationTable* >( document->getUserData( LOCATION_TABLE_KEY ) );
+}
+
+
+NodeLocationInfo NodeLocationTable::Find( const xc::DOMNode &node ) const
+{
+    size_t slot = Slot( &node, m_Mask );
+
+    while ( m_Entries[ slot ].Node )
+    {
+        if ( m_Entries[ slot ].Node == &node )
+
+            return m_Entries[ slot ].Location;
+
+        slot = ( slot + 1 ) & m_Mask;
+    }
+
+    return NodeLocationInfo();
+}
+
+
+size_t NodeLocationTable::Slot( const xc::DOMNode *node, size_t mask )
+{
+    // The low bits of the pointers are always the same
+    // because of alignment, so they are mixed in.
+    size_t key = reinterpret_cast< size_t >( node );
+    key ^= key >> 4;
+    key *= 0x9E3779B1u;
+    key ^= key >> 16;
+    return key & mask;
+}
+
+}
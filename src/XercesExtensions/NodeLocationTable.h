@@ -0,0 +1,94 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 agent <agent@local>
+**
+**  This file is part of FlightCrew.
+**
+**  FlightCrew is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU Lesser General Public License as published
+**  by the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  FlightCrew is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU Lesser General Public License for more details.
+**
+**  You should have received a copy of the GNU Lesser General Public License
+**  along with FlightCrew.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef NODELOCATIONTABLE_H
+#define NODELOCATIONTABLE_H
+
+#include <vector>
+#include <xercesc/util/XercesDefs.hpp>
+#include "NodeLocationInfo.h"
+
+namespace XERCES_CPP_NAMESPACE { class DOMDocument; class DOMNode; }
+namespace xc = XERCES_CPP_NAMESPACE;
+
+namespace XercesExt
+{
+
+/**
+ * Maps the nodes of a parsed document to their locations
+ * in the source. The table is allocated on the document's own heap,
+ * so it goes away in one shot together with the document.
+ * The lookups use open addressing on the node pointers.
+ */
+class NodeLocationTable
+{
+public:
+
+    struct Entry
+    {
+        Entry()
+            : Node( 0 ) {}
+        Entry( const xc::DOMNode *node, const NodeLocationInfo &location )
+            : Node( node ), Location( location ) {}
+
+        const xc::DOMNode *Node;
+        NodeLocationInfo Location;
+    };
+
+    /**
+     * Builds the table from the recorded locations and
+     * attaches it to the document.
+     *
+     * @param document The document the nodes belong to.
+     * @param entries The locations of the nodes.
+     */
+    static void Attach( xc::DOMDocument &document, const std::vector< Entry > &entries );
+
+    /**
+     * Returns the table of the document the node belongs to.
+     *
+     * @param node Any node of the document, or the document itself.
+     * @return The table, or NULL if the document has none.
+     */
+    static const NodeLocationTable* ForNode( const xc::DOMNode &node );
+
+    /**
+     * Returns the location of the node. Nodes that were
+     * not parsed from the source have no location.
+     */
+    NodeLocationInfo Find( const xc::DOMNode &node ) const;
+
+private:
+
+    // Tables are only created by Attach().
+    NodeLocationTable( Entry *entries, size_t mask )
+        : m_Entries( entries ), m_Mask( mask ) {}
+
+    static size_t Slot( const xc::DOMNode *node, size_t mask );
+
+    Entry *m_Entries;
+    size_t m_Mask;
+};
+
+}
+
+#endif // NODELOCATIONTABLE_H
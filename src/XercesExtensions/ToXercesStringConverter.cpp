@@ -27,53 +27,59 @@ namespace XercesExt
 
 ToXercesStringConverter::ToXercesStringConverter( const std::string &utf8_string )
 {
-    if ( utf8_string.length() > 0 )
-    {
-        xc::TranscodeFromStr transcoder( 
-            (const XMLByte*) utf8_string.c_str(), utf8_string.length(), "UTF-8" );
+    Convert( utf8_string.c_str(), utf8_string.length() );
+}
 
-        m_XercesString = transcoder.adopt();
-    }
 
-    else
-    {
-        m_XercesString = NULL;
-    }
+ToXercesStringConverter::ToXercesStringConverter( const char* const utf8_string )
+{
+    Convert( utf8_string, utf8_string ? strlen( utf8_string ) : 0 );
 }
 
 
-ToXercesStringConverter::ToXercesStringConverter( const char* const utf8_string )
+ToXercesStringConverter::~ToXercesStringConverter()
+{
+    if ( m_XercesString && m_XercesString != m_Buffer )
+    
+        xc::XMLString::release( &m_XercesString );
+}
+
+
+void ToXercesStringConverter::Convert( const char *utf8_string, size_t string_length )
 {
-    if ( utf8_string )
+    if ( string_length == 0 )
+    {
+        m_XercesString = NULL;
+        return;
+    }
+
+    if ( string_length < INLINE_LENGTH )
     {
-        size_t string_length = strlen( utf8_string );
+        size_t i = 0;
 
-        if ( string_length > 0 )
+        // ASCII is the same in UTF-8 and UTF-16
+        // except for the width of the characters.
+        for ( ; i < string_length; ++i )
         {
-            xc::TranscodeFromStr transcoder( 
-                (const XMLByte*) utf8_string, string_length, "UTF-8" );
+            if ( (unsigned char) utf8_string[ i ] >= 0x80 )
+
+                break;
 
-            m_XercesString = transcoder.adopt();
+            m_Buffer[ i ] = (XMLCh) utf8_string[ i ];
         }
 
-        else
+        if ( i == string_length )
         {
-            m_XercesString = NULL;
+            m_Buffer[ i ] = 0;
+            m_XercesString = m_Buffer;
+            return;
         }
     }
 
-    else
-    {
-        m_XercesString = NULL;
-    }
-}
+    xc::TranscodeFromStr transcoder( 
+        (const XMLByte*) utf8_string, string_length, "UTF-8" );
 
-
-ToXercesStringConverter::~ToXercesStringConverter()
-{
-    if ( m_XercesString )
-    
-        xc::XMLString::release( &m_XercesString );
+    m_XercesString = transcoder.adopt();
 }
 
 
@@ -45,6 +45,20 @@ public:
 
 private:
 
+    // Not copyable, the string may point into the object itself.
+    ToXercesStringConverter( const ToXercesStringConverter& );
+    ToXercesStringConverter& operator=( const ToXercesStringConverter& );
+
+    void Convert( const char *utf8_string, size_t string_length );
+
+    /**
+     * Short ASCII strings, like most tag and attribute names,
+     * are widened into this buffer instead of being transcoded
+     * into a heap allocated string.
+     */
+    enum { INLINE_LENGTH = 64 };
+    XMLCh m_Buffer[ INLINE_LENGTH ];
+
     XMLCh* m_XercesString;
 };
 
@@ -20,6 +20,7 @@
 *************************************************************************/
 
 #include "XmlUtils.h"
+#include "NodeLocationTable.h"
 #include "ToXercesStringConverter.h"
 #include "FromXercesStringConverter.h"
 #include <xercesc/dom/DOMElement.hpp>
@@ -30,8 +31,6 @@
 #include <boost/foreach.hpp> 
 #define foreach BOOST_FOREACH
 
-extern const char *LOCATION_INFO_KEY;
-
 typedef unsigned int uint;
 
 namespace XercesExt
@@ -39,12 +38,11 @@ namespace XercesExt
 
 NodeLocationInfo GetNodeLocationInfo( const xc::DOMNode &node )
 {
-    NodeLocationInfo *location = static_cast< NodeLocationInfo* >(
-        node.getUserData( toX( LOCATION_INFO_KEY ) ) );
+    const NodeLocationTable *table = NodeLocationTable::ForNode( node );
 
-    if ( location )
+    if ( table )
 
-        return *location;
+        return table->Find( node );
     
     return NodeLocationInfo();
 }
@@ -52,26 +50,24 @@ NodeLocationInfo GetNodeLocationInfo( const xc::DOMNode &node )
 
 XercesExt::NodeLocationInfo GetNearestNodeLocationInfo( const xc::DOMNode &node )
 {
-    const xc::DOMNode *current_node = &node;
+    const NodeLocationTable *table = NodeLocationTable::ForNode( node );
     NodeLocationInfo location;
 
-    while ( true )
+    if ( !table )
+
+        return location;
+
+    const xc::DOMNode *current_node = &node;
+
+    while ( current_node )
     {
-        location = GetNodeLocationInfo( *current_node );
+        location = table->Find( *current_node );
 
         if ( location.LineNumber != -1 )
-        {
-            break;                        
-        }
-
-        else
-        {
-            current_node = current_node->getParentNode();
 
-            if ( !current_node )
+            break;
 
-                break;   
-        }        
+        current_node = current_node->getParentNode();
     }
 
     return location;